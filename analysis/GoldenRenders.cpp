@@ -0,0 +1,201 @@
+#include "GoldenRenders.h"
+
+namespace Analysis
+{
+    namespace
+    {
+        constexpr const char* foldTypeNames[] = { "FoldToRange", "SinFold", "ComboFold" };
+
+        juce::File getCaseFile (const juce::File& folder, const juce::String& name)
+        {
+            return folder.getChildFile (name + ".wav");
+        }
+
+        /** Empty if the file is missing or isn't numSamples of mono audio at this rate. */
+        juce::AudioBuffer<float> readCaseFile (const juce::File& file, int numSamples, double sampleRate)
+        {
+            juce::WavAudioFormat format;
+            std::unique_ptr<juce::AudioFormatReader> reader;
+
+            if (auto stream = file.createInputStream())
+                reader.reset (format.createReaderFor (stream.release(), true));
+
+            if (reader == nullptr || reader->numChannels != 1 || (int) reader->lengthInSamples != numSamples || reader->sampleRate != sampleRate)
+                return {};
+
+            juce::AudioBuffer<float> buffer (1, numSamples);
+            reader->read (&buffer, 0, numSamples, 0, true, false);
+            return buffer;
+        }
+
+        double getPeakDifferenceDb (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+        {
+            float maxError = 0.0f;
+
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                maxError = juce::jmax (maxError, std::abs (a.getSample (0, i) - b.getSample (0, i)));
+
+            return juce::Decibels::gainToDecibels ((double) maxError, -200.0);
+        }
+    }
+
+    //==============================================================================
+    GoldenRenders::GoldenRenders (double rate) : sampleRate (rate)
+    {
+        const int numSweepSamples = juce::roundToInt (sweepSeconds * sampleRate);
+        const int numChordSamples = juce::roundToInt (chordSeconds * sampleRate);
+        input.setSize (1, numSweepSamples + numChordSamples);
+
+        auto* data = input.getWritePointer (0);
+        const double startFrequency = 20.0, endFrequency = 20000.0;
+        const double sweepRate = std::log (endFrequency / startFrequency) / sweepSeconds;
+
+        for (int i = 0; i < numSweepSamples; ++i)
+        {
+            // Phase of an exponential sweep, the integral of f0 e^(sweepRate t)
+            const double t = i / sampleRate;
+            const double phase = juce::MathConstants<double>::twoPi * startFrequency * (std::exp (sweepRate * t) - 1.0) / sweepRate;
+            data[i] = (float) (0.8 * std::sin (phase));
+        }
+
+        for (int i = 0; i < numChordSamples; ++i)
+        {
+            const double t = i / sampleRate;
+            double sample = 0.0;
+
+            for (const double frequency : { 220.0, 277.18, 329.63 })
+                sample += 0.25 * std::sin (juce::MathConstants<double>::twoPi * frequency * t);
+
+            data[numSweepSamples + i] = (float) sample;
+        }
+    }
+
+    std::vector<GoldenRenders::Case> GoldenRenders::getCases()
+    {
+        // Every kernel path once: exact, both ADAA orders, oversampled, the lookup table
+        const ProcessorConfig settings[] = { { 0, 0, 0, false }, { 0, 1, 0, false }, { 0, 2, 0, false },
+                                             { 0, 0, 2, false }, { 0, 1, 1, false }, { 0, 0, 0, true } };
+        std::vector<Case> cases;
+
+        for (int type = 0; type < 3; ++type)
+        {
+            for (auto config : settings)
+            {
+                config.foldType = type;
+
+                for (const bool doublePrecision : { false, true })
+                {
+                    const auto name = juce::String (foldTypeNames[type]) + "_" + config.getSettingName().replaceCharacter (' ', '_')
+                                    + (doublePrecision ? "_double" : "_float");
+
+                    cases.push_back ({ name, config, {}, doublePrecision });
+                }
+            }
+        }
+
+        return cases;
+    }
+
+    juce::AudioBuffer<float> GoldenRenders::render (const Case& renderCase) const
+    {
+        auto processor = QualityAnalyzer::makeProcessor (renderCase.config, renderCase.scenario, sampleRate,
+                                                         QualityAnalyzer::renderBlockSize, renderCase.doublePrecision);
+        juce::AudioBuffer<float> output;
+        output.makeCopyOf (input);
+
+        if (renderCase.doublePrecision)
+        {
+            juce::AudioBuffer<double> buffer;
+            buffer.makeCopyOf (input);
+            QualityAnalyzer::process (*processor, buffer, QualityAnalyzer::renderBlockSize);
+            output.makeCopyOf (buffer);
+        }
+        else
+        {
+            QualityAnalyzer::process (*processor, output, QualityAnalyzer::renderBlockSize);
+        }
+
+        return output;
+    }
+
+    //==============================================================================
+    juce::Result GoldenRenders::write (const juce::File& folder) const
+    {
+        if (auto result = folder.createDirectory(); result.failed())
+            return result;
+
+        juce::WavAudioFormat format;
+
+        for (const auto& renderCase : getCases())
+        {
+            const auto output = render (renderCase);
+            const auto file = getCaseFile (folder, renderCase.name);
+
+            file.deleteFile();
+            auto stream = file.createOutputStream();
+
+            if (stream == nullptr)
+                return juce::Result::fail ("Can't write " + file.getFullPathName());
+
+            std::unique_ptr<juce::OutputStream> outputStream (std::move (stream));
+            std::unique_ptr<juce::AudioFormatWriter> writer (format.createWriterFor (outputStream.get(), sampleRate, 1, 32, {}, 0));
+
+            if (writer == nullptr)
+                return juce::Result::fail ("Can't write " + file.getFullPathName());
+
+            // The writer owns the stream once it was created
+            outputStream.release();
+
+            if (! writer->writeFromAudioSampleBuffer (output, 0, output.getNumSamples()))
+                return juce::Result::fail ("Write error: " + file.getFullPathName());
+        }
+
+        return juce::Result::ok();
+    }
+
+    juce::Result GoldenRenders::check (const juce::File& folder, double toleranceDb, juce::Array<juce::var>& report) const
+    {
+        juce::StringArray failures;
+
+        for (const auto& renderCase : getCases())
+        {
+            juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+            entry->setProperty ("case", renderCase.name);
+            report.add (entry.get());
+
+            const auto golden = readCaseFile (getCaseFile (folder, renderCase.name), input.getNumSamples(), sampleRate);
+
+            if (golden.getNumSamples() == 0)
+            {
+                entry->setProperty ("status", "missing");
+                failures.add (renderCase.name + ": no matching golden file");
+                continue;
+            }
+
+            const auto output = render (renderCase);
+            const double errorDb = getPeakDifferenceDb (output, golden);
+            const bool passed = errorDb <= toleranceDb;
+
+            entry->setProperty ("max_error_db", errorDb);
+            entry->setProperty ("status", passed ? "passed" : "failed");
+
+            if (! passed)
+                failures.add (renderCase.name + ": off by " + juce::String (errorDb, 1) + " dBFS");
+
+            // How far the float path is from the double one, for information only
+            if (! renderCase.doublePrecision)
+            {
+                const auto reference = readCaseFile (getCaseFile (folder, renderCase.name.replace ("_float", "_double")),
+                                                     input.getNumSamples(), sampleRate);
+
+                if (reference.getNumSamples() > 0)
+                    entry->setProperty ("error_vs_double_db", getPeakDifferenceDb (output, reference));
+            }
+        }
+
+        if (failures.isEmpty())
+            return juce::Result::ok();
+
+        return juce::Result::fail (failures.joinIntoString ("\n"));
+    }
+}
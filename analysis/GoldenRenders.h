@@ -0,0 +1,49 @@
+#pragma once
+
+#include "QualityAnalyzer.h"
+
+namespace Analysis
+{
+    //==============================================================================
+    /** Regression renders: fixed settings run on a fixed signal, written once from a build
+        known to be right and compared against after every kernel change.
+
+        The signal is an exponential sine sweep from 20 Hz to 20 kHz followed by a three
+        tone chord. Each case is rendered in both precisions, since the float and double
+        kernels are separate code, and stored as a mono 32-bit float WAV file named after
+        the case, e.g. "SinFold_ADAA1_1x_float.wav". A comparison reports the peak
+        difference in dBFS, and for the float cases also how far they are from the double
+        precision golden render, the closest thing to the exact chain.
+    */
+    class GoldenRenders
+    {
+    public:
+        explicit GoldenRenders (double sampleRate);
+
+        /** Writes every case into the folder, replacing what's there. */
+        juce::Result write (const juce::File& folder) const;
+
+        /** Renders every case again and compares it with its file. Fails if a file is
+            missing or differs by more than toleranceDb anywhere. One entry per case is
+            added to the report. */
+        juce::Result check (const juce::File& folder, double toleranceDb, juce::Array<juce::var>& report) const;
+
+    private:
+        struct Case
+        {
+            juce::String name;
+            ProcessorConfig config;
+            Scenario scenario;
+            bool doublePrecision = false;
+        };
+
+        static std::vector<Case> getCases();
+        juce::AudioBuffer<float> render (const Case& renderCase) const;
+
+        double sampleRate;
+        juce::AudioBuffer<float> input;
+
+        static constexpr double sweepSeconds = 0.75;
+        static constexpr double chordSeconds = 0.25;
+    };
+}
@@ -0,0 +1,286 @@
+/*  Headless quality vs CPU analysis of the anti-aliasing settings.
+
+        WavefolderAnalysis [--quick] [--output=quality.json] [--sample-rate=48000] [--min-time-ms=20]
+        WavefolderAnalysis --write-golden=<folder>
+        WavefolderAnalysis --check-golden=<folder> [--tolerance-db=-100]
+
+    For every fold type and every AA mode / oversampling factor / LUT setting, the processor
+    is driven at several drive & threshold settings with a stepped sine sweep (one steady
+    tone per frequency) and a three tone chord, and measured by FFT (see QualityAnalyzer):
+      - aliasing:  power folded back from above Nyquist, against the band-limited output
+      - THD+N:     everything but the tones and DC, against the tones
+      - DC:        output offset in dBFS
+    The same settings are timed on the chord, in ns per sample of 512 sample blocks.
+
+    The table printed per fold type has one row per setting, sorted by cost, and marks the
+    Pareto front on the worst aliasing: no faster setting aliases less. The JSON output has
+    every single measurement.
+
+    --write-golden renders the regression cases into a folder (see GoldenRenders), from a
+    build known to be right. --check-golden renders them again and compares, exiting with 1
+    if any differs by more than the tolerance.
+*/
+
+#include "GoldenRenders.h"
+
+#include <iostream>
+
+namespace
+{
+    constexpr const char* foldTypeNames[] = { "FoldToRange", "SinFold", "ComboFold" };
+
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        double minSecondsPerRun = 0.02;
+        int numRuns = 5;
+        bool quick = false;
+    };
+
+    std::vector<Analysis::ProcessorConfig> getConfigs (const Settings& settings)
+    {
+        std::vector<Analysis::ProcessorConfig> configs;
+        const int numFactors = settings.quick ? 3 : FoldDSP::Oversampler::numFactors;
+
+        for (int os = 0; os < numFactors; ++os)
+        {
+            for (int aa = 0; aa < 3; ++aa)
+                configs.push_back ({ 0, aa, os, false });
+
+            // The table replaces the exact kernels, it is never combined with ADAA
+            configs.push_back ({ 0, 0, os, true });
+        }
+
+        return configs;
+    }
+
+    std::vector<Analysis::Scenario> getScenarios (const Settings& settings)
+    {
+        if (settings.quick)
+            return { { 18.0f, 0.7f } };
+
+        return { { 6.0f, 0.3f }, { 6.0f, 0.7f }, { 18.0f, 0.3f }, { 18.0f, 0.7f }, { 30.0f, 0.3f }, { 30.0f, 0.7f } };
+    }
+
+    std::vector<Analysis::TestSignal> getSignals (const Analysis::QualityAnalyzer& analyzer, const Settings& settings)
+    {
+        const std::vector<double> sweep = settings.quick ? std::vector<double> { 1000.0, 6000.0, 15000.0 }
+                                                         : std::vector<double> { 50.0, 100.0, 200.0, 500.0, 1000.0,
+                                                                                 2000.0, 4000.0, 8000.0, 12000.0, 16000.0 };
+        std::vector<Analysis::TestSignal> signals;
+
+        for (const auto frequency : sweep)
+        {
+            const int bin = analyzer.getBin (frequency);
+            signals.push_back ({ "sine " + juce::String (analyzer.getFrequency (bin), 1) + " Hz", { bin }, 0.5 });
+        }
+
+        signals.push_back ({ "chord", { analyzer.getBin (440.0), analyzer.getBin (1330.0), analyzer.getBin (3520.0) }, 0.25 });
+        return signals;
+    }
+
+    //==============================================================================
+    struct SettingResult
+    {
+        Analysis::ProcessorConfig config;
+        double nsPerSample = 0.0;
+        double worstAliasingDb = -300.0, meanAliasingDb = 0.0;
+        double thdnDb = 0.0;                     // 1 kHz tone, mean over the scenarios
+        double maxDcOffsetDb = -200.0;
+        bool pareto = false;
+        juce::Array<juce::var> measurements;
+    };
+
+    SettingResult analyseSetting (Analysis::QualityAnalyzer& analyzer, const Analysis::ProcessorConfig& config,
+                                  const std::vector<Analysis::Scenario>& scenarios, const std::vector<Analysis::TestSignal>& signals,
+                                  const Settings& settings)
+    {
+        SettingResult result;
+        result.config = config;
+
+        const auto reference = analyzer.getBin (1000.0);
+        double aliasingSum = 0.0, thdnSum = 0.0;
+        int numThdn = 0;
+
+        for (const auto& scenario : scenarios)
+        {
+            for (const auto& signal : signals)
+            {
+                const auto metrics = analyzer.measure (config, scenario, signal);
+
+                result.worstAliasingDb = juce::jmax (result.worstAliasingDb, metrics.aliasingDb);
+                result.maxDcOffsetDb = juce::jmax (result.maxDcOffsetDb, metrics.dcOffsetDb);
+                aliasingSum += metrics.aliasingDb;
+
+                if (signal.bins.size() == 1 && signal.bins.front() == reference)
+                {
+                    thdnSum += metrics.thdnDb;
+                    ++numThdn;
+                }
+
+                juce::DynamicObject::Ptr measurement = new juce::DynamicObject();
+                measurement->setProperty ("drive_db", scenario.driveDb);
+                measurement->setProperty ("threshold", scenario.threshold);
+                measurement->setProperty ("signal", signal.name);
+                measurement->setProperty ("aliasing_db", metrics.aliasingDb);
+                measurement->setProperty ("thdn_db", metrics.thdnDb);
+                measurement->setProperty ("dc_offset_db", metrics.dcOffsetDb);
+                result.measurements.add (measurement.get());
+            }
+        }
+
+        result.meanAliasingDb = aliasingSum / (double) (scenarios.size() * signals.size());
+        result.thdnDb = numThdn > 0 ? thdnSum / numThdn : 0.0;
+
+        // Timed on the chord at the middle setting
+        result.nsPerSample = analyzer.measureNanosecondsPerSample (config, scenarios[scenarios.size() / 2], signals.back(),
+                                                                   Analysis::QualityAnalyzer::renderBlockSize,
+                                                                   settings.numRuns, settings.minSecondsPerRun);
+        return result;
+    }
+
+    /** Sorts by cost and marks the settings no faster one beats on worst aliasing. */
+    void markParetoFront (std::vector<SettingResult>& results)
+    {
+        std::sort (results.begin(), results.end(), [] (const auto& a, const auto& b) { return a.nsPerSample < b.nsPerSample; });
+
+        double best = std::numeric_limits<double>::infinity();
+
+        for (auto& result : results)
+        {
+            result.pareto = result.worstAliasingDb < best;
+            best = juce::jmin (best, result.worstAliasingDb);
+        }
+    }
+
+    void printTable (const juce::String& foldType, const std::vector<SettingResult>& results)
+    {
+        std::cout << std::endl << foldType << std::endl
+                  << "    Setting        ns/sample   Aliasing worst   mean   THD+N 1k    DC max" << std::endl;
+
+        for (const auto& result : results)
+        {
+            std::cout << juce::String::formatted ("  %c %-14s %9.2f %16.1f %7.1f %10.1f %9.1f",
+                                                  result.pareto ? '*' : ' ', result.config.getSettingName().toRawUTF8(),
+                                                  result.nsPerSample, result.worstAliasingDb, result.meanAliasingDb,
+                                                  result.thdnDb, result.maxDcOffsetDb)
+                      << std::endl;
+        }
+    }
+
+    juce::var toJson (const juce::String& foldType, const SettingResult& result)
+    {
+        juce::DynamicObject::Ptr json = new juce::DynamicObject();
+        json->setProperty ("fold_type", foldType);
+        json->setProperty ("setting", result.config.getSettingName());
+        json->setProperty ("aa_mode", result.config.aaMode);
+        json->setProperty ("oversampling", result.config.getOversamplingFactor());
+        json->setProperty ("lut", result.config.lut);
+        json->setProperty ("ns_per_sample", result.nsPerSample);
+        json->setProperty ("worst_aliasing_db", result.worstAliasingDb);
+        json->setProperty ("mean_aliasing_db", result.meanAliasingDb);
+        json->setProperty ("thdn_1k_db", result.thdnDb);
+        json->setProperty ("max_dc_offset_db", result.maxDcOffsetDb);
+        json->setProperty ("pareto", result.pareto);
+        json->setProperty ("measurements", result.measurements);
+        return json.get();
+    }
+
+    juce::File getFolderOption (const juce::ArgumentList& args, const juce::String& option)
+    {
+        return juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption (option).unquoted());
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    Settings settings;
+    settings.quick = args.containsOption ("--quick");
+
+    if (settings.quick)
+        settings.numRuns = 3;
+
+    if (args.containsOption ("--sample-rate"))
+        settings.sampleRate = juce::jmax (8000.0, args.getValueForOption ("--sample-rate").getDoubleValue());
+
+    if (args.containsOption ("--min-time-ms"))
+        settings.minSecondsPerRun = juce::jmax (1, args.getValueForOption ("--min-time-ms").getIntValue()) / 1000.0;
+
+    // Golden renders only
+    if (args.containsOption ("--write-golden"))
+    {
+        const auto folder = getFolderOption (args, "--write-golden");
+
+        if (auto result = Analysis::GoldenRenders (settings.sampleRate).write (folder); result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        std::cout << "Golden renders written to " << folder.getFullPathName() << std::endl;
+        return 0;
+    }
+
+    if (args.containsOption ("--check-golden"))
+    {
+        const double toleranceDb = args.containsOption ("--tolerance-db") ? args.getValueForOption ("--tolerance-db").getDoubleValue() : -100.0;
+        juce::Array<juce::var> report;
+        const auto result = Analysis::GoldenRenders (settings.sampleRate).check (getFolderOption (args, "--check-golden"), toleranceDb, report);
+
+        std::cout << juce::JSON::toString (report) << std::endl;
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // Quality vs CPU
+    Analysis::QualityAnalyzer analyzer (settings.sampleRate, settings.quick ? 14 : 16);
+    const auto scenarios = getScenarios (settings);
+    const auto signals = getSignals (analyzer, settings);
+
+    juce::Array<juce::var> results;
+
+    for (int type = 0; type < 3; ++type)
+    {
+        std::vector<SettingResult> settingResults;
+
+        for (auto config : getConfigs (settings))
+        {
+            config.foldType = type;
+            settingResults.push_back (analyseSetting (analyzer, config, scenarios, signals, settings));
+        }
+
+        markParetoFront (settingResults);
+        printTable (foldTypeNames[type], settingResults);
+
+        for (const auto& result : settingResults)
+            results.add (toJson (foldTypeNames[type], result));
+    }
+
+    if (args.containsOption ("--output"))
+    {
+        juce::DynamicObject::Ptr report = new juce::DynamicObject();
+        report->setProperty ("sample_rate", settings.sampleRate);
+        report->setProperty ("fft_size", analyzer.getFftSize());
+        report->setProperty ("results", results);
+
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--output"));
+
+        if (! file.replaceWithText (juce::JSON::toString (juce::var (report.get()))))
+        {
+            std::cerr << "Could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,279 @@
+#include "QualityAnalyzer.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace Analysis
+{
+    namespace
+    {
+        constexpr const char* aaModeNames[] = { "Off", "ADAA1", "ADAA2" };
+
+        double powerToDecibels (double power)
+        {
+            return 10.0 * std::log10 (juce::jmax (power, 1.0e-30));
+        }
+
+        void setParameter (WavefolderProcessor& processor, const char* id, float value)
+        {
+            auto* param = processor.apvts.getParameter (id);
+            param->setValueNotifyingHost (param->convertTo0to1 (value));
+        }
+
+        /** The table is baked in the background and the processor uses the exact path until
+            it's ready. Feed silence until it has been picked up, so what's measured doesn't
+            depend on thread timing. */
+        bool waitForLookupTable (WavefolderProcessor& processor, int blockSize)
+        {
+            juce::AudioBuffer<float> silence (processor.getTotalNumOutputChannels(), blockSize);
+            juce::MidiBuffer midi;
+            const auto timeout = juce::Time::getMillisecondCounter() + 10000;
+
+            while (! processor.isLutReady() && juce::Time::getMillisecondCounter() < timeout)
+            {
+                silence.clear();
+                processor.processBlock (silence, midi);
+                juce::Thread::sleep (1);
+            }
+
+            silence.clear();
+            processor.processBlock (silence, midi);
+            return processor.isLutReady();
+        }
+    }
+
+    //==============================================================================
+    juce::String ProcessorConfig::getSettingName() const
+    {
+        return juce::String (aaModeNames[aaMode]) + " " + juce::String (getOversamplingFactor()) + "x" + (lut ? " LUT" : "");
+    }
+
+    juce::String Scenario::getName() const
+    {
+        return juce::String (driveDb, 0) + " dB, threshold " + juce::String (threshold, 2);
+    }
+
+    //==============================================================================
+    QualityAnalyzer::QualityAnalyzer (double rate, int fftOrder)
+        : sampleRate (rate), fftSize (1 << fftOrder), spectrum ((size_t) fftSize), twiddles ((size_t) fftSize / 2)
+    {
+        for (size_t k = 0; k < twiddles.size(); ++k)
+            twiddles[k] = std::polar (1.0, -juce::MathConstants<double>::twoPi * (double) k / (double) fftSize);
+    }
+
+    int QualityAnalyzer::getBin (double frequency) const noexcept
+    {
+        const int bin = juce::roundToInt (frequency * fftSize / sampleRate / gridStep) * gridStep;
+        return juce::jlimit (gridStep, (fftSize / 2 - 1) / gridStep * gridStep, bin);
+    }
+
+    juce::AudioBuffer<float> QualityAnalyzer::makeFrame (const TestSignal& signal) const
+    {
+        juce::AudioBuffer<float> frame (1, fftSize);
+        auto* data = frame.getWritePointer (0);
+
+        for (int i = 0; i < fftSize; ++i)
+        {
+            double sample = 0.0;
+
+            // Phase taken modulo the frame, exact whatever the bin
+            for (const int bin : signal.bins)
+                sample += signal.amplitude * std::sin (juce::MathConstants<double>::twoPi * (double) (((juce::int64) bin * i) % fftSize) / fftSize);
+
+            data[i] = (float) sample;
+        }
+
+        return frame;
+    }
+
+    //==============================================================================
+    QualityMetrics QualityAnalyzer::measure (const ProcessorConfig& config, const Scenario& scenario, const TestSignal& signal)
+    {
+        auto processor = makeProcessor (config, scenario, sampleRate, renderBlockSize);
+        const auto frame = makeFrame (signal);
+
+        // Whole frames, the last one is analysed
+        const int numSettleFrames = juce::jmax (1, (int) std::ceil (settleSeconds * sampleRate / fftSize));
+        juce::AudioBuffer<float> buffer (1, fftSize);
+
+        for (int f = 0; f <= numSettleFrames; ++f)
+        {
+            buffer.makeCopyOf (frame, true);
+            process (*processor, buffer, renderBlockSize);
+        }
+
+        return analyse (buffer.getReadPointer (0), signal);
+    }
+
+    QualityMetrics QualityAnalyzer::analyse (const float* output, const TestSignal& signal)
+    {
+        for (int i = 0; i < fftSize; ++i)
+            spectrum[(size_t) i] = { (double) output[i], 0.0 };
+
+        performFFT();
+
+        const double scale = 1.0 / ((double) fftSize * (double) fftSize);
+        double tones = 0.0, grid = 0.0, offGrid = 0.0;
+
+        for (int bin = 1; bin <= fftSize / 2; ++bin)
+        {
+            // One-sided power: both halves of the spectrum, except at Nyquist
+            const double power = std::norm (spectrum[(size_t) bin]) * scale * (bin < fftSize / 2 ? 2.0 : 1.0);
+
+            if (bin % gridStep != 0)
+                offGrid += power;
+            else if (std::find (signal.bins.begin(), signal.bins.end(), bin) != signal.bins.end())
+                tones += power;
+            else
+                grid += power;
+        }
+
+        QualityMetrics metrics;
+        metrics.aliasingDb = powerToDecibels (offGrid) - powerToDecibels (tones + grid);
+        metrics.thdnDb = powerToDecibels (grid + offGrid) - powerToDecibels (tones);
+        metrics.dcOffsetDb = juce::Decibels::gainToDecibels (std::abs (spectrum[0].real()) / fftSize, -200.0);
+        return metrics;
+    }
+
+    void QualityAnalyzer::performFFT() noexcept
+    {
+        // Iterative radix-2 in double: juce::dsp::FFT is single precision only, and its
+        // rounding noise would sit right where the best settings alias
+        const auto n = (size_t) fftSize;
+
+        for (size_t i = 1, j = 0; i < n; ++i)
+        {
+            size_t bit = n >> 1;
+
+            for (; (j & bit) != 0; bit >>= 1)
+                j ^= bit;
+
+            j ^= bit;
+
+            if (i < j)
+                std::swap (spectrum[i], spectrum[j]);
+        }
+
+        for (size_t length = 2; length <= n; length <<= 1)
+        {
+            const size_t half = length / 2, step = n / length;
+
+            for (size_t start = 0; start < n; start += length)
+            {
+                for (size_t k = 0; k < half; ++k)
+                {
+                    auto& a = spectrum[start + k];
+                    auto& b = spectrum[start + k + half];
+                    const auto t = b * twiddles[k * step];
+
+                    b = a - t;
+                    a += t;
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    double QualityAnalyzer::measureNanosecondsPerSample (const ProcessorConfig& config, const Scenario& scenario, const TestSignal& signal,
+                                                         int blockSize, int numRuns, double minSecondsPerRun) const
+    {
+        using Clock = std::chrono::steady_clock;
+
+        auto processor = makeProcessor (config, scenario, sampleRate, blockSize);
+        const auto frame = makeFrame (signal);
+        juce::AudioBuffer<float> block (1, blockSize);
+        juce::MidiBuffer midi;
+        int position = 0;
+
+        // Fresh input every block, as a host would
+        const auto processBlock = [&]
+        {
+            if (position + blockSize > fftSize)
+                position = 0;
+
+            block.copyFrom (0, 0, frame, 0, position, blockSize);
+            position += blockSize;
+            processor->processBlock (block, midi);
+        };
+
+        // Warm up caches, branch predictors and the CPU clock
+        for (int i = 0; i < 16; ++i)
+            processBlock();
+
+        std::vector<double> runs;
+
+        for (int run = 0; run < numRuns; ++run)
+        {
+            int64_t numBlocks = 0;
+            const auto start = Clock::now();
+            auto elapsed = Clock::duration::zero();
+
+            do
+            {
+                for (int i = 0; i < 8; ++i)
+                    processBlock();
+
+                numBlocks += 8;
+                elapsed = Clock::now() - start;
+            } while (std::chrono::duration<double> (elapsed).count() < minSecondsPerRun);
+
+            runs.push_back ((double) std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count() / (double) (numBlocks * blockSize));
+        }
+
+        std::sort (runs.begin(), runs.end());
+        return runs[runs.size() / 2];
+    }
+
+    //==============================================================================
+    std::unique_ptr<WavefolderProcessor> QualityAnalyzer::makeProcessor (const ProcessorConfig& config, const Scenario& scenario, double rate,
+                                                                         int blockSize, bool doublePrecision)
+    {
+        auto processor = std::make_unique<WavefolderProcessor>();
+        processor->setProcessingPrecision (doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                           : juce::AudioProcessor::singlePrecision);
+
+        // Main bus only, the sidechain stays disabled
+        auto layout = processor->getBusesLayout();
+        layout.inputBuses.getReference (0) = juce::AudioChannelSet::mono();
+        layout.outputBuses.getReference (0) = juce::AudioChannelSet::mono();
+        processor->setBusesLayout (layout);
+
+        setParameter (*processor, Parameters::driveId, scenario.driveDb);
+        setParameter (*processor, Parameters::thresId, scenario.threshold);
+        setParameter (*processor, Parameters::wfTypeId, (float) config.foldType);
+        setParameter (*processor, Parameters::aaModeId, (float) config.aaMode);
+        setParameter (*processor, Parameters::osId, (float) config.osIndex);
+        setParameter (*processor, Parameters::lutId, config.lut ? 1.0f : 0.0f);
+
+        processor->setNonRealtime (true);
+        processor->setRateAndBufferSizeDetails (rate, blockSize);
+        processor->prepareToPlay (rate, blockSize);
+
+        // The table replaces the exact kernels only without ADAA, then start again from scratch
+        if (config.lut && config.aaMode == 0)
+        {
+            if (! waitForLookupTable (*processor, blockSize))
+                std::cerr << "Lookup table not ready, measuring the exact kernels instead" << std::endl;
+
+            processor->prepareToPlay (rate, blockSize);
+        }
+
+        return processor;
+    }
+
+    template <typename SampleType>
+    void QualityAnalyzer::process (WavefolderProcessor& processor, juce::AudioBuffer<SampleType>& buffer, int blockSize)
+    {
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+        {
+            const int numSamples = juce::jmin (blockSize, buffer.getNumSamples() - start);
+            juce::AudioBuffer<SampleType> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, numSamples);
+            processor.processBlock (block, midi);
+        }
+    }
+
+    template void QualityAnalyzer::process (WavefolderProcessor&, juce::AudioBuffer<float>&, int);
+    template void QualityAnalyzer::process (WavefolderProcessor&, juce::AudioBuffer<double>&, int);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "PluginProcessor.h"
+
+#include <complex>
+
+namespace Analysis
+{
+    //==============================================================================
+    /** Processing settings the harness compares: what a user trades CPU for quality with. */
+    struct ProcessorConfig
+    {
+        int foldType = 0;
+        int aaMode = 0;
+        int osIndex = 0;
+        bool lut = false;
+
+        /** e.g. "ADAA1 4x" or "Off 1x LUT", without the fold type. */
+        juce::String getSettingName() const;
+        int getOversamplingFactor() const noexcept { return 1 << osIndex; }
+    };
+
+    /** How hard the fold is driven. */
+    struct Scenario
+    {
+        float driveDb = 18.0f;
+        float threshold = 0.7f;
+
+        juce::String getName() const;
+    };
+
+    /** A sum of sines, each on an exact bin of the analysis FFT and on the bin grid (see
+        QualityAnalyzer). A stepped sweep is one single tone signal per frequency. */
+    struct TestSignal
+    {
+        juce::String name;
+        std::vector<int> bins;
+        double amplitude = 0.5;  // Per tone
+    };
+
+    struct QualityMetrics
+    {
+        double aliasingDb = 0.0;  // Aliased power against everything a band-limited fold would produce
+        double thdnDb = 0.0;      // Everything but the tones and DC, against the tones
+        double dcOffsetDb = 0.0;  // DC of the output, dBFS
+    };
+
+    //==============================================================================
+    /** Measures aliasing, THD+N and DC of WavefolderProcessor on steady test tones.
+
+        Every tone sits on an exact FFT bin that is a multiple of gridStep, and the FFT size
+        is a power of two. The output is then periodic over one FFT frame, so no window is
+        needed, and every harmonic and intermodulation product below Nyquist lands on a
+        multiple of gridStep too. What was folded back from above Nyquist lands off the grid,
+        since the FFT size isn't a multiple of gridStep. Only components folded from beyond
+        gridStep / 2 times the sample rate can land back on the grid, far enough up the
+        spectrum to be negligible.
+
+        Every measurement runs on a fresh, mono processor in single precision, the path a
+        host uses, which is left to settle before the analysed frame.
+    */
+    class QualityAnalyzer
+    {
+    public:
+        static constexpr int gridStep = 7;
+
+        QualityAnalyzer (double sampleRate, int fftOrder);
+
+        double getSampleRate() const noexcept { return sampleRate; }
+        int getFftSize() const noexcept { return fftSize; }
+
+        /** Grid bin closest to a frequency, in Hz. */
+        int getBin (double frequency) const noexcept;
+        double getFrequency (int bin) const noexcept { return bin * sampleRate / fftSize; }
+
+        /** One FFT frame of the signal, which repeats seamlessly. */
+        juce::AudioBuffer<float> makeFrame (const TestSignal& signal) const;
+
+        QualityMetrics measure (const ProcessorConfig& config, const Scenario& scenario, const TestSignal& signal);
+
+        /** Median processBlock time per sample over numRuns runs of at least minSecondsPerRun. */
+        double measureNanosecondsPerSample (const ProcessorConfig& config, const Scenario& scenario, const TestSignal& signal,
+                                            int blockSize, int numRuns, double minSecondsPerRun) const;
+
+        //==============================================================================
+        /** Prepared processor with these settings, the lookup table baked if it uses one. */
+        static std::unique_ptr<WavefolderProcessor> makeProcessor (const ProcessorConfig& config, const Scenario& scenario, double rate,
+                                                                   int blockSize, bool doublePrecision = false);
+
+        /** Runs the input through the processor in blocks, in place. */
+        template <typename SampleType>
+        static void process (WavefolderProcessor& processor, juce::AudioBuffer<SampleType>& buffer, int blockSize);
+
+        /** Block size of every render. */
+        static constexpr int renderBlockSize = 512;
+
+    private:
+        QualityMetrics analyse (const float* output, const TestSignal& signal);
+        void performFFT() noexcept;
+
+        // The analysed frame follows at least this much of the signal
+        static constexpr double settleSeconds = 0.25;
+
+        double sampleRate;
+        int fftSize;
+        std::vector<std::complex<double>> spectrum, twiddles;
+    };
+}
@@ -0,0 +1,1125 @@
+/*  Headless performance benchmarks for the fold kernels and the processor.
+
+    Runs without a host and writes one JSON document, so results can be
+    stored per release and compared on the render nodes:
+
+        WavefolderBenchmarks [--quick] [--output=results.json] [--sample-rate=48000] [--min-time-ms=20]
+
+    Three groups are measured, each for every fold type, block size and channel count:
+      - "kernels":   the raw FoldDSP kernels of every instruction set this CPU supports, with
+                     the default settings run through both the kernel specialised for them
+                     and the generic one
+      - "reference": punk_dsp::Wavefolder, the implementation the plugin started from
+      - "processor": WavefolderProcessor::processBlock for every AA / oversampling / LUT setting
+
+    plus "multichannel", which compares one wide instance against stacked stereo instances
+    on the same channels, and a 7.1.4 bed with linked and unlinked channel groups, and
+    "precision", which compares the float and double processBlock with what a 64-bit host
+    pays to run the float one (converting every block to float and back), and "streams",
+    which folds many independent mono streams one object at a time and through the batch
+    engine, on per-stream buffers and on stream-interleaved frames, "multiband", which
+    runs the processor with 1 to 4 bands against the full-band chain, "output_stages",
+    which runs it with the DC blocker and the limiter off and on, and "stereo_modes", which
+    runs a stereo instance linked, left/right and mid/side.
+
+    "startup" is measured first, while the process is still cold: the time to construct,
+    prepare and destroy 1 to 256 processors, and to open and close an editor, with and
+    without another editor already holding the shared look and feel. It runs on the
+    message thread, as a host would, but never puts the editor on screen.
+
+    Timings are the median over several runs and include refilling the block with fresh
+    input, as a host would. "instances_per_core" is how many real-time instances of that
+    configuration one core could run at the given sample rate, ignoring all host overhead.
+*/
+
+#include "PluginProcessor.h"
+#include "dsp/BatchFolder.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        double minSecondsPerRun = 0.02;
+        int numRuns = 5;
+        bool quick = false;
+    };
+
+    constexpr int allBlockSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    constexpr int allChannelCounts[] = { 1, 2, 8 };
+    constexpr const char* foldTypeNames[] = { "FoldToRange", "SinFold", "ComboFold" };
+    constexpr const char* aaModeNames[] = { "Off", "ADAA1", "ADAA2" };
+
+    // Drive pushes the test signal well into the folds, so every branch of the shapes runs
+    constexpr float benchmarkDriveDb = 12.0f;
+
+    std::vector<int> getBlockSizes (const Settings& settings)
+    {
+        if (settings.quick)
+            return { 512 };
+
+        return { std::begin (allBlockSizes), std::end (allBlockSizes) };
+    }
+
+    std::vector<int> getChannelCounts (const Settings& settings)
+    {
+        if (settings.quick)
+            return { 2 };
+
+        return { std::begin (allChannelCounts), std::end (allChannelCounts) };
+    }
+
+    //==============================================================================
+    /** One second of a detuned sawtooth per channel, a harmonically rich input that
+        crosses the fold corners at every level. */
+    juce::AudioBuffer<float> makeTestSignal (int numChannels, double sampleRate)
+    {
+        juce::AudioBuffer<float> signal (numChannels, (int) sampleRate);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const double increment = (110.0 * (1.0 + 0.01 * ch)) / sampleRate;
+            double phase = 0.0;
+
+            for (int i = 0; i < signal.getNumSamples(); ++i)
+            {
+                signal.setSample (ch, i, (float) (0.8 * (2.0 * phase - 1.0)));
+                phase += increment;
+                phase -= std::floor (phase);
+            }
+        }
+
+        return signal;
+    }
+
+    /** Copies the next block of the test signal into `block`, wrapping around at the end. */
+    struct SignalSource
+    {
+        SignalSource (int numChannels, double sampleRate) : signal (makeTestSignal (numChannels, sampleRate)) {}
+
+        void fill (juce::AudioBuffer<float>& block)
+        {
+            fillFrom (signal, block);
+        }
+
+        void fill (juce::AudioBuffer<double>& block)
+        {
+            if (signalDouble.getNumSamples() == 0)
+                signalDouble.makeCopyOf (signal);
+
+            fillFrom (signalDouble, block);
+        }
+
+        template <typename SampleType>
+        void fillFrom (const juce::AudioBuffer<SampleType>& source, juce::AudioBuffer<SampleType>& block)
+        {
+            const int numSamples = block.getNumSamples();
+
+            if (position + numSamples > signal.getNumSamples())
+                position = 0;
+
+            for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                block.copyFrom (ch, 0, source, ch, position, numSamples);
+
+            position += numSamples;
+        }
+
+        juce::AudioBuffer<float> signal;
+        juce::AudioBuffer<double> signalDouble;
+        int position = 0;
+    };
+
+    //==============================================================================
+    /** Median nanoseconds per call of `fn`, each run lasting at least minSecondsPerRun. */
+    template <typename Fn>
+    double measureNanosecondsPerCall (Fn&& fn, const Settings& settings)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Warm up caches, branch predictors and the CPU clock
+        for (int i = 0; i < 16; ++i)
+            fn();
+
+        std::vector<double> runs;
+
+        for (int run = 0; run < settings.numRuns; ++run)
+        {
+            int64_t numCalls = 0;
+            const auto start = Clock::now();
+            auto elapsed = Clock::duration::zero();
+
+            do
+            {
+                for (int i = 0; i < 8; ++i)
+                    fn();
+
+                numCalls += 8;
+                elapsed = Clock::now() - start;
+            } while (std::chrono::duration<double> (elapsed).count() < settings.minSecondsPerRun);
+
+            runs.push_back ((double) std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count() / (double) numCalls);
+        }
+
+        std::sort (runs.begin(), runs.end());
+        return runs[runs.size() / 2];
+    }
+
+    juce::DynamicObject::Ptr makeResult (double nanosecondsPerBlock, int blockSize, int numChannels, const Settings& settings)
+    {
+        const double nsPerSample = nanosecondsPerBlock / (double) blockSize;
+
+        juce::DynamicObject::Ptr result = new juce::DynamicObject();
+        result->setProperty ("block_size", blockSize);
+        result->setProperty ("channels", numChannels);
+        result->setProperty ("ns_per_sample", nsPerSample);
+        result->setProperty ("ns_per_channel_sample", nsPerSample / numChannels);
+        result->setProperty ("instances_per_core", 1.0e9 / (nsPerSample * settings.sampleRate));
+        return result;
+    }
+
+    void logProgress (const juce::String& line)
+    {
+        std::cerr << line << std::endl;
+    }
+
+    //==============================================================================
+    juce::var benchmarkKernels (const Settings& settings)
+    {
+        using namespace FoldDSP::Kernels;
+
+        juce::Array<juce::var> results;
+
+        // Default settings take the specialised kernels, the full chain the generic one. The
+        // generic kernel also runs on the defaults, which is what the specialisation saves
+        FoldDSP::FoldParams defaults;
+        defaults.drive = juce::Decibels::decibelsToGain (benchmarkDriveDb);
+
+        FoldDSP::FoldParams fullChain = defaults;
+        fullChain.biasPre = 0.1f;
+        fullChain.biasPost = -0.05f;
+        fullChain.mix = 0.8f;
+
+        FoldDSP::FoldParams rampEnd = fullChain;
+        rampEnd.drive *= 2.0f;
+        rampEnd.threshold = 0.5f;
+
+        for (auto isa : { Isa::scalar, Isa::sse2, Isa::avx2, Isa::avx512, Isa::neon })
+        {
+            const auto* table = getTable (isa);
+
+            if (table == nullptr)
+                continue;
+
+            for (int type = 0; type < 3; ++type)
+            {
+                for (int numChannels : getChannelCounts (settings))
+                {
+                    for (int blockSize : getBlockSizes (settings))
+                    {
+                        SignalSource source (numChannels, settings.sampleRate);
+
+                        FoldDSP::FoldParamSmoother smoother;
+                        smoother.reset (settings.sampleRate, 1.0, fullChain);
+                        smoother.setTargets (rampEnd);
+                        const auto ramp = smoother.getRamp();
+
+                        // Every variant in both precisions, each with its own vector width
+                        const auto runPrecision = [&] (auto sample)
+                        {
+                            using SampleType = decltype (sample);
+                            juce::AudioBuffer<SampleType> block (numChannels, blockSize);
+
+                            const auto runKernel = [&] (const char* variant, auto&& process)
+                            {
+                                const double ns = measureNanosecondsPerCall ([&]
+                                {
+                                    source.fill (block);
+
+                                    for (int ch = 0; ch < numChannels; ++ch)
+                                        process (block.getWritePointer (ch), blockSize);
+                                }, settings);
+
+                                auto result = makeResult (ns, blockSize, numChannels, settings);
+                                result->setProperty ("isa", table->name);
+                                result->setProperty ("precision", std::is_same_v<SampleType, double> ? "double" : "float");
+                                result->setProperty ("vector_width", table->getWidth<SampleType>());
+                                result->setProperty ("fold_type", foldTypeNames[type]);
+                                result->setProperty ("variant", variant);
+                                results.add (result.get());
+                            };
+
+                            const auto foldType = (FoldDSP::FoldType) type;
+                            const auto specialised = table->select<SampleType> (foldType, defaults);
+                            const auto generic = table->get<SampleType> (foldType);
+                            const auto ramped = table->getRamped<SampleType> (foldType);
+                            const auto blended = table->getBlended<SampleType> (false);
+
+                            // Crossfade from this type towards the next one, as a type change runs it
+                            auto crossfade = FoldDSP::getShapeBlend (foldType);
+                            const auto next = FoldDSP::getShapeBlend ((FoldDSP::FoldType) ((type + 1) % 3));
+                            crossfade.triangleDelta = (next.triangle - crossfade.triangle) / (float) blockSize;
+                            crossfade.sineDelta = (next.sine - crossfade.sine) / (float) blockSize;
+
+                            runKernel ("specialised", [&] (SampleType* data, int n) { specialised (data, n, defaults); });
+                            runKernel ("generic", [&] (SampleType* data, int n) { generic (data, n, defaults); });
+                            runKernel ("full_chain", [&] (SampleType* data, int n) { generic (data, n, fullChain); });
+                            runKernel ("ramped", [&] (SampleType* data, int n) { ramped (data, n, fullChain, ramp); });
+                            runKernel ("crossfade", [&] (SampleType* data, int n) { blended (data, n, fullChain, {}, crossfade); });
+                        };
+
+                        runPrecision (0.0f);
+                        runPrecision (0.0);
+                    }
+                }
+
+                logProgress (juce::String ("kernels: ") + table->name + " " + foldTypeNames[type]);
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    juce::var benchmarkReference (const Settings& settings)
+    {
+        juce::Array<juce::var> results;
+
+        punk_dsp::Wavefolder wf;
+        wf.setDrive (juce::Decibels::decibelsToGain (benchmarkDriveDb));
+        wf.setOutGain (1.0f);
+        wf.setBiasPre (0.0f);
+        wf.setBiasPost (0.0f);
+        wf.setThreshold (Parameters::thresDefault);
+        wf.setMix (1.0f);
+
+        for (int type = 0; type < 3; ++type)
+        {
+            for (int numChannels : getChannelCounts (settings))
+            {
+                for (int blockSize : getBlockSizes (settings))
+                {
+                    SignalSource source (numChannels, settings.sampleRate);
+                    juce::AudioBuffer<float> block (numChannels, blockSize);
+
+                    const double ns = measureNanosecondsPerCall ([&]
+                    {
+                        source.fill (block);
+
+                        switch (type)
+                        {
+                            case 1:  wf.foldSinBuffer (block); break;
+                            case 2:  wf.comboFoldBuffer (block); break;
+                            default: wf.foldToRangeBuffer (block); break;
+                        }
+                    }, settings);
+
+                    auto result = makeResult (ns, blockSize, numChannels, settings);
+                    result->setProperty ("fold_type", foldTypeNames[type]);
+                    results.add (result.get());
+                }
+            }
+
+            logProgress (juce::String ("reference: ") + foldTypeNames[type]);
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    struct ProcessorConfig
+    {
+        int foldType = 0;
+        int aaMode = 0;
+        int osIndex = 0;
+        int osPhase = 0;
+        bool lut = false;
+    };
+
+    void setParameter (WavefolderProcessor& processor, const char* id, float value)
+    {
+        auto* param = processor.apvts.getParameter (id);
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    /** Returns nullptr if the processor doesn't support this channel layout. */
+    std::unique_ptr<WavefolderProcessor> makeProcessor (const ProcessorConfig& config, const juce::AudioChannelSet& channels, int blockSize,
+                                                        const Settings& settings, bool doublePrecision = false)
+    {
+        auto processor = std::make_unique<WavefolderProcessor>();
+        processor->setProcessingPrecision (doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                           : juce::AudioProcessor::singlePrecision);
+
+        // Main bus only, the sidechain stays disabled
+        auto layout = processor->getBusesLayout();
+        layout.inputBuses.getReference (0) = channels;
+        layout.outputBuses.getReference (0) = channels;
+
+        if (! processor->setBusesLayout (layout))
+            return nullptr;
+
+        setParameter (*processor, Parameters::driveId, benchmarkDriveDb);
+        setParameter (*processor, Parameters::wfTypeId, (float) config.foldType);
+        setParameter (*processor, Parameters::aaModeId, (float) config.aaMode);
+        setParameter (*processor, Parameters::osId, (float) config.osIndex);
+        setParameter (*processor, Parameters::osPhaseId, (float) config.osPhase);
+        setParameter (*processor, Parameters::lutId, config.lut ? 1.0f : 0.0f);
+
+        processor->setRateAndBufferSizeDetails (settings.sampleRate, blockSize);
+        processor->prepareToPlay (settings.sampleRate, blockSize);
+        return processor;
+    }
+
+    std::vector<ProcessorConfig> getProcessorConfigs()
+    {
+        std::vector<ProcessorConfig> configs;
+
+        for (int type = 0; type < 3; ++type)
+        {
+            for (int os = 0; os < FoldDSP::Oversampler::numFactors; ++os)
+            {
+                // The filter phase only exists with oversampling
+                for (int phase = 0; phase < (os == 0 ? 1 : FoldDSP::Oversampler::numPhases); ++phase)
+                {
+                    for (int aa = 0; aa < 3; ++aa)
+                        configs.push_back ({ type, aa, os, phase, false });
+
+                    // The table replaces the exact kernels, it is never combined with ADAA
+                    configs.push_back ({ type, 0, os, phase, true });
+                }
+            }
+        }
+
+        return configs;
+    }
+
+    juce::var benchmarkProcessor (const Settings& settings)
+    {
+        juce::Array<juce::var> results;
+        juce::MidiBuffer midi;
+
+        for (const auto& config : getProcessorConfigs())
+        {
+            for (int numChannels : getChannelCounts (settings))
+            {
+                for (int blockSize : getBlockSizes (settings))
+                {
+                    auto processor = makeProcessor (config, juce::AudioChannelSet::canonicalChannelSet (numChannels), blockSize, settings);
+
+                    if (processor == nullptr)
+                        continue;
+
+                    SignalSource source (numChannels, settings.sampleRate);
+                    juce::AudioBuffer<float> block (numChannels, blockSize);
+
+                    const auto processNext = [&]
+                    {
+                        source.fill (block);
+                        processor->processBlock (block, midi);
+                    };
+
+                    // Let the smoothing settle, and give the background thread time to bake the table
+                    const auto warmUpEnd = juce::Time::getMillisecondCounter() + (config.lut ? 2000u : 0u);
+
+                    for (int i = 0; i < (int) settings.sampleRate / 4; i += blockSize)
+                        processNext();
+
+                    while (config.lut && ! processor->isLutReady() && juce::Time::getMillisecondCounter() < warmUpEnd)
+                    {
+                        juce::Thread::sleep (5);
+                        processNext();
+                    }
+
+                    const double ns = measureNanosecondsPerCall (processNext, settings);
+
+                    auto result = makeResult (ns, blockSize, numChannels, settings);
+                    result->setProperty ("fold_type", foldTypeNames[config.foldType]);
+                    result->setProperty ("aa_mode", aaModeNames[config.aaMode]);
+                    result->setProperty ("oversampling", 1 << config.osIndex);
+                    result->setProperty ("os_phase", config.osPhase == 0 ? "minimum" : "linear");
+                    result->setProperty ("lut", config.lut);
+                    result->setProperty ("latency_samples", processor->getLatencySamples());
+
+                    if (config.lut)
+                        result->setProperty ("lut_max_error", processor->getLutMaxError());
+
+                    processor->releaseResources();
+                    results.add (result.get());
+                }
+            }
+
+            logProgress (juce::String ("processor: ") + foldTypeNames[config.foldType] + " " + aaModeNames[config.aaMode]
+                         + " " + juce::String (1 << config.osIndex) + "x" + (config.osPhase == 0 ? " min" : " lin")
+                         + (config.lut ? " LUT" : ""));
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    /** Processes `numChannels` channels of the test signal, either through one processor or
+        split into several narrower ones, one after the other as a host would run them. */
+    double measureInstances (juce::OwnedArray<WavefolderProcessor>& processors, int numChannels, int blockSize, const Settings& settings)
+    {
+        juce::MidiBuffer midi;
+        SignalSource source (numChannels, settings.sampleRate);
+        juce::AudioBuffer<float> block (numChannels, blockSize);
+
+        const auto processNext = [&]
+        {
+            source.fill (block);
+            int channel = 0;
+
+            for (auto* processor : processors)
+            {
+                const int width = processor->getTotalNumOutputChannels();
+                juce::AudioBuffer<float> view (block.getArrayOfWritePointers() + channel, width, blockSize);
+                processor->processBlock (view, midi);
+                channel += width;
+            }
+        };
+
+        for (int i = 0; i < (int) settings.sampleRate / 4; i += blockSize)
+            processNext();
+
+        return measureNanosecondsPerCall (processNext, settings);
+    }
+
+    juce::var benchmarkMultichannel (const Settings& settings)
+    {
+        juce::Array<juce::var> results;
+        constexpr int numChannels = 16;
+
+        for (int aa = 0; aa < 3; ++aa)
+        {
+            const ProcessorConfig config { 0, aa, 0, 0, false };
+
+            for (int blockSize : getBlockSizes (settings))
+            {
+                const auto addResult = [&] (const char* variant, double ns, int channels, int numInstances)
+                {
+                    auto result = makeResult (ns, blockSize, channels, settings);
+                    result->setProperty ("variant", variant);
+                    result->setProperty ("instances", numInstances);
+                    result->setProperty ("aa_mode", aaModeNames[aa]);
+                    results.add (result.get());
+                };
+
+                // The same 16 channels as one discrete instance, and as eight stereo ones
+                juce::OwnedArray<WavefolderProcessor> wide, stereo;
+                wide.add (makeProcessor (config, juce::AudioChannelSet::discreteChannels (numChannels), blockSize, settings).release());
+
+                for (int i = 0; i < numChannels / 2; ++i)
+                    stereo.add (makeProcessor (config, juce::AudioChannelSet::stereo(), blockSize, settings).release());
+
+                addResult ("discrete_16", measureInstances (wide, numChannels, blockSize, settings), numChannels, 1);
+                addResult ("stereo_x8", measureInstances (stereo, numChannels, blockSize, settings), numChannels, stereo.size());
+
+                // 7.1.4 bed, with the LFE and height groups on their own settings or not
+                const auto bed = juce::AudioChannelSet::create7point1point4();
+
+                for (const bool unlinked : { false, true })
+                {
+                    juce::OwnedArray<WavefolderProcessor> processors;
+                    auto* processor = processors.add (makeProcessor (config, bed, blockSize, settings).release());
+
+                    if (unlinked)
+                    {
+                        for (const int group : { 1, 3 })
+                        {
+                            setParameter (*processor, Parameters::groupLinkIds[group], 0.0f);
+                            setParameter (*processor, Parameters::groupDriveIds[group], benchmarkDriveDb - 6.0f);
+                            setParameter (*processor, Parameters::groupThresIds[group], 0.5f);
+                        }
+                    }
+
+                    addResult (unlinked ? "7.1.4_unlinked" : "7.1.4_linked",
+                               measureInstances (processors, bed.size(), blockSize, settings), bed.size(), 1);
+                }
+            }
+
+            logProgress (juce::String ("multichannel: ") + aaModeNames[aa]);
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    /** The processor with the multiband mode off and with 2, 3 & 4 bands, every band on its
+        own fold type and settings. */
+    juce::var benchmarkMultiband (const Settings& settings)
+    {
+        juce::Array<juce::var> results;
+        juce::MidiBuffer midi;
+
+        for (int os : { 0, 2 })
+        {
+            const ProcessorConfig config { 0, 0, os, 0, false };
+
+            for (int numBands = 1; numBands <= Parameters::maxBands; ++numBands)
+            {
+                for (int numChannels : getChannelCounts (settings))
+                {
+                    for (int blockSize : getBlockSizes (settings))
+                    {
+                        auto processor = makeProcessor (config, juce::AudioChannelSet::canonicalChannelSet (numChannels), blockSize, settings);
+
+                        if (processor == nullptr)
+                            continue;
+
+                        setParameter (*processor, Parameters::bandsId, (float) (numBands - 1));
+
+                        for (int b = 0; b < numBands; ++b)
+                        {
+                            setParameter (*processor, Parameters::bandTypeIds[b], (float) (b % 3));
+                            setParameter (*processor, Parameters::bandDriveIds[b], benchmarkDriveDb - 3.0f * (float) b);
+                        }
+
+                        SignalSource source (numChannels, settings.sampleRate);
+                        juce::AudioBuffer<float> block (numChannels, blockSize);
+
+                        const auto processNext = [&]
+                        {
+                            source.fill (block);
+                            processor->processBlock (block, midi);
+                        };
+
+                        for (int i = 0; i < (int) settings.sampleRate / 4; i += blockSize)
+                            processNext();
+
+                        auto result = makeResult (measureNanosecondsPerCall (processNext, settings), blockSize, numChannels, settings);
+                        result->setProperty ("bands", numBands);
+                        result->setProperty ("oversampling", 1 << os);
+                        results.add (result.get());
+                    }
+                }
+
+                logProgress ("multiband: " + juce::String (numBands) + " bands " + juce::String (1 << os) + "x");
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    /** The processor with the output stages off, each on its own and both on, to check
+        that a stage switched off costs nothing. */
+    juce::var benchmarkOutputStages (const Settings& settings)
+    {
+        juce::Array<juce::var> results;
+        juce::MidiBuffer midi;
+        const ProcessorConfig config { 0, 0, 0, 0, false };
+
+        const std::pair<bool, bool> stages[] = { { false, false }, { true, false }, { false, true }, { true, true } };
+
+        for (const auto& [dcBlock, limiter] : stages)
+        {
+            for (int numChannels : getChannelCounts (settings))
+            {
+                for (int blockSize : getBlockSizes (settings))
+                {
+                    auto processor = makeProcessor (config, juce::AudioChannelSet::canonicalChannelSet (numChannels), blockSize, settings);
+
+                    if (processor == nullptr)
+                        continue;
+
+                    setParameter (*processor, Parameters::dcBlockId, dcBlock ? 1.0f : 0.0f);
+                    setParameter (*processor, Parameters::limiterId, limiter ? 1.0f : 0.0f);
+
+                    SignalSource source (numChannels, settings.sampleRate);
+                    juce::AudioBuffer<float> block (numChannels, blockSize);
+
+                    const auto processNext = [&]
+                    {
+                        source.fill (block);
+                        processor->processBlock (block, midi);
+                    };
+
+                    for (int i = 0; i < (int) settings.sampleRate / 4; i += blockSize)
+                        processNext();
+
+                    auto result = makeResult (measureNanosecondsPerCall (processNext, settings), blockSize, numChannels, settings);
+                    result->setProperty ("dc_blocker", dcBlock);
+                    result->setProperty ("limiter", limiter);
+                    results.add (result.get());
+                }
+            }
+
+            logProgress (juce::String ("output stages: dc blocker ") + (dcBlock ? "on" : "off") + ", limiter " + (limiter ? "on" : "off"));
+        }
+
+        return results;
+    }
+
+    juce::var benchmarkStereoModes (const Settings& settings)
+    {
+        constexpr const char* modeNames[] = { "Linked", "LeftRight", "MidSide" };
+
+        juce::Array<juce::var> results;
+        juce::MidiBuffer midi;
+
+        for (int type = 0; type < 3; ++type)
+        {
+            for (int mode = 0; mode <= Parameters::stereoModeMidSide; ++mode)
+            {
+                for (int blockSize : getBlockSizes (settings))
+                {
+                    auto processor = makeProcessor ({ type, 0, 0, 0, false }, juce::AudioChannelSet::stereo(), blockSize, settings);
+
+                    if (processor == nullptr)
+                        continue;
+
+                    // Both sides on settings of their own, so none of the work is shared
+                    setParameter (*processor, Parameters::stereoModeId, (float) mode);
+                    setParameter (*processor, Parameters::stereoDriveIds[0], benchmarkDriveDb);
+                    setParameter (*processor, Parameters::stereoDriveIds[1], benchmarkDriveDb - 6.0f);
+                    setParameter (*processor, Parameters::stereoThresIds[1], 0.5f);
+
+                    SignalSource source (2, settings.sampleRate);
+                    juce::AudioBuffer<float> block (2, blockSize);
+
+                    const auto processNext = [&]
+                    {
+                        source.fill (block);
+                        processor->processBlock (block, midi);
+                    };
+
+                    for (int i = 0; i < (int) settings.sampleRate / 4; i += blockSize)
+                        processNext();
+
+                    auto result = makeResult (measureNanosecondsPerCall (processNext, settings), blockSize, 2, settings);
+                    result->setProperty ("fold_type", foldTypeNames[type]);
+                    result->setProperty ("stereo_mode", modeNames[mode]);
+                    results.add (result.get());
+                }
+
+                logProgress (juce::String ("stereo modes: ") + foldTypeNames[type] + ", " + modeNames[mode]);
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    juce::var benchmarkPrecision (const Settings& settings)
+    {
+        juce::Array<juce::var> results;
+        juce::MidiBuffer midi;
+        constexpr int numChannels = 2;
+
+        for (int type = 0; type < 3; ++type)
+        {
+            for (int aa = 0; aa < 3; ++aa)
+            {
+                // 1x and 4x oversampling, the filters run in the processing precision too
+                for (int os : { 0, 2 })
+                {
+                    const ProcessorConfig config { type, aa, os, 0, false };
+
+                    for (int blockSize : getBlockSizes (settings))
+                    {
+                        SignalSource source (numChannels, settings.sampleRate);
+                        juce::AudioBuffer<float> floatBlock (numChannels, blockSize);
+                        juce::AudioBuffer<double> doubleBlock (numChannels, blockSize);
+
+                        const auto addResult = [&] (const char* path, double ns)
+                        {
+                            auto result = makeResult (ns, blockSize, numChannels, settings);
+                            result->setProperty ("path", path);
+                            result->setProperty ("fold_type", foldTypeNames[type]);
+                            result->setProperty ("aa_mode", aaModeNames[aa]);
+                            result->setProperty ("oversampling", 1 << os);
+                            results.add (result.get());
+                        };
+
+                        const auto measure = [&] (auto&& processNext)
+                        {
+                            for (int i = 0; i < (int) settings.sampleRate / 4; i += blockSize)
+                                processNext();
+
+                            return measureNanosecondsPerCall (processNext, settings);
+                        };
+
+                        auto floatProcessor = makeProcessor (config, juce::AudioChannelSet::stereo(), blockSize, settings);
+                        auto doubleProcessor = makeProcessor (config, juce::AudioChannelSet::stereo(), blockSize, settings, true);
+
+                        addResult ("float", measure ([&]
+                        {
+                            source.fill (floatBlock);
+                            floatProcessor->processBlock (floatBlock, midi);
+                        }));
+
+                        addResult ("double", measure ([&]
+                        {
+                            source.fill (doubleBlock);
+                            doubleProcessor->processBlock (doubleBlock, midi);
+                        }));
+
+                        // What the wrappers do for a plugin without a double path
+                        addResult ("host_converted", measure ([&]
+                        {
+                            source.fill (doubleBlock);
+                            floatBlock.makeCopyOf (doubleBlock, true);
+                            floatProcessor->processBlock (floatBlock, midi);
+                            doubleBlock.makeCopyOf (floatBlock, true);
+                        }));
+                    }
+
+                    logProgress (juce::String ("precision: ") + foldTypeNames[type] + " " + aaModeNames[aa] + " " + juce::String (1 << os) + "x");
+                }
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    /** Many independent mono streams with their own fold type and settings, as a voice or
+        render server would run them: one FoldParamSmoother and kernel call per stream object,
+        against FoldDSP::BatchFolder on per-stream buffers and on stream-interleaved frames. */
+    juce::var benchmarkStreams (const Settings& settings)
+    {
+        juce::Array<juce::var> results;
+
+        const std::vector<int> streamCounts = settings.quick ? std::vector<int> { 64 } : std::vector<int> { 1, 16, 64, 256, 1024 };
+        const std::vector<int> blockSizes = settings.quick ? std::vector<int> { 64 } : std::vector<int> { 16, 64, 256, 1024 };
+
+        // Stream s reads channel s of a few test signal channels
+        constexpr int numSourceChannels = 16;
+        const auto signal = makeTestSignal (numSourceChannels, settings.sampleRate);
+
+        const auto getSettings = [] (int stream, bool alternate)
+        {
+            FoldDSP::FoldParams p;
+            p.drive = juce::Decibels::decibelsToGain (benchmarkDriveDb + (float) (stream % 5) - (alternate ? 6.0f : 0.0f));
+            p.threshold = 0.4f + 0.1f * (float) (stream % 4);
+            p.mix = stream % 3 == 0 ? 0.8f : 1.0f;
+            return p;
+        };
+
+        for (const bool mixedTypes : { false, true })
+        {
+            for (const bool automated : { false, true })
+            {
+                for (int numStreams : streamCounts)
+                {
+                    for (int blockSize : blockSizes)
+                    {
+                        const auto getType = [&] (int stream) { return mixedTypes ? (FoldDSP::FoldType) (stream % 3) : FoldDSP::FoldType::sinFold; };
+
+                        // Fresh input for every call, copied from blocks prepared in both layouts
+                        juce::AudioBuffer<float> input (numStreams, blockSize), block (numStreams, blockSize);
+
+                        for (int s = 0; s < numStreams; ++s)
+                            input.copyFrom (s, 0, signal, s % numSourceChannels, 0, blockSize);
+
+                        FoldDSP::BatchFolder<float> planar, interleaved;
+                        planar.prepare (numStreams, settings.sampleRate);
+                        interleaved.prepare (numStreams, settings.sampleRate);
+
+                        const int frameStride = interleaved.getFrameStride();
+                        std::vector<float> inputFrames ((size_t) (frameStride * blockSize)), frames (inputFrames.size());
+
+                        for (int s = 0; s < numStreams; ++s)
+                            for (int i = 0; i < blockSize; ++i)
+                                inputFrames[(size_t) (i * frameStride + s)] = input.getSample (s, i);
+
+                        struct StreamObject
+                        {
+                            FoldDSP::FoldParamSmoother smoother;
+                            FoldDSP::FoldType type;
+                        };
+
+                        std::vector<std::unique_ptr<StreamObject>> objects;
+                        const auto& kernels = FoldDSP::Kernels::getActiveTable();
+
+                        for (int s = 0; s < numStreams; ++s)
+                        {
+                            const auto params = getSettings (s, false);
+
+                            auto& object = *objects.emplace_back (std::make_unique<StreamObject>());
+                            object.smoother.reset (settings.sampleRate, 0.02, params);
+                            object.type = getType (s);
+
+                            for (auto* batch : { &planar, &interleaved })
+                            {
+                                batch->setType (s, getType (s));
+                                batch->resetParameters (s, params);
+                            }
+                        }
+
+                        // Automated streams get new targets on every block, so they never settle
+                        int callIndex = 0;
+
+                        const auto retarget = [&] (auto&& setTargets)
+                        {
+                            if (automated)
+                            {
+                                ++callIndex;
+
+                                for (int s = 0; s < numStreams; ++s)
+                                    setTargets (s, getSettings (s, callIndex % 2 == 1));
+                            }
+                        };
+
+                        const auto addResult = [&] (const char* path, double ns)
+                        {
+                            auto result = makeResult (ns, blockSize, numStreams, settings);
+                            result->setProperty ("path", path);
+                            result->setProperty ("streams", numStreams);
+                            result->setProperty ("fold_types", mixedTypes ? "mixed" : "same");
+                            result->setProperty ("automated", automated);
+                            results.add (result.get());
+                        };
+
+                        addResult ("stream_objects", measureNanosecondsPerCall ([&]
+                        {
+                            block.makeCopyOf (input, true);
+                            retarget ([&] (int s, const FoldDSP::FoldParams& p) { objects[(size_t) s]->smoother.setTargets (p); });
+
+                            for (int s = 0; s < numStreams; ++s)
+                            {
+                                auto& object = *objects[(size_t) s];
+                                auto* data = block.getWritePointer (s);
+
+                                for (int i = 0; i < blockSize;)
+                                {
+                                    if (object.smoother.isSmoothing())
+                                    {
+                                        const int length = object.smoother.getSegmentLength (blockSize - i);
+                                        kernels.getRamped (object.type) (data + i, length, object.smoother.getCurrent(), object.smoother.getRamp());
+                                        object.smoother.skip (length);
+                                        i += length;
+                                    }
+                                    else
+                                    {
+                                        const auto params = object.smoother.getCurrent();
+                                        kernels.select (object.type, params) (data + i, blockSize - i, params);
+                                        break;
+                                    }
+                                }
+                            }
+                        }, settings));
+
+                        addResult ("batch_planar", measureNanosecondsPerCall ([&]
+                        {
+                            block.makeCopyOf (input, true);
+                            retarget ([&] (int s, const FoldDSP::FoldParams& p) { planar.setParameters (s, p); });
+                            planar.process (block.getArrayOfWritePointers(), blockSize);
+                        }, settings));
+
+                        addResult ("batch_interleaved", measureNanosecondsPerCall ([&]
+                        {
+                            std::copy (inputFrames.begin(), inputFrames.end(), frames.begin());
+                            retarget ([&] (int s, const FoldDSP::FoldParams& p) { interleaved.setParameters (s, p); });
+                            interleaved.processInterleaved (frames.data(), blockSize);
+                        }, settings));
+                    }
+
+                    logProgress ("streams: " + juce::String (numStreams) + (mixedTypes ? " mixed" : " same") + (automated ? " automated" : ""));
+                }
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    double getMillisecondsSince (std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+    }
+
+    double getMedian (std::vector<double> values)
+    {
+        std::sort (values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+    /** Constructs, prepares and destroys `numInstances` stereo processors, in ms per instance. */
+    juce::DynamicObject::Ptr measureInstanceStartup (int numInstances, const Settings& settings)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        std::vector<double> constructRuns, prepareRuns, destroyRuns;
+        constexpr int blockSize = 512;
+
+        for (int run = 0; run < settings.numRuns; ++run)
+        {
+            juce::OwnedArray<WavefolderProcessor> processors;
+            processors.ensureStorageAllocated (numInstances);
+
+            auto start = Clock::now();
+
+            for (int i = 0; i < numInstances; ++i)
+                processors.add (new WavefolderProcessor());
+
+            constructRuns.push_back (getMillisecondsSince (start) / numInstances);
+            start = Clock::now();
+
+            for (auto* processor : processors)
+            {
+                processor->setRateAndBufferSizeDetails (settings.sampleRate, blockSize);
+                processor->prepareToPlay (settings.sampleRate, blockSize);
+            }
+
+            prepareRuns.push_back (getMillisecondsSince (start) / numInstances);
+            start = Clock::now();
+
+            processors.clear();
+            destroyRuns.push_back (getMillisecondsSince (start) / numInstances);
+        }
+
+        juce::DynamicObject::Ptr result = new juce::DynamicObject();
+        result->setProperty ("instances", numInstances);
+        result->setProperty ("construct_ms", getMedian (constructRuns));
+        result->setProperty ("prepare_ms", getMedian (prepareRuns));
+        result->setProperty ("destroy_ms", getMedian (destroyRuns));
+        return result;
+    }
+
+    /** Opens an editor, paints it once into an image and closes it, in ms for each step.
+        With `keepOneOpen` another editor stays open meanwhile, as with several instances
+        on screen, so the shared look and feel already exists. */
+    juce::DynamicObject::Ptr measureEditorStartup (bool keepOneOpen, const Settings& settings)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        WavefolderProcessor processor;
+        std::unique_ptr<juce::AudioProcessorEditor> other;
+
+        if (keepOneOpen)
+            other.reset (processor.createEditor());
+
+        std::vector<double> createRuns, paintRuns, destroyRuns;
+
+        for (int run = 0; run < settings.numRuns; ++run)
+        {
+            auto start = Clock::now();
+            std::unique_ptr<juce::AudioProcessorEditor> editor (processor.createEditor());
+            createRuns.push_back (getMillisecondsSince (start));
+
+            // The displays render their images on the first paint
+            start = Clock::now();
+            juce::ignoreUnused (editor->createComponentSnapshot (editor->getLocalBounds()));
+            paintRuns.push_back (getMillisecondsSince (start));
+
+            start = Clock::now();
+            editor.reset();
+            destroyRuns.push_back (getMillisecondsSince (start));
+        }
+
+        other.reset();
+
+        juce::DynamicObject::Ptr result = new juce::DynamicObject();
+        result->setProperty ("other_editor_open", keepOneOpen);
+        result->setProperty ("create_ms", getMedian (createRuns));
+        result->setProperty ("first_paint_ms", getMedian (paintRuns));
+        result->setProperty ("destroy_ms", getMedian (destroyRuns));
+        return result;
+    }
+
+    juce::var benchmarkStartup (const Settings& settings)
+    {
+        juce::DynamicObject::Ptr results = new juce::DynamicObject();
+
+        // The very first instance also pays for everything built once per process
+        const auto start = std::chrono::steady_clock::now();
+        std::make_unique<WavefolderProcessor>().reset();
+        results->setProperty ("first_instance_ms", getMillisecondsSince (start));
+
+        juce::Array<juce::var> instances;
+
+        for (const int numInstances : { 1, 16, 256 })
+        {
+            if (settings.quick && numInstances > 16)
+                break;
+
+            instances.add (measureInstanceStartup (numInstances, settings).get());
+            logProgress ("startup: " + juce::String (numInstances) + " instances");
+        }
+
+        results->setProperty ("instances", instances);
+
+        juce::Array<juce::var> editors;
+
+        for (const bool keepOneOpen : { false, true })
+            editors.add (measureEditorStartup (keepOneOpen, settings).get());
+
+        logProgress ("startup: editor");
+        results->setProperty ("editor", editors);
+        return results.get();
+    }
+
+    //==============================================================================
+    juce::var describeSystem (const Settings& settings)
+    {
+        juce::DynamicObject::Ptr info = new juce::DynamicObject();
+        info->setProperty ("version", VERSION);
+        info->setProperty ("build_type", CMAKE_BUILD_TYPE);
+        info->setProperty ("timestamp", juce::Time::getCurrentTime().toISO8601 (true));
+        info->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+        info->setProperty ("cpu_vendor", juce::SystemStats::getCpuVendor());
+        info->setProperty ("cpu_model", juce::SystemStats::getCpuModel());
+        info->setProperty ("cpu_mhz", juce::SystemStats::getCpuSpeedInMegahertz());
+        info->setProperty ("num_cpus", juce::SystemStats::getNumCpus());
+        info->setProperty ("num_physical_cpus", juce::SystemStats::getNumPhysicalCpus());
+        info->setProperty ("active_isa", FoldDSP::Kernels::getActiveTable().name);
+        info->setProperty ("sample_rate", settings.sampleRate);
+        info->setProperty ("drive_db", benchmarkDriveDb);
+        return info.get();
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    Settings settings;
+    settings.quick = args.containsOption ("--quick");
+
+    if (settings.quick)
+        settings.numRuns = 3;
+
+    if (args.containsOption ("--sample-rate"))
+        settings.sampleRate = juce::jmax (8000.0, args.getValueForOption ("--sample-rate").getDoubleValue());
+
+    if (args.containsOption ("--min-time-ms"))
+        settings.minSecondsPerRun = juce::jmax (1, args.getValueForOption ("--min-time-ms").getIntValue()) / 1000.0;
+
+    juce::DynamicObject::Ptr report = new juce::DynamicObject();
+    report->setProperty ("system", describeSystem (settings));
+    report->setProperty ("startup", benchmarkStartup (settings));
+    report->setProperty ("kernels", benchmarkKernels (settings));
+    report->setProperty ("reference", benchmarkReference (settings));
+    report->setProperty ("processor", benchmarkProcessor (settings));
+    report->setProperty ("multichannel", benchmarkMultichannel (settings));
+    report->setProperty ("precision", benchmarkPrecision (settings));
+    report->setProperty ("streams", benchmarkStreams (settings));
+    report->setProperty ("multiband", benchmarkMultiband (settings));
+    report->setProperty ("output_stages", benchmarkOutputStages (settings));
+    report->setProperty ("stereo_modes", benchmarkStereoModes (settings));
+
+    const auto json = juce::JSON::toString (juce::var (report.get()));
+
+    if (args.containsOption ("--output"))
+    {
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption ("--output"));
+
+        if (! file.replaceWithText (json))
+        {
+            std::cerr << "Could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,435 @@
+#include "BatchRenderer.h"
+
+namespace Renderer
+{
+    namespace
+    {
+        //==============================================================================
+        /** Renders the file's own layout through one instance, so the channel groups pick up
+            the speaker positions. Files wider than the processor takes are split into runs
+            of discrete channels. */
+        class ProcessorChain
+        {
+        public:
+            juce::Result prepare (const juce::AudioChannelSet& fileLayout, double sampleRate, int blockSize, const juce::StringPairArray& parameters)
+            {
+                const int numChannels = fileLayout.size();
+
+                for (int first = 0; first < numChannels; first += Parameters::maxChannels)
+                {
+                    const int groupSize = juce::jmin (Parameters::maxChannels, numChannels - first);
+                    const auto channelSet = groupSize == numChannels ? fileLayout
+                                                                     : juce::AudioChannelSet::discreteChannels (groupSize);
+
+                    auto processor = std::make_unique<WavefolderProcessor>();
+
+                    // Main bus only, the sidechain stays disabled
+                    auto layout = processor->getBusesLayout();
+                    layout.inputBuses.getReference (0) = channelSet;
+                    layout.outputBuses.getReference (0) = channelSet;
+
+                    if (! processor->setBusesLayout (layout))
+                        return juce::Result::fail ("Unsupported channel layout");
+
+                    if (auto result = BatchRenderer::applyParameters (*processor, parameters); result.failed())
+                        return result;
+
+                    processor->setNonRealtime (true);
+                    processor->setRateAndBufferSizeDetails (sampleRate, blockSize);
+                    processor->prepareToPlay (sampleRate, blockSize);
+
+                    waitForLookupTable (*processor, groupSize, blockSize);
+                    processor->prepareToPlay (sampleRate, blockSize);
+
+                    groups.push_back ({ std::move (processor), first, groupSize });
+                }
+
+                return juce::Result::ok();
+            }
+
+            int getLatencySamples() const
+            {
+                return groups.empty() ? 0 : groups.front().processor->getLatencySamples();
+            }
+
+            void process (juce::AudioBuffer<float>& buffer, int numSamples)
+            {
+                for (auto& group : groups)
+                {
+                    juce::AudioBuffer<float> channels (buffer.getArrayOfWritePointers() + group.firstChannel, group.numChannels, numSamples);
+                    group.processor->processBlock (channels, midi);
+                }
+            }
+
+        private:
+            /** The table is baked in the background and the processor uses the exact path
+                until it's ready, which would make offline renders depend on thread timing.
+                Feed silence until the table has been picked up, the caller then prepares
+                again to clear whatever state that left behind. */
+            void waitForLookupTable (WavefolderProcessor& processor, int numChannels, int blockSize)
+            {
+                const bool usesTable = processor.apvts.getRawParameterValue (Parameters::lutId)->load() >= 0.5f
+                                    && (int) processor.apvts.getRawParameterValue (Parameters::aaModeId)->load() == 0;
+
+                if (! usesTable)
+                    return;
+
+                juce::AudioBuffer<float> silence (numChannels, blockSize);
+                const auto timeout = juce::Time::getMillisecondCounter() + 10000;
+
+                while (! processor.isLutReady() && juce::Time::getMillisecondCounter() < timeout)
+                {
+                    silence.clear();
+                    processor.processBlock (silence, midi);
+                    juce::Thread::sleep (1);
+                }
+
+                silence.clear();
+                processor.processBlock (silence, midi);
+            }
+
+            struct Group
+            {
+                std::unique_ptr<WavefolderProcessor> processor;
+                int firstChannel, numChannels;
+            };
+
+            std::vector<Group> groups;
+            juce::MidiBuffer midi;
+        };
+    }
+
+    //==============================================================================
+    struct BatchRenderer::Segment
+    {
+        int fileIndex;
+        juce::int64 start, length;
+        juce::File output;
+        juce::Result status = juce::Result::ok();
+    };
+
+    BatchRenderer::BatchRenderer (RenderSettings s) : settings (std::move (s))
+    {
+        formatManager.registerBasicFormats();
+        settings.blockSize = juce::jmax (16, settings.blockSize);
+        settings.numThreads = juce::jmax (1, settings.numThreads);
+    }
+
+    juce::Result BatchRenderer::applyParameters (WavefolderProcessor& processor, const juce::StringPairArray& parameters)
+    {
+        for (const auto& id : parameters.getAllKeys())
+        {
+            auto* param = processor.apvts.getParameter (id);
+
+            if (param == nullptr)
+                return juce::Result::fail ("Unknown parameter: " + id);
+
+            const auto text = parameters[id].trim();
+            float normalised;
+
+            if (text.containsOnly ("0123456789.-+eE") && text.isNotEmpty())
+                normalised = param->convertTo0to1 (param->getNormalisableRange().snapToLegalValue (text.getFloatValue()));
+            else
+                normalised = param->getValueForText (text);
+
+            if (! (normalised >= 0.0f && normalised <= 1.0f))
+                return juce::Result::fail ("Invalid value for " + id + ": " + text);
+
+            param->setValueNotifyingHost (normalised);
+        }
+
+        return juce::Result::ok();
+    }
+
+    juce::Result BatchRenderer::validateSettings() const
+    {
+        WavefolderProcessor processor;
+        return applyParameters (processor, settings.parameters);
+    }
+
+    bool BatchRenderer::isStateless() const
+    {
+        WavefolderProcessor processor;
+        applyParameters (processor, settings.parameters);
+
+        return ! processor.hasState();
+    }
+
+    //==============================================================================
+    juce::File BatchRenderer::getOutputFile (const juce::File& input) const
+    {
+        const auto folder = settings.outputFolder == juce::File() ? input.getParentDirectory() : settings.outputFolder;
+
+        juce::String extension = input.getFileExtension().toLowerCase();
+
+        if (settings.outputFormat.isNotEmpty())
+            extension = "." + settings.outputFormat.toLowerCase();
+        else if (extension != ".flac")
+            extension = ".wav";
+
+        return folder.getChildFile (input.getFileNameWithoutExtension() + "_folded" + extension);
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> BatchRenderer::createWriter (const juce::File& file, const juce::AudioFormatReader& source, bool intermediate) const
+    {
+        const bool flac = ! intermediate && file.hasFileExtension ("flac");
+
+        // Segments are stored as float so concatenating them doesn't add a rounding step
+        int bits = intermediate ? 32 : (settings.bitsPerSample > 0 ? settings.bitsPerSample : (int) source.bitsPerSample);
+
+        if (flac)
+            bits = juce::jmin (24, bits);
+
+        std::unique_ptr<juce::AudioFormat> format;
+
+        if (flac)
+            format = std::make_unique<juce::FlacAudioFormat>();
+        else
+            format = std::make_unique<juce::WavAudioFormat>();
+
+        file.deleteFile();
+        auto stream = file.createOutputStream();
+
+        if (stream == nullptr)
+            return nullptr;
+
+        std::unique_ptr<juce::OutputStream> output (std::move (stream));
+        std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (output.get(), source.sampleRate, source.numChannels,
+                                                                                  bits, intermediate ? juce::StringPairArray() : source.metadataValues, 0));
+
+        // The writer owns the stream once it was created
+        if (writer != nullptr)
+            output.release();
+
+        return writer;
+    }
+
+    //==============================================================================
+    juce::Result BatchRenderer::renderRange (const juce::File& input, juce::int64 start, juce::int64 length, juce::AudioFormatWriter& writer) const
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (input));
+
+        if (reader == nullptr)
+            return juce::Result::fail ("Can't read " + input.getFullPathName());
+
+        const int numChannels = (int) reader->numChannels;
+        const int blockSize = settings.blockSize;
+
+        ProcessorChain chain;
+
+        // Formats without a channel mask come back as discrete channels
+        auto fileLayout = reader->getChannelLayout();
+
+        if (fileLayout.size() != numChannels)
+            fileLayout = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+
+        if (auto result = chain.prepare (fileLayout, reader->sampleRate, blockSize, settings.parameters); result.failed())
+            return result;
+
+        // Run `latency` samples past the end (the reader pads with silence) and drop
+        // as many from the start, so the output lines up with the input
+        const int latency = chain.getLatencySamples();
+        const juce::int64 end = start + length + latency;
+
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        juce::int64 toSkip = latency;
+
+        for (juce::int64 position = start; position < end; position += blockSize)
+        {
+            const int numSamples = (int) juce::jmin ((juce::int64) blockSize, end - position);
+
+            reader->read (&buffer, 0, numSamples, position, true, true);
+            chain.process (buffer, numSamples);
+
+            const int skip = (int) juce::jmin ((juce::int64) numSamples, toSkip);
+            toSkip -= skip;
+
+            if (skip < numSamples && ! writer.writeFromAudioSampleBuffer (buffer, skip, numSamples - skip))
+                return juce::Result::fail ("Write error");
+        }
+
+        return juce::Result::ok();
+    }
+
+    juce::Result BatchRenderer::concatenate (const juce::Array<juce::File>& parts, juce::AudioFormatWriter& writer) const
+    {
+        juce::AudioBuffer<float> buffer ((int) writer.getNumChannels(), settings.blockSize);
+
+        for (const auto& part : parts)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (part));
+
+            if (reader == nullptr)
+                return juce::Result::fail ("Can't read segment " + part.getFullPathName());
+
+            for (juce::int64 position = 0; position < reader->lengthInSamples; position += settings.blockSize)
+            {
+                const int numSamples = (int) juce::jmin ((juce::int64) settings.blockSize, reader->lengthInSamples - position);
+                reader->read (&buffer, 0, numSamples, position, true, true);
+
+                if (! writer.writeFromAudioSampleBuffer (buffer, 0, numSamples))
+                    return juce::Result::fail ("Write error");
+            }
+        }
+
+        return juce::Result::ok();
+    }
+
+    //==============================================================================
+    std::vector<RenderResult> BatchRenderer::render (const juce::Array<juce::File>& inputs)
+    {
+        std::vector<RenderResult> results ((size_t) inputs.size());
+        std::vector<Segment> segments;
+
+        const bool canSplit = settings.splitLongFiles && isStateless();
+
+        // Plan: one job per file, or per segment of a long file when splitting is allowed
+        for (int i = 0; i < inputs.size(); ++i)
+        {
+            auto& result = results[(size_t) i];
+            result.input = inputs[i];
+            result.output = getOutputFile (inputs[i]);
+
+            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (inputs[i]));
+
+            if (reader == nullptr)
+            {
+                result.status = juce::Result::fail ("Can't read " + inputs[i].getFullPathName());
+                continue;
+            }
+
+            result.audioSeconds = (double) reader->lengthInSamples / reader->sampleRate;
+
+            const auto minSegment = (juce::int64) (settings.minSegmentSeconds * reader->sampleRate);
+            const auto maxSegments = canSplit ? juce::jmax ((juce::int64) 1, reader->lengthInSamples / juce::jmax ((juce::int64) 1, minSegment)) : 1;
+            result.numSegments = (int) juce::jmin ((juce::int64) settings.numThreads, maxSegments);
+
+            if (result.numSegments == 1)
+            {
+                segments.push_back ({ i, 0, reader->lengthInSamples, result.output });
+                continue;
+            }
+
+            const auto segmentLength = (reader->lengthInSamples + result.numSegments - 1) / result.numSegments;
+
+            for (int s = 0; s < result.numSegments; ++s)
+            {
+                const auto start = s * segmentLength;
+                const auto part = result.output.getSiblingFile (result.output.getFileNameWithoutExtension() + ".part" + juce::String (s) + ".wav");
+                segments.push_back ({ i, start, juce::jmin (segmentLength, reader->lengthInSamples - start), part });
+            }
+        }
+
+        // Render everything on the pool, keeping track of when each file started and finished
+        std::vector<juce::Range<double>> fileTimes ((size_t) inputs.size());
+        juce::CriticalSection timesLock;
+
+        {
+            juce::ThreadPool pool (settings.numThreads);
+
+            for (auto& segment : segments)
+            {
+                if (results[(size_t) segment.fileIndex].status.failed())
+                    continue;
+
+                pool.addJob ([this, &segment, &results, &inputs, &fileTimes, &timesLock]
+                {
+                    const auto jobStart = juce::Time::getMillisecondCounterHiRes();
+                    const auto& result = results[(size_t) segment.fileIndex];
+                    const bool intermediate = result.numSegments > 1;
+
+                    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (inputs[segment.fileIndex]));
+                    auto writer = reader != nullptr ? createWriter (segment.output, *reader, intermediate) : nullptr;
+
+                    if (writer == nullptr)
+                        segment.status = juce::Result::fail ("Can't write " + segment.output.getFullPathName());
+                    else
+                        segment.status = renderRange (inputs[segment.fileIndex], segment.start, segment.length, *writer);
+
+                    const juce::Range<double> jobTime (jobStart, juce::Time::getMillisecondCounterHiRes());
+
+                    const juce::ScopedLock sl (timesLock);
+                    auto& fileTime = fileTimes[(size_t) segment.fileIndex];
+                    fileTime = fileTime.isEmpty() ? jobTime : fileTime.getUnionWith (jobTime);
+                });
+            }
+
+            // Wait for everything, the pool's destructor would drop jobs that haven't started
+            while (pool.getNumJobs() > 0)
+                juce::Thread::sleep (10);
+        }
+
+        // Collect the results, joining the segments of split files in order
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            auto& result = results[i];
+
+            if (result.status.failed())
+                continue;
+
+            juce::Array<juce::File> parts;
+
+            for (const auto& segment : segments)
+            {
+                if (segment.fileIndex != (int) i)
+                    continue;
+
+                if (segment.status.failed() && result.status.wasOk())
+                    result.status = segment.status;
+
+                parts.add (segment.output);
+            }
+
+            if (result.numSegments > 1)
+            {
+                if (result.status.wasOk())
+                {
+                    std::unique_ptr<juce::AudioFormatReader> source (formatManager.createReaderFor (result.input));
+                    auto writer = source != nullptr ? createWriter (result.output, *source, false) : nullptr;
+
+                    result.status = writer != nullptr ? concatenate (parts, *writer)
+                                                      : juce::Result::fail ("Can't write " + result.output.getFullPathName());
+                }
+
+                for (const auto& part : parts)
+                    part.deleteFile();
+
+                fileTimes[i] = fileTimes[i].withEnd (juce::Time::getMillisecondCounterHiRes());
+            }
+
+            result.renderSeconds = fileTimes[i].getLength() / 1000.0;
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    juce::Result loadPreset (const juce::File& file, juce::StringPairArray& parameters)
+    {
+        if (! file.existsAsFile())
+            return juce::Result::fail ("Preset not found: " + file.getFullPathName());
+
+        if (auto xml = juce::parseXML (file))
+        {
+            for (auto* param : xml->getChildWithTagNameIterator ("PARAM"))
+                parameters.set (param->getStringAttribute ("id"), param->getStringAttribute ("value"));
+
+            return juce::Result::ok();
+        }
+
+        juce::var json;
+
+        if (auto result = juce::JSON::parse (file.loadFileAsString(), json); result.failed())
+            return juce::Result::fail ("Can't parse preset " + file.getFileName() + ": " + result.getErrorMessage());
+
+        if (auto* object = json.getDynamicObject())
+        {
+            for (const auto& property : object->getProperties())
+                parameters.set (property.name.toString(), property.value.toString());
+
+            return juce::Result::ok();
+        }
+
+        return juce::Result::fail ("Preset " + file.getFileName() + " is not a JSON object");
+    }
+}
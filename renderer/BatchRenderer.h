@@ -0,0 +1,82 @@
+#pragma once
+
+#include "PluginProcessor.h"
+
+namespace Renderer
+{
+    //==============================================================================
+    struct RenderSettings
+    {
+        /** Parameter ID -> value as text, either a plain number in the parameter's own
+            range (choice index for choices) or the text the parameter displays. */
+        juce::StringPairArray parameters;
+
+        juce::File outputFolder;        // Empty: next to each input file
+        juce::String outputFormat;      // "wav" or "flac", empty: same as the input
+        int bitsPerSample = 0;          // 0: same as the input
+
+        int blockSize = 4096;           // Samples per decode/processBlock/encode chunk
+        int numThreads = 1;
+
+        /** Render long files as several segments in parallel. Only used when the settings
+            are stateless (see WavefolderProcessor::hasState: no ADAA history, oversampling,
+            crossover or output stage filters, no envelope modulation), since only then are
+            the segments identical to a sequential render (up to the silence bypass, whose
+            error stays below its -120 dB threshold). */
+        bool splitLongFiles = false;
+        double minSegmentSeconds = 10.0;
+    };
+
+    struct RenderResult
+    {
+        juce::File input, output;
+        juce::Result status = juce::Result::ok();
+        double audioSeconds = 0.0;
+        double renderSeconds = 0.0;
+        int numSegments = 1;
+
+        double getRealtimeFactor() const noexcept { return renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0; }
+    };
+
+    //==============================================================================
+    /** Renders files through WavefolderProcessor on a pool of worker threads.
+
+        Files are decoded, processed and encoded in blocks of RenderSettings::blockSize
+        samples, so memory use doesn't depend on the file length. The processor latency
+        is compensated, so outputs line up with their inputs sample for sample.
+    */
+    class BatchRenderer
+    {
+    public:
+        explicit BatchRenderer (RenderSettings settings);
+
+        /** Checks the parameter IDs and values before anything is rendered. */
+        juce::Result validateSettings() const;
+
+        /** Renders every file, blocking until all of them are done. Results are in
+            the same order as the inputs. */
+        std::vector<RenderResult> render (const juce::Array<juce::File>& inputs);
+
+        /** Applies the parameter settings to a processor, shared with the preset loader. */
+        static juce::Result applyParameters (WavefolderProcessor& processor, const juce::StringPairArray& parameters);
+
+    private:
+        struct Segment;
+
+        bool isStateless() const;
+        juce::File getOutputFile (const juce::File& input) const;
+        std::unique_ptr<juce::AudioFormatWriter> createWriter (const juce::File& file, const juce::AudioFormatReader& source, bool intermediate) const;
+
+        juce::Result renderRange (const juce::File& input, juce::int64 start, juce::int64 length, juce::AudioFormatWriter& writer) const;
+        juce::Result concatenate (const juce::Array<juce::File>& parts, juce::AudioFormatWriter& writer) const;
+
+        RenderSettings settings;
+        juce::AudioFormatManager formatManager;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchRenderer)
+    };
+
+    /** Reads parameter settings from a preset file: either the processor state XML
+        (<PARAM id="..." value="..."/> children) or a flat JSON object of id -> value. */
+    juce::Result loadPreset (const juce::File& file, juce::StringPairArray& parameters);
+}
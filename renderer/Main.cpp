@@ -0,0 +1,166 @@
+/*  Offline batch renderer: runs audio files through the Wavefolder without a DAW.
+
+        WavefolderRenderer [options] <files or folders...>
+
+        --output-dir=<folder>   Where to write the results (default: next to each input)
+        --format=wav|flac       Output format (default: same as the input, WAV for anything but FLAC)
+        --bits=<n>              Output bit depth (default: same as the input)
+        --preset=<file>         Parameter settings, processor state XML or a JSON object of id -> value
+        --<parameter id>=<v>    Any plugin parameter, e.g. --drive=12 --wavefolder=SinFold --oversampling=2
+        --jobs=<n>              Worker threads (default: one per core)
+        --block-size=<n>        Samples per decode/process/encode chunk (default 4096)
+        --split                 Also render long files in parallel segments when the settings are
+                                stateless (ADAA, oversampling, multiband, envelope depths,
+                                DC blocker and limiter all off)
+
+    Command line parameters override the preset. Outputs are named <input>_folded.<ext>.
+*/
+
+#include "BatchRenderer.h"
+
+#include <iostream>
+
+namespace
+{
+    const juce::String audioFilePattern ("*.wav;*.flac;*.aif;*.aiff");
+
+    juce::File getFileOption (const juce::ArgumentList& args, const juce::String& option)
+    {
+        return juce::File::getCurrentWorkingDirectory().getChildFile (args.getValueForOption (option).unquoted());
+    }
+
+    juce::Array<juce::File> collectInputs (const juce::ArgumentList& args)
+    {
+        juce::Array<juce::File> inputs;
+
+        for (const auto& arg : args.arguments)
+        {
+            if (arg.isOption())
+                continue;
+
+            const auto file = arg.resolveAsFile();
+
+            if (file.isDirectory())
+            {
+                auto found = file.findChildFiles (juce::File::findFiles, true, audioFilePattern);
+                found.sort();
+                inputs.addArray (found);
+            }
+            else
+            {
+                inputs.add (file);
+            }
+        }
+
+        return inputs;
+    }
+
+    juce::Result parseSettings (const juce::ArgumentList& args, Renderer::RenderSettings& settings)
+    {
+        if (args.containsOption ("--preset"))
+            if (auto result = Renderer::loadPreset (getFileOption (args, "--preset"), settings.parameters); result.failed())
+                return result;
+
+        // Every processor parameter can be set directly
+        WavefolderProcessor processor;
+
+        for (auto* param : processor.getParameters())
+        {
+            if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*> (param))
+            {
+                const auto option = "--" + withId->paramID;
+
+                if (args.containsOption (option))
+                    settings.parameters.set (withId->paramID, args.getValueForOption (option));
+            }
+        }
+
+        if (args.containsOption ("--output-dir"))
+        {
+            settings.outputFolder = getFileOption (args, "--output-dir");
+
+            if (! settings.outputFolder.createDirectory())
+                return juce::Result::fail ("Can't create " + settings.outputFolder.getFullPathName());
+        }
+
+        if (args.containsOption ("--format"))
+        {
+            settings.outputFormat = args.getValueForOption ("--format").toLowerCase();
+
+            if (settings.outputFormat != "wav" && settings.outputFormat != "flac")
+                return juce::Result::fail ("Unsupported output format: " + settings.outputFormat);
+        }
+
+        if (args.containsOption ("--bits"))
+            settings.bitsPerSample = args.getValueForOption ("--bits").getIntValue();
+
+        settings.numThreads = juce::jmax (1, args.containsOption ("--jobs") ? args.getValueForOption ("--jobs").getIntValue()
+                                                                            : juce::SystemStats::getNumCpus());
+
+        if (args.containsOption ("--block-size"))
+            settings.blockSize = args.getValueForOption ("--block-size").getIntValue();
+
+        settings.splitLongFiles = args.containsOption ("--split");
+        return juce::Result::ok();
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    Renderer::RenderSettings settings;
+
+    if (auto result = parseSettings (args, settings); result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    const auto inputs = collectInputs (args);
+
+    if (inputs.isEmpty())
+    {
+        std::cerr << "Usage: " << args.executableName << " [options] <files or folders...>" << std::endl;
+        return 1;
+    }
+
+    Renderer::BatchRenderer renderer (settings);
+
+    if (auto result = renderer.validateSettings(); result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    const auto results = renderer.render (inputs);
+    const auto totalSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    double totalAudioSeconds = 0.0;
+    int numFailed = 0;
+
+    for (const auto& result : results)
+    {
+        if (result.status.failed())
+        {
+            std::cerr << result.input.getFullPathName() << ": " << result.status.getErrorMessage() << std::endl;
+            ++numFailed;
+            continue;
+        }
+
+        totalAudioSeconds += result.audioSeconds;
+
+        std::cout << result.output.getFullPathName() << ": " << juce::String (result.audioSeconds, 2) << " s of audio in "
+                  << juce::String (result.renderSeconds, 2) << " s (" << juce::String (result.getRealtimeFactor(), 1) << "x realtime"
+                  << (result.numSegments > 1 ? ", " + juce::String (result.numSegments) + " segments" : juce::String()) << ")" << std::endl;
+    }
+
+    std::cout << results.size() - (size_t) numFailed << " file(s) rendered, " << juce::String (totalAudioSeconds, 2) << " s of audio in "
+              << juce::String (totalSeconds, 2) << " s on " << settings.numThreads << " thread(s): "
+              << juce::String (totalSeconds > 0.0 ? totalAudioSeconds / totalSeconds : 0.0, 1) << "x realtime" << std::endl;
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,355 @@
+/*  Headless real-time safety check of the processor.
+
+        WavefolderRtCheck [--quick] [--seed=<n>]
+
+    Built with WAVEFOLDER_RT_CHECK=1 and the allocator & lock hooks of RealtimeHooks.cpp,
+    so every allocation, deallocation or mutex lock made by processBlock is reported with
+    a stack trace (see source/perf/RealtimeCheck.h).
+
+    Each bus layout & precision below is driven through the same phases, blocks of random
+    lengths up to the prepared size and a fresh input each time, as a host would:
+      - "defaults":       the processor as constructed
+      - "sweeps":         every parameter from 0 to 1 in steps, one at a time
+      - "algorithms":     every fold type, AA mode, oversampling factor, LUT and band setting
+                          combined, with the envelope modulating and the output stages
+                          switched in turn
+      - "automation":     random parameters changed every block, half of them through
+                          sample-accurate CLAP events
+      - "presets":        every program, switched while playing
+      - "silence":        into the silence bypass and back out
+
+    Parameters are set from outside the callback like a host's UI or automation thread
+    would. Prints the violations per phase and exits with 1 if there were any.
+*/
+
+#include "PluginProcessor.h"
+
+#include <iostream>
+
+#if ! WAVEFOLDER_RT_CHECK
+ #error "WavefolderRtCheck must be built with WAVEFOLDER_RT_CHECK=1"
+#endif
+
+namespace
+{
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        bool quick = false;
+        juce::int64 seed = 1;
+    };
+
+    struct Layout
+    {
+        const char* name;
+        juce::AudioChannelSet channels;
+        bool sidechain;
+        bool doublePrecision;
+        int maxBlockSize;
+    };
+
+    std::vector<Layout> getLayouts (const Settings& settings)
+    {
+        if (settings.quick)
+            return { { "stereo", juce::AudioChannelSet::stereo(), true, false, 512 } };
+
+        return { { "mono", juce::AudioChannelSet::mono(), false, false, 64 },
+                 { "stereo", juce::AudioChannelSet::stereo(), false, false, 512 },
+                 { "stereo, double precision", juce::AudioChannelSet::stereo(), false, true, 512 },
+                 { "stereo with sidechain", juce::AudioChannelSet::stereo(), true, false, 256 },
+                 { "7.1.4", juce::AudioChannelSet::create7point1point4(), false, false, 480 } };
+    }
+
+    //==============================================================================
+    /** One processor and what a host keeps around it: the buffers, the input signal and
+        the automation events it hands over, all allocated up front. */
+    template <typename SampleType>
+    class Host
+    {
+    public:
+        Host (const Layout& layout, const Settings& settings)
+            : maxBlockSize (layout.maxBlockSize), random (settings.seed)
+        {
+            processor.setProcessingPrecision (layout.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                     : juce::AudioProcessor::singlePrecision);
+
+            auto buses = processor.getBusesLayout();
+            buses.inputBuses.getReference (0) = layout.channels;
+            buses.outputBuses.getReference (0) = layout.channels;
+
+            if (layout.sidechain)
+                buses.inputBuses.getReference (1) = juce::AudioChannelSet::stereo();
+            else
+                buses.inputBuses.getReference (1) = juce::AudioChannelSet::disabled();
+
+            supported = processor.setBusesLayout (buses);
+
+            processor.setRateAndBufferSizeDetails (settings.sampleRate, maxBlockSize);
+            processor.prepareToPlay (settings.sampleRate, maxBlockSize);
+
+            const int numChannels = juce::jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+            buffer.setSize (numChannels, maxBlockSize);
+            increment = 110.0 / settings.sampleRate;
+        }
+
+        ~Host() { processor.releaseResources(); }
+
+        bool isSupported() const noexcept { return supported; }
+
+        WavefolderProcessor& getProcessor() noexcept { return processor; }
+        juce::Random& getRandom() noexcept { return random; }
+
+        void setParameter (juce::AudioProcessorParameter& param, float normalisedValue)
+        {
+            param.setValueNotifyingHost (normalisedValue);
+        }
+
+        void setParameter (const char* id, float value)
+        {
+            auto* param = processor.apvts.getParameter (id);
+            param->setValueNotifyingHost (param->convertTo0to1 (value));
+        }
+
+        /** Queued as a CLAP event at a random offset of the next block. */
+        void automate (juce::AudioProcessorParameterWithID& param, float normalisedValue)
+        {
+            if (numEvents >= (int) events.size())
+                return;
+
+            auto& event = events[(size_t) numEvents++];
+            event = {};
+            event.header.size = sizeof (clap_event_param_value_t);
+            event.header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+            event.header.type = CLAP_EVENT_PARAM_VALUE;
+            event.param_id = (clap_id) param.paramID.hashCode();
+            event.value = normalisedValue;
+        }
+
+        /** One callback of a random length, with a sawtooth input or silence. */
+        void process (int numBlocks, bool silent = false)
+        {
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                const int numSamples = random.nextInt ({ 1, maxBlockSize + 1 });
+                fillInput (numSamples, silent);
+
+                juce::AudioBuffer<SampleType> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+
+                // The wrapper delivers the events on the audio thread just before processBlock
+                const Perf::ScopedRealtimeSection callback;
+
+                for (int e = 0; e < numEvents; ++e)
+                    processor.handleDirectEvent (&events[(size_t) e].header, random.nextInt (numSamples));
+
+                numEvents = 0;
+                processor.processBlock (block, midi);
+            }
+        }
+
+    private:
+        void fillInput (int numSamples, bool silent)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto sample = silent ? SampleType (0) : (SampleType) (0.8 * (2.0 * phase - 1.0));
+                phase += increment;
+                phase -= std::floor (phase);
+
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    buffer.setSample (ch, i, sample * (SampleType) (1.0 - 0.05 * ch));
+            }
+        }
+
+        WavefolderProcessor processor;
+        const int maxBlockSize;
+        bool supported = false;
+
+        juce::AudioBuffer<SampleType> buffer;
+        juce::MidiBuffer midi;
+        double phase = 0.0, increment = 0.0;
+
+        std::array<clap_event_param_value_t, 16> events;
+        int numEvents = 0;
+
+        juce::Random random;
+    };
+
+    //==============================================================================
+    template <typename SampleType>
+    void runDefaults (Host<SampleType>& host, const Settings&)
+    {
+        host.process (50);
+    }
+
+    template <typename SampleType>
+    void runSweeps (Host<SampleType>& host, const Settings& settings)
+    {
+        const int numSteps = settings.quick ? 4 : 16;
+
+        for (auto* param : host.getProcessor().getParameters())
+        {
+            for (int step = 0; step <= numSteps; ++step)
+            {
+                host.setParameter (*param, (float) step / (float) numSteps);
+                host.process (2);
+            }
+
+            host.setParameter (*param, param->getDefaultValue());
+            host.process (2);
+        }
+    }
+
+    template <typename SampleType>
+    void runAlgorithms (Host<SampleType>& host, const Settings& settings)
+    {
+        host.setParameter (Parameters::driveId, 12.0f);
+        host.setParameter (Parameters::envDriveDepthId, 12.0f);
+        host.setParameter (Parameters::envThresDepthId, -0.5f);
+
+        const int numFactors = settings.quick ? 2 : FoldDSP::Oversampler::numFactors;
+
+        for (int type = 0; type <= Parameters::wfTypeMorph; ++type)
+            for (int aa = 0; aa < 3; ++aa)
+                for (int os = 0; os < numFactors; ++os)
+                    for (int lut = 0; lut < 2; ++lut)
+                        for (int bands = 0; bands < Parameters::maxBands; bands += settings.quick ? 3 : 1)
+                        {
+                            host.setParameter (Parameters::wfTypeId, (float) type);
+                            host.setParameter (Parameters::aaModeId, (float) aa);
+                            host.setParameter (Parameters::osId, (float) os);
+                            host.setParameter (Parameters::osPhaseId, (float) (os % 2));
+                            host.setParameter (Parameters::lutId, (float) lut);
+                            host.setParameter (Parameters::bandsId, (float) bands);
+                            host.setParameter (Parameters::envSourceId, (float) (bands % 2));
+                            host.setParameter (Parameters::dcBlockId, (float) lut);
+                            host.setParameter (Parameters::limiterId, (float) ((aa + os) % 2));
+                            host.setParameter (Parameters::stereoModeId, (float) ((type + lut) % 3));
+                            host.process (2);
+                        }
+
+        for (auto* param : host.getProcessor().getParameters())
+            host.setParameter (*param, param->getDefaultValue());
+    }
+
+    template <typename SampleType>
+    void runAutomation (Host<SampleType>& host, const Settings& settings)
+    {
+        const auto& params = host.getProcessor().getParameters();
+        auto& random = host.getRandom();
+
+        for (int b = 0; b < (settings.quick ? 200 : 2000); ++b)
+        {
+            for (int n = random.nextInt ({ 1, 4 }); --n >= 0;)
+            {
+                auto* param = params[random.nextInt (params.size())];
+
+                if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*> (param); withId != nullptr && random.nextBool())
+                    host.automate (*withId, random.nextFloat());
+                else
+                    host.setParameter (*param, random.nextFloat());
+            }
+
+            host.process (1);
+        }
+
+        for (auto* param : params)
+            host.setParameter (*param, param->getDefaultValue());
+    }
+
+    template <typename SampleType>
+    void runPresets (Host<SampleType>& host, const Settings&)
+    {
+        auto& processor = host.getProcessor();
+
+        for (int program = 0; program < processor.getNumPrograms(); ++program)
+        {
+            processor.setCurrentProgram (program);
+            host.process (20);
+        }
+
+        processor.setCurrentProgram (0);
+        host.process (2);
+    }
+
+    template <typename SampleType>
+    void runSilence (Host<SampleType>& host, const Settings& settings)
+    {
+        // Long enough for the bypass to kick in whatever the latency
+        const int numBlocks = juce::roundToInt (settings.sampleRate / 64.0);
+
+        host.process (numBlocks, true);
+        host.process (20);
+    }
+
+    //==============================================================================
+    /** Returns the number of violations, or -1 if the layout couldn't be set up. */
+    template <typename SampleType>
+    int runLayout (const Layout& layout, const Settings& settings)
+    {
+        Host<SampleType> host (layout, settings);
+
+        if (! host.isSupported())
+        {
+            std::cerr << layout.name << ": layout not supported" << std::endl;
+            return -1;
+        }
+
+        using Phase = void (*) (Host<SampleType>&, const Settings&);
+        const std::pair<const char*, Phase> phases[] = { { "defaults", runDefaults<SampleType> },
+                                                         { "sweeps", runSweeps<SampleType> },
+                                                         { "algorithms", runAlgorithms<SampleType> },
+                                                         { "automation", runAutomation<SampleType> },
+                                                         { "presets", runPresets<SampleType> },
+                                                         { "silence", runSilence<SampleType> } };
+        int total = 0;
+
+        for (const auto& [name, run] : phases)
+        {
+            Perf::resetRealtimeViolations();
+            run (host, settings);
+
+            const int numViolations = Perf::getNumRealtimeViolations();
+            total += numViolations;
+
+            std::cout << layout.name << ", " << name << ": " << (numViolations == 0 ? juce::String ("ok")
+                                                                                  : juce::String (numViolations) + " violation(s)") << std::endl;
+        }
+
+        return total;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    Settings settings;
+    settings.quick = args.containsOption ("--quick");
+
+    if (args.containsOption ("--seed"))
+        settings.seed = args.getValueForOption ("--seed").getLargeIntValue();
+
+    int numViolations = 0;
+
+    for (const auto& layout : getLayouts (settings))
+    {
+        const int result = layout.doublePrecision ? runLayout<double> (layout, settings)
+                                                  : runLayout<float> (layout, settings);
+
+        if (result < 0)
+            return 1;
+
+        numViolations += result;
+    }
+
+    if (numViolations > 0)
+    {
+        std::cerr << numViolations << " real-time violation(s), see the stack traces above" << std::endl;
+        return 1;
+    }
+
+    std::cout << "No allocations or locks in the audio callback" << std::endl;
+    return 0;
+}
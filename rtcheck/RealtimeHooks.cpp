@@ -0,0 +1,249 @@
+/*  Allocator and lock hooks of the real-time checker, linked into WavefolderRtCheck only.
+
+    Every platform gets the replaceable global operator new/delete. With glibc, malloc & co.
+    are interposed too (forwarding to glibc's own __libc_ entry points) and so is
+    pthread_mutex_lock, which juce::CriticalSection and std::mutex both end up in. Elsewhere
+    only the C++ allocations are seen.
+*/
+
+#include "perf/RealtimeCheck.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+#if defined (__GLIBC__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #define WAVEFOLDER_RT_CHECK_HOOK_LIBC 1
+#else
+ #define WAVEFOLDER_RT_CHECK_HOOK_LIBC 0
+#endif
+
+#if WAVEFOLDER_RT_CHECK_HOOK_LIBC
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+}
+#endif
+
+namespace
+{
+    // The real allocator, below the malloc hooks so nothing is reported twice
+    void* allocate (size_t size) noexcept
+    {
+       #if WAVEFOLDER_RT_CHECK_HOOK_LIBC
+        return __libc_malloc (size == 0 ? 1 : size);
+       #else
+        return std::malloc (size == 0 ? 1 : size);
+       #endif
+    }
+
+    void deallocate (void* p) noexcept
+    {
+       #if WAVEFOLDER_RT_CHECK_HOOK_LIBC
+        __libc_free (p);
+       #else
+        std::free (p);
+       #endif
+    }
+
+    void* allocateAligned (size_t size, std::align_val_t alignment) noexcept
+    {
+        const auto bytes = juce::jmax ((size_t) alignment, sizeof (void*));
+
+       #if WAVEFOLDER_RT_CHECK_HOOK_LIBC
+        return __libc_memalign (bytes, size == 0 ? 1 : size);
+       #elif JUCE_WINDOWS
+        return _aligned_malloc (size == 0 ? 1 : size, bytes);
+       #else
+        void* p = nullptr;
+        return posix_memalign (&p, bytes, size == 0 ? 1 : size) == 0 ? p : nullptr;
+       #endif
+    }
+
+    void deallocateAligned (void* p) noexcept
+    {
+       #if JUCE_WINDOWS
+        _aligned_free (p);
+       #else
+        deallocate (p);
+       #endif
+    }
+
+    //==============================================================================
+    void* checkedNew (size_t size, const char* call)
+    {
+        Perf::checkRealtimeCall (call);
+
+        if (auto* p = allocate (size))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    void* checkedNew (size_t size, std::align_val_t alignment, const char* call)
+    {
+        Perf::checkRealtimeCall (call);
+
+        if (auto* p = allocateAligned (size, alignment))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    void checkedDelete (void* p, const char* call) noexcept
+    {
+        // Deleting nullptr is a no-op, and common enough in destructors
+        if (p == nullptr)
+            return;
+
+        Perf::checkRealtimeCall (call);
+        deallocate (p);
+    }
+
+    void checkedDeleteAligned (void* p, const char* call) noexcept
+    {
+        if (p == nullptr)
+            return;
+
+        Perf::checkRealtimeCall (call);
+        deallocateAligned (p);
+    }
+}
+
+//==============================================================================
+void* operator new (size_t size)                                             { return checkedNew (size, "operator new"); }
+void* operator new[] (size_t size)                                           { return checkedNew (size, "operator new[]"); }
+void* operator new (size_t size, std::align_val_t alignment)                 { return checkedNew (size, alignment, "operator new"); }
+void* operator new[] (size_t size, std::align_val_t alignment)               { return checkedNew (size, alignment, "operator new[]"); }
+
+void* operator new (size_t size, const std::nothrow_t&) noexcept
+{
+    Perf::checkRealtimeCall ("operator new");
+    return allocate (size);
+}
+
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept
+{
+    Perf::checkRealtimeCall ("operator new[]");
+    return allocate (size);
+}
+
+void* operator new (size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    Perf::checkRealtimeCall ("operator new");
+    return allocateAligned (size, alignment);
+}
+
+void* operator new[] (size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    Perf::checkRealtimeCall ("operator new[]");
+    return allocateAligned (size, alignment);
+}
+
+void operator delete (void* p) noexcept                                      { checkedDelete (p, "operator delete"); }
+void operator delete[] (void* p) noexcept                                    { checkedDelete (p, "operator delete[]"); }
+void operator delete (void* p, size_t) noexcept                              { checkedDelete (p, "operator delete"); }
+void operator delete[] (void* p, size_t) noexcept                            { checkedDelete (p, "operator delete[]"); }
+void operator delete (void* p, const std::nothrow_t&) noexcept               { checkedDelete (p, "operator delete"); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept             { checkedDelete (p, "operator delete[]"); }
+
+void operator delete (void* p, std::align_val_t) noexcept                    { checkedDeleteAligned (p, "operator delete"); }
+void operator delete[] (void* p, std::align_val_t) noexcept                  { checkedDeleteAligned (p, "operator delete[]"); }
+void operator delete (void* p, size_t, std::align_val_t) noexcept            { checkedDeleteAligned (p, "operator delete"); }
+void operator delete[] (void* p, size_t, std::align_val_t) noexcept          { checkedDeleteAligned (p, "operator delete[]"); }
+void operator delete (void* p, std::align_val_t, const std::nothrow_t&) noexcept   { checkedDeleteAligned (p, "operator delete"); }
+void operator delete[] (void* p, std::align_val_t, const std::nothrow_t&) noexcept { checkedDeleteAligned (p, "operator delete[]"); }
+
+//==============================================================================
+#if WAVEFOLDER_RT_CHECK_HOOK_LIBC
+namespace
+{
+    using MutexLockFunction = int (*) (pthread_mutex_t*);
+
+    MutexLockFunction getNextMutexLock() noexcept
+    {
+        // Resolved on first use, which is at static initialisation time at the latest.
+        // dlsym() locks glibc's internal mutexes directly, not through this hook.
+        static std::atomic<MutexLockFunction> next { nullptr };
+        auto function = next.load (std::memory_order_relaxed);
+
+        if (function == nullptr)
+        {
+            function = reinterpret_cast<MutexLockFunction> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+            next.store (function, std::memory_order_relaxed);
+        }
+
+        return function;
+    }
+
+    [[maybe_unused]] const auto resolvedAtStartup = getNextMutexLock();
+}
+
+extern "C"
+{
+    void* malloc (size_t size) noexcept
+    {
+        Perf::checkRealtimeCall ("malloc");
+        return __libc_malloc (size);
+    }
+
+    void* calloc (size_t count, size_t size) noexcept
+    {
+        Perf::checkRealtimeCall ("calloc");
+        return __libc_calloc (count, size);
+    }
+
+    void* realloc (void* p, size_t size) noexcept
+    {
+        Perf::checkRealtimeCall ("realloc");
+        return __libc_realloc (p, size);
+    }
+
+    void free (void* p) noexcept
+    {
+        if (p != nullptr)
+            Perf::checkRealtimeCall ("free");
+
+        __libc_free (p);
+    }
+
+    void* memalign (size_t alignment, size_t size) noexcept
+    {
+        Perf::checkRealtimeCall ("memalign");
+        return __libc_memalign (alignment, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size) noexcept
+    {
+        Perf::checkRealtimeCall ("aligned_alloc");
+        return __libc_memalign (alignment, size);
+    }
+
+    int posix_memalign (void** result, size_t alignment, size_t size) noexcept
+    {
+        Perf::checkRealtimeCall ("posix_memalign");
+
+        if (alignment < sizeof (void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        *result = __libc_memalign (alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+    {
+        Perf::checkRealtimeCall ("pthread_mutex_lock");
+        return getNextMutexLock() (mutex);
+    }
+}
+#endif
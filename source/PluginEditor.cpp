@@ -5,7 +5,7 @@ PluginEditor::PluginEditor (WavefolderProcessor& p)
       processorRef (p)
 {
     juce::ignoreUnused (processorRef);
-    juce::LookAndFeel::setDefaultLookAndFeel(&myCustomLnF);
+    setLookAndFeel (&lookAndFeel.get());
     
     // --- LAYOUT ---
     header.setColour (juce::TextButton::buttonColourId, punk_dsp::UIConstants::background.brighter(0.5f)
@@ -23,14 +23,71 @@ PluginEditor::PluginEditor (WavefolderProcessor& p)
     params.setEnabled(false);
     addAndMakeVisible (params);
     
+    // Factory & user presets
+    refreshPresetList();
+    presetComboBox.onChange = [this]
+    {
+        const int index = presetComboBox.getSelectedItemIndex();
+        
+        if (index >= 0 && index != processorRef.getCurrentProgram())
+        {
+            processorRef.setCurrentProgram(index);
+            processorRef.updateHostDisplay(juce::AudioProcessor::ChangeDetails().withProgramChanged(true));
+        }
+    };
+    addAndMakeVisible(presetComboBox);
+    
+    savePresetButton.onClick = [this] { showSavePresetDialog(); };
+    addAndMakeVisible(savePresetButton);
+    
     // Waveshaper choices
     wfComboBox.addItem("FoldToRange", 1);
     wfComboBox.addItem("SinFold", 2);
     wfComboBox.addItem("ComboFold", 3);
+    wfComboBox.addItem("Morph", 4);
     addAndMakeVisible(wfComboBox);
     
     // Attach the ComboBox to the APVTS parameter
-    wfAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(processorRef.apvts, "wavefolder", wfComboBox);
+    wfAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(processorRef.apvts, Parameters::wfTypeId, wfComboBox);
+    
+    // Morph position, next to the type
+    morphSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    morphSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    morphSlider.setRange(Parameters::morphMin, Parameters::morphMax, 0.001);
+    morphSlider.setValue(Parameters::morphDefault);
+    morphSlider.setName("Morph");
+    addAndMakeVisible(morphSlider);
+    
+    morphAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, Parameters::morphId, morphSlider);
+    
+    // Oversampling choices
+    osComboBox.addItem("1x", 1);
+    osComboBox.addItem("2x", 2);
+    osComboBox.addItem("4x", 3);
+    osComboBox.addItem("8x", 4);
+    osComboBox.addItem("16x", 5);
+    addAndMakeVisible(osComboBox);
+    
+    osAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(processorRef.apvts, Parameters::osId, osComboBox);
+    
+    osPhaseComboBox.addItem("Minimum Phase", 1);
+    osPhaseComboBox.addItem("Linear Phase", 2);
+    addAndMakeVisible(osPhaseComboBox);
+    
+    osPhaseAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(processorRef.apvts, Parameters::osPhaseId, osPhaseComboBox);
+    
+    // Anti-aliasing choices
+    aaComboBox.addItem("AA Off", 1);
+    aaComboBox.addItem("ADAA 1st Order", 2);
+    aaComboBox.addItem("ADAA 2nd Order", 3);
+    addAndMakeVisible(aaComboBox);
+    
+    aaAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(processorRef.apvts, Parameters::aaModeId, aaComboBox);
+    
+    // Lookup table mode
+    addAndMakeVisible(lutButton);
+    
+    lutAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(processorRef.apvts, Parameters::lutId, lutButton);
     
     // Drive
     driveSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
@@ -92,19 +149,64 @@ PluginEditor::PluginEditor (WavefolderProcessor& p)
     
     mixAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processorRef.apvts, Parameters::mixId, mixSlider);
     
+    // Scope & transfer curve
+    addAndMakeVisible(scope);
+    addAndMakeVisible(transferCurve);
+    
+   #if WAVEFOLDER_PERF_METER
+    addAndMakeVisible(loadMeter);
+   #endif
+    
     // Sizing calculations
     const int numCols = 3;
     const int numRows = 2;
+    const int numComboRows = 2;
 
     const int totalWidth = (numCols * (punk_dsp::UIConstants::knobSize + 2 * punk_dsp::UIConstants::margin)) + (10 * 2);
-    const int totalHeight = punk_dsp::UIConstants::headerHeight + punk_dsp::UIConstants::comboboxHeight + 2 * punk_dsp::UIConstants::margin + (numRows * (punk_dsp::UIConstants::knobSize + 2 * punk_dsp::UIConstants::margin)) + (10 * 2);
+    int totalHeight = punk_dsp::UIConstants::headerHeight + numComboRows * (punk_dsp::UIConstants::comboboxHeight + 2 * punk_dsp::UIConstants::margin) + (numRows * (punk_dsp::UIConstants::knobSize + 2 * punk_dsp::UIConstants::margin)) + (10 * 2);
+    totalHeight += displayHeight + 10;
+    
+   #if WAVEFOLDER_PERF_METER
+    totalHeight += loadMeterHeight;
+   #endif
     
     setSize (totalWidth, totalHeight);
 }
 
 PluginEditor::~PluginEditor()
 {
-    juce::LookAndFeel::setDefaultLookAndFeel(nullptr);
+    setLookAndFeel (nullptr);
+}
+
+void PluginEditor::refreshPresetList()
+{
+    presetComboBox.clear(juce::dontSendNotification);
+    
+    for (int i = 0; i < processorRef.getNumPrograms(); ++i)
+        presetComboBox.addItem(processorRef.getProgramName(i), i + 1);
+    
+    presetComboBox.setSelectedItemIndex(processorRef.getCurrentProgram(), juce::dontSendNotification);
+}
+
+void PluginEditor::showSavePresetDialog()
+{
+    auto* window = new juce::AlertWindow ("Save Preset", "Name of the new preset:", juce::MessageBoxIconType::NoIcon, this);
+    window->setLookAndFeel (&lookAndFeel.get());
+    window->addTextEditor("name", "User Preset " + juce::String (processorRef.getNumPrograms() + 1));
+    window->addButton("Save", 1, juce::KeyPress (juce::KeyPress::returnKey));
+    window->addButton("Cancel", 0, juce::KeyPress (juce::KeyPress::escapeKey));
+    
+    // The callback holds on to the look and feel: the window can outlive the editor
+    window->enterModalState(true, juce::ModalCallbackFunction::create ([safeThis = juce::Component::SafePointer<PluginEditor> (this), window, lnf = lookAndFeel] (int result)
+    {
+        if (result == 0 || safeThis == nullptr)
+            return;
+        
+        const auto name = window->getTextEditorContents("name").trim();
+        
+        if (name.isNotEmpty() && safeThis->processorRef.saveUserPreset(name) >= 0)
+            safeThis->refreshPresetList();
+    }), true);
 }
 
 void PluginEditor::paint (juce::Graphics& g)
@@ -118,10 +220,24 @@ void PluginEditor::resized()
     // layout the positions of your child components here
     auto area = getLocalBounds();
     
+   #if WAVEFOLDER_PERF_METER
+    loadMeter.setBounds(area.removeFromBottom(loadMeterHeight));
+   #endif
+    
+    // Displays along the bottom: the scope gets two thirds, the transfer curve the rest
+    auto displayArea = area.removeFromBottom(displayHeight + 10).reduced(10, 0).withTrimmedBottom(10);
+    scope.setBounds(displayArea.removeFromLeft(displayArea.getWidth() * 2 / 3).withTrimmedRight(punk_dsp::UIConstants::margin));
+    transferCurve.setBounds(displayArea.withTrimmedLeft(punk_dsp::UIConstants::margin));
+    
     // --- LAYOUT SETUP ---
     auto headerArea = area.removeFromTop( punk_dsp::UIConstants::headerHeight );
     auto paramsArea = area.reduced( 10 );
     
+    // Presets on the right of the header, the title keeps the rest
+    auto presetArea = headerArea.removeFromRight(headerArea.getWidth() * 2 / 5).reduced(punk_dsp::UIConstants::margin);
+    savePresetButton.setBounds(presetArea.removeFromRight(50));
+    presetComboBox.setBounds(presetArea.withTrimmedRight(punk_dsp::UIConstants::margin));
+    
     header.setBounds(headerArea);
     params.setBounds(paramsArea);
     
@@ -133,9 +249,27 @@ void PluginEditor::resized()
     fb.alignContent = juce::FlexBox::AlignContent::spaceBetween;
     
     // Add components to the FlexBox
-    fb.items.add(juce::FlexItem(wfComboBox).withMinWidth(paramsArea.getWidth() - 2 * punk_dsp::UIConstants::margin)
+    const float halfComboWidth = paramsArea.getWidth() / 2.0f - 2 * punk_dsp::UIConstants::margin;
+    fb.items.add(juce::FlexItem(wfComboBox).withMinWidth(halfComboWidth)
                                             .withMinHeight(punk_dsp::UIConstants::comboboxHeight)
                                             .withMargin(punk_dsp::UIConstants::margin));
+    fb.items.add(juce::FlexItem(morphSlider).withMinWidth(halfComboWidth)
+                                             .withMinHeight(punk_dsp::UIConstants::comboboxHeight)
+                                             .withMargin(punk_dsp::UIConstants::margin));
+    
+    const float thirdComboWidth = (paramsArea.getWidth() - punk_dsp::UIConstants::knobSize) / 3.0f - 2 * punk_dsp::UIConstants::margin;
+    fb.items.add(juce::FlexItem(osComboBox).withMinWidth(thirdComboWidth)
+                                           .withMinHeight(punk_dsp::UIConstants::comboboxHeight)
+                                           .withMargin(punk_dsp::UIConstants::margin));
+    fb.items.add(juce::FlexItem(osPhaseComboBox).withMinWidth(thirdComboWidth)
+                                                .withMinHeight(punk_dsp::UIConstants::comboboxHeight)
+                                                .withMargin(punk_dsp::UIConstants::margin));
+    fb.items.add(juce::FlexItem(aaComboBox).withMinWidth(thirdComboWidth)
+                                           .withMinHeight(punk_dsp::UIConstants::comboboxHeight)
+                                           .withMargin(punk_dsp::UIConstants::margin));
+    fb.items.add(juce::FlexItem(lutButton).withMinWidth(punk_dsp::UIConstants::knobSize - 2 * punk_dsp::UIConstants::margin)
+                                          .withMinHeight(punk_dsp::UIConstants::comboboxHeight)
+                                          .withMargin(punk_dsp::UIConstants::margin));
     
     fb.items.add(juce::FlexItem(driveSlider).withMinWidth(punk_dsp::UIConstants::knobSize)
                                             .withMinHeight(punk_dsp::UIConstants::knobSize)
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "PluginProcessor.h"
+#include "perf/LoadMeterComponent.h"
+#include "display/ScopeComponent.h"
+#include "display/TransferCurveComponent.h"
 
 //==============================================================================
 class PluginEditor : public juce::AudioProcessorEditor
@@ -14,23 +17,45 @@ public:
     void resized() override;
 
 private:
+    void refreshPresetList();
+    void showSavePresetDialog();
+    
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     WavefolderProcessor& processorRef;
     
-    // Custom Look and Feel
-    punk_dsp::ExamplesLnF myCustomLnF;
+    // Custom Look and Feel, one shared by every open editor. Set on this editor only, so other
+    // plugins in the same host process keep their own
+    juce::SharedResourcePointer<punk_dsp::ExamplesLnF> lookAndFeel;
     
     // Layout utilities
     juce::TextButton header, params;
     
     // Sliders - Rotary knobs
     juce::Slider driveSlider, outGainSlider, biasPreSlider, biasPostSlider, thresSlider, mixSlider;
-    juce::ComboBox wfComboBox;
+    juce::Slider morphSlider;
+    juce::ComboBox wfComboBox, osComboBox, osPhaseComboBox, aaComboBox;
+    juce::ToggleButton lutButton { "LUT" };
+    
+    // Programs, in the header
+    juce::ComboBox presetComboBox;
+    juce::TextButton savePresetButton { "Save" };
+    
+    // Displays, below the knobs
+    Display::ScopeComponent scope { processorRef.getScopeFifo(), processorRef };
+    Display::TransferCurveComponent transferCurve { [this] { return Display::TransferCurveComponent::Settings { processorRef.getDisplayParams(), processorRef.getDisplayShape() }; } };
+    static constexpr int displayHeight = 120;
         
     // Attachments for linking sliders-parameters
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> driveAttachment, outGainAttachment, biasPreAttachment, biasPostAttachment, thresAttachment, mixAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> wfAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> driveAttachment, outGainAttachment, biasPreAttachment, biasPostAttachment, thresAttachment, mixAttachment, morphAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> wfAttachment, osAttachment, osPhaseAttachment, aaAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> lutAttachment;
+    
+   #if WAVEFOLDER_PERF_METER
+    // Callback load, only in instrumented builds
+    Perf::LoadMeterComponent loadMeter { processorRef.getBlockTimer() };
+    static constexpr int loadMeterHeight = 22;
+   #endif
             
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginEditor)
 };
@@ -1,21 +1,251 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    /** Everything about a parameter that is the same in every instance. The list is built
+        once per process, so a new instance only creates its parameter objects from it and
+        shares the strings, instead of building every name, range and choice list again. */
+    struct ParameterSpec
+    {
+        enum class Kind
+        {
+            floating = 0,
+            choice,
+            toggle
+        };
+        
+        Kind kind = Kind::floating;
+        juce::String id, name;
+        juce::NormalisableRange<float> range;
+        float defaultValue = 0.0f;      // Plain value, choice index, or 0 / 1
+        juce::StringArray choices;
+        uint32_t clapId = 0;            // clap-juce-extensions derives it from the hash of the ID
+        
+        std::unique_ptr<juce::RangedAudioParameter> create() const
+        {
+            switch (kind)
+            {
+                case Kind::choice:  return std::make_unique<juce::AudioParameterChoice> (id, name, choices, (int) defaultValue);
+                case Kind::toggle:  return std::make_unique<juce::AudioParameterBool> (id, name, defaultValue >= 0.5f);
+                case Kind::floating: break;
+            }
+            
+            return std::make_unique<juce::AudioParameterFloat> (id, name, range, defaultValue);
+        }
+    };
+    
+    std::vector<ParameterSpec> buildParameterSpecs()
+    {
+        using namespace Parameters;
+        using Kind = ParameterSpec::Kind;
+        
+        std::vector<ParameterSpec> specs;
+        
+        const auto addFloat = [&specs] (const juce::String& id, const juce::String& name, juce::NormalisableRange<float> range, float defaultValue)
+        {
+            specs.push_back ({ Kind::floating, id, name, range, defaultValue, {} });
+        };
+        
+        const auto addChoice = [&specs] (const juce::String& id, const juce::String& name, const juce::StringArray& choices, int defaultIndex)
+        {
+            specs.push_back ({ Kind::choice, id, name, {}, (float) defaultIndex, choices });
+        };
+        
+        const auto addToggle = [&specs] (const juce::String& id, const juce::String& name, bool defaultValue)
+        {
+            specs.push_back ({ Kind::toggle, id, name, {}, defaultValue ? 1.0f : 0.0f, {} });
+        };
+        
+        const auto skewed = [] (float min, float max, float interval, float centre)
+        {
+            juce::NormalisableRange<float> range (min, max, interval);
+            range.setSkewForCentre (centre);
+            return range;
+        };
+        
+        // Input & output gain (dB), bias, threshold, mix (%)
+        addFloat (driveId, driveName, { driveMin, driveMax, 0.1f }, driveDefault);
+        addFloat (outGainId, outGainName, { outGainMin, outGainMax, 0.1f }, outGainDefault);
+        addFloat (biasPreId, biasPreName, { biasMin, biasMax, 0.01f }, biasDefault);
+        addFloat (biasPostId, biasPostName, { biasMin, biasMax, 0.01f }, biasDefault);
+        addFloat (thresId, thresName, { thresMin, thresMax, 0.01f }, thresDefault);
+        addFloat (mixId, mixName, { mixMin, mixMax, 0.1f }, mixDefault);
+        
+        // Waveshaper type, and the morph position used by the "Morph" type
+        addChoice (wfTypeId, wfTypeName, { "FoldToRange", "SinFold", "ComboFold", "Morph" }, 0);
+        addFloat (morphId, morphName, { morphMin, morphMax, 0.001f }, morphDefault);
+        
+        // Anti-aliasing, lookup table & oversampling
+        addChoice (aaModeId, aaModeName, { "Off", "ADAA 1st Order", "ADAA 2nd Order" }, aaModeDefault);
+        addToggle (lutId, lutName, lutDefault);
+        addChoice (osId, osName, { "1x", "2x", "4x", "8x", "16x" }, osDefault);
+        addChoice (osPhaseId, osPhaseName, { "Minimum Phase", "Linear Phase" }, osPhaseDefault);
+        
+        // Channel groups, only used by multichannel layouts
+        for (int g = 0; g < numChannelGroups; ++g)
+        {
+            const juce::String groupName (groupNames[g]);
+            
+            addToggle (groupLinkIds[g], groupName + " Link", groupLinkDefault);
+            addFloat (groupDriveIds[g], groupName + " " + driveName, { driveMin, driveMax, 0.1f }, driveDefault);
+            addFloat (groupThresIds[g], groupName + " " + thresName, { thresMin, thresMax, 0.01f }, thresDefault);
+        }
+        
+        // Multiband mode
+        addChoice (bandsId, bandsName, { "Off", "2 Bands", "3 Bands", "4 Bands" }, bandsDefault);
+        
+        for (int c = 0; c < maxBands - 1; ++c)
+            addFloat (crossoverIds[c], crossoverNames[c], skewed (crossoverMin, crossoverMax, 1.0f, 1000.0f), crossoverDefaults[c]);
+        
+        // Per band fold settings, no morph: each band has one of the three types
+        for (int b = 0; b < maxBands; ++b)
+        {
+            const juce::String bandName (bandNames[b]);
+            
+            addChoice (bandTypeIds[b], bandName + " " + wfTypeName, { "FoldToRange", "SinFold", "ComboFold" }, 0);
+            addFloat (bandDriveIds[b], bandName + " " + driveName, { driveMin, driveMax, 0.1f }, driveDefault);
+            addFloat (bandThresIds[b], bandName + " " + thresName, { thresMin, thresMax, 0.01f }, thresDefault);
+        }
+        
+        // Envelope modulation
+        addChoice (envSourceId, envSourceName, { "Input", "Sidechain" }, envSourceDefault);
+        addChoice (envModeId, envModeName, { "Peak", "RMS" }, envModeDefault);
+        addFloat (envAttackId, envAttackName, skewed (envAttackMin, envAttackMax, 0.1f, 10.0f), envAttackDefault);
+        addFloat (envReleaseId, envReleaseName, skewed (envReleaseMin, envReleaseMax, 1.0f, 150.0f), envReleaseDefault);
+        addFloat (envDriveDepthId, envDriveDepthName, { envDriveDepthMin, envDriveDepthMax, 0.1f }, envDriveDepthDefault);
+        addFloat (envThresDepthId, envThresDepthName, { envThresDepthMin, envThresDepthMax, 0.01f }, envThresDepthDefault);
+        
+        // Output stages
+        addToggle (dcBlockId, dcBlockName, dcBlockDefault);
+        addToggle (limiterId, limiterName, limiterDefault);
+        addFloat (limiterCeilingId, limiterCeilingName, { limiterCeilingMin, limiterCeilingMax, 0.1f }, limiterCeilingDefault);
+        addFloat (limiterReleaseId, limiterReleaseName, skewed (limiterReleaseMin, limiterReleaseMax, 1.0f, 100.0f), limiterReleaseDefault);
+        
+        // Stereo modes, the settings of each side
+        addChoice (stereoModeId, stereoModeName, { "Linked", "Left / Right", "Mid / Side" }, stereoModeDefault);
+        
+        for (int s = 0; s < numStereoSides; ++s)
+        {
+            const juce::String sideName (stereoSideNames[s]);
+            
+            addFloat (stereoDriveIds[s], sideName + " " + driveName, { driveMin, driveMax, 0.1f }, driveDefault);
+            addFloat (stereoBiasIds[s], sideName + " " + biasPreName, { biasMin, biasMax, 0.01f }, biasDefault);
+            addFloat (stereoThresIds[s], sideName + " " + thresName, { thresMin, thresMax, 0.01f }, thresDefault);
+        }
+        
+        for (auto& spec : specs)
+            spec.clapId = (uint32_t) spec.id.hashCode();
+        
+        return specs;
+    }
+    
+    const std::vector<ParameterSpec>& getParameterSpecs()
+    {
+        static const auto specs = buildParameterSpecs();
+        return specs;
+    }
+}
+
 //==============================================================================
 WavefolderProcessor::WavefolderProcessor()
 : AudioProcessor (BusesProperties()
 #if ! JucePlugin_IsMidiEffect
 #if ! JucePlugin_IsSynth
                   .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                  .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
 #endif
                   .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
 #endif
-                  ), apvts(*this, nullptr, "Parameters", createParams())
+                  ), apvts(*this, nullptr, "Parameters", createParams()),
+    kernels (FoldDSP::Kernels::getActiveTable())
 {
+    parameters.drive = apvts.getRawParameterValue (Parameters::driveId);
+    parameters.outGain = apvts.getRawParameterValue (Parameters::outGainId);
+    parameters.biasPre = apvts.getRawParameterValue (Parameters::biasPreId);
+    parameters.biasPost = apvts.getRawParameterValue (Parameters::biasPostId);
+    parameters.thres = apvts.getRawParameterValue (Parameters::thresId);
+    parameters.mix = apvts.getRawParameterValue (Parameters::mixId);
+    parameters.wfType = apvts.getRawParameterValue (Parameters::wfTypeId);
+    parameters.morph = apvts.getRawParameterValue (Parameters::morphId);
+    parameters.aaMode = apvts.getRawParameterValue (Parameters::aaModeId);
+    parameters.lut = apvts.getRawParameterValue (Parameters::lutId);
+    parameters.os = apvts.getRawParameterValue (Parameters::osId);
+    parameters.osPhase = apvts.getRawParameterValue (Parameters::osPhaseId);
+    
+    for (int g = 0; g < Parameters::numChannelGroups; ++g)
+    {
+        parameters.groups[(size_t) g].link = apvts.getRawParameterValue (Parameters::groupLinkIds[g]);
+        parameters.groups[(size_t) g].drive = apvts.getRawParameterValue (Parameters::groupDriveIds[g]);
+        parameters.groups[(size_t) g].thres = apvts.getRawParameterValue (Parameters::groupThresIds[g]);
+    }
+    
+    parameters.numBands = apvts.getRawParameterValue (Parameters::bandsId);
+    
+    for (int c = 0; c < Parameters::maxBands - 1; ++c)
+        parameters.crossovers[(size_t) c] = apvts.getRawParameterValue (Parameters::crossoverIds[c]);
+    
+    for (int b = 0; b < Parameters::maxBands; ++b)
+    {
+        parameters.bands[(size_t) b].type = apvts.getRawParameterValue (Parameters::bandTypeIds[b]);
+        parameters.bands[(size_t) b].drive = apvts.getRawParameterValue (Parameters::bandDriveIds[b]);
+        parameters.bands[(size_t) b].thres = apvts.getRawParameterValue (Parameters::bandThresIds[b]);
+    }
+    
+    parameters.envSource = apvts.getRawParameterValue (Parameters::envSourceId);
+    parameters.envMode = apvts.getRawParameterValue (Parameters::envModeId);
+    parameters.envAttack = apvts.getRawParameterValue (Parameters::envAttackId);
+    parameters.envRelease = apvts.getRawParameterValue (Parameters::envReleaseId);
+    parameters.envDriveDepth = apvts.getRawParameterValue (Parameters::envDriveDepthId);
+    parameters.envThresDepth = apvts.getRawParameterValue (Parameters::envThresDepthId);
+    
+    parameters.dcBlock = apvts.getRawParameterValue (Parameters::dcBlockId);
+    parameters.limiter = apvts.getRawParameterValue (Parameters::limiterId);
+    parameters.limiterCeiling = apvts.getRawParameterValue (Parameters::limiterCeilingId);
+    parameters.limiterRelease = apvts.getRawParameterValue (Parameters::limiterReleaseId);
+    
+    parameters.stereoMode = apvts.getRawParameterValue (Parameters::stereoModeId);
+    
+    for (int s = 0; s < Parameters::numStereoSides; ++s)
+    {
+        parameters.stereoSides[(size_t) s].drive = apvts.getRawParameterValue (Parameters::stereoDriveIds[s]);
+        parameters.stereoSides[(size_t) s].bias = apvts.getRawParameterValue (Parameters::stereoBiasIds[s]);
+        parameters.stereoSides[(size_t) s].thres = apvts.getRawParameterValue (Parameters::stereoThresIds[s]);
+    }
+    
+    lastBandDriveDb.fill (std::numeric_limits<float>::quiet_NaN());
+    bandDriveGain.fill (1.0f);
+    
+    // CLAP param ids, hashed once per process with the rest of the layout (same order)
+    const auto& params = getParameters();
+    const auto& specs = getParameterSpecs();
+    jassert ((size_t) params.size() == specs.size());
+    
+    clapParameterIds.reserve (specs.size());
+    rawParameterValues.reserve (specs.size());
+    
+    for (int i = 0; i < params.size(); ++i)
+    {
+        clapParameterIds.emplace_back (specs[(size_t) i].clapId, params[i]);
+        rawParameterValues.push_back (apvts.getRawParameterValue (specs[(size_t) i].id));
+    }
+    
+    // Sorted by ID, the audio thread looks every CLAP event up by binary search
+    std::sort (clapParameterIds.begin(), clapParameterIds.end(),
+               [] (const auto& a, const auto& b) { return a.first < b.first; });
+    jassert (std::adjacent_find (clapParameterIds.begin(), clapParameterIds.end(),
+                                 [] (const auto& a, const auto& b) { return a.first == b.first; }) == clapParameterIds.end());
+    
+    addFactoryPresets();
+    
+    if (auto result = presets.loadUserBank (Presets::PresetBank::getDefaultUserBankFile()); result.failed())
+        DBG (result.getErrorMessage());
 }
 
 WavefolderProcessor::~WavefolderProcessor()
 {
+    // Offline tools destroy processors on their worker threads, without releasing them
+    stopTimer();
 }
 
 //==============================================================================
@@ -53,34 +283,96 @@ bool WavefolderProcessor::isMidiEffect() const
 
 double WavefolderProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // Kept up to date by updateLatency, which the audio thread calls when a stage is switched
+    return tailSeconds.load();
 }
 
 int WavefolderProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    return juce::jmax (1, presets.getNumPresets());   // NB: some hosts don't cope very well if you tell them there are 0 programs,
     // so this should be at least 1, even if you're not really implementing programs.
 }
 
 int WavefolderProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load();
 }
 
 void WavefolderProcessor::setCurrentProgram (int index)
 {
-    juce::ignoreUnused (index);
+    if (! juce::isPositiveAndBelow (index, presets.getNumPresets()))
+        return;
+    
+    currentProgram = index;
+    
+    // While playing, the audio thread picks the preset up at its next block. Otherwise
+    // nothing is reading the parameters and they can be set right away.
+    if (prepared.load())
+    {
+        pendingProgram.store (index);
+    }
+    else
+    {
+        recalledProgram.store (-1);
+        presets.apply (index);
+    }
 }
 
 const juce::String WavefolderProcessor::getProgramName (int index)
 {
-    juce::ignoreUnused (index);
-    return {};
+    return presets.getName (index);
 }
 
 void WavefolderProcessor::changeProgramName (int index, const juce::String& newName)
 {
-    juce::ignoreUnused (index, newName);
+    if (! presets.isUserPreset (index))
+        return;
+    
+    presets.setName (index, newName);
+    
+    if (auto result = presets.saveUserBank (Presets::PresetBank::getDefaultUserBankFile()); result.failed())
+        DBG (result.getErrorMessage());
+}
+
+int WavefolderProcessor::saveUserPreset (const juce::String& name)
+{
+    // Whatever is still pending is what the user is hearing next, save that
+    applyPendingProgram();
+    notifyRecalledProgram();
+    
+    const int index = presets.addUserPreset (name);
+    
+    if (index < 0)
+        return -1;
+    
+    if (auto result = presets.saveUserBank (Presets::PresetBank::getDefaultUserBankFile()); result.failed())
+    {
+        DBG (result.getErrorMessage());
+        return -1;
+    }
+    
+    currentProgram = index;
+    updateHostDisplay (ChangeDetails().withProgramChanged (true));
+    return index;
+}
+
+void WavefolderProcessor::applyPendingProgram() noexcept
+{
+    // Whichever thread gets here first recalls it, only once. This only stores to the raw
+    // values the DSP reads, the parameter objects are brought in line by notifyRecalledProgram.
+    if (const int program = pendingProgram.exchange (-1); program >= 0)
+    {
+        presets.recall (program, rawParameterValues.data());
+        recalledProgram.store (program);
+    }
+}
+
+void WavefolderProcessor::notifyRecalledProgram()
+{
+    // Message thread: setting the parameters notifies the host and listeners, under their
+    // locks. The raw values already hold the preset, so the DSP doesn't see a change.
+    if (const int program = recalledProgram.exchange (-1); program >= 0)
+        presets.apply (program);
 }
 
 // =========== PARAMETER LAYOUT ====================
@@ -88,108 +380,518 @@ juce::AudioProcessorValueTreeState::ParameterLayout WavefolderProcessor::createP
 {
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
     
-    // Inpout Gain (dB)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::driveId,
-                                                           Parameters::driveName,
-                                                           juce::NormalisableRange<float>(Parameters::driveMin, Parameters::driveMax, 0.1f),
-                                                           Parameters::driveDefault
-                                                           )
-               );
-    
-    // Output Gain (dB)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::outGainId,
-                                                           Parameters::outGainName,
-                                                           juce::NormalisableRange<float>(Parameters::outGainMin, Parameters::outGainMax, 0.1f),
-                                                           Parameters::outGainDefault
-                                                           )
-               );
-    
-    // Bias (pre-drive)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::biasPreId,
-                                                           Parameters::biasPreName,
-                                                           juce::NormalisableRange<float>(Parameters::biasMin, Parameters::biasMax, 0.01f),
-                                                           Parameters::biasDefault
-                                                           )
-               );
-    
-    // Bias (post-drive)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::biasPostId,
-                                                           Parameters::biasPostName,
-                                                           juce::NormalisableRange<float>(Parameters::biasMin, Parameters::biasMax, 0.01f),
-                                                           Parameters::biasDefault
-                                                           )
-               );
-    
-    // Fold limit threshold
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::thresId,
-                                                           Parameters::thresName,
-                                                           juce::NormalisableRange<float>(Parameters::thresMin, Parameters::thresMax, 0.01f),
-                                                           Parameters::thresDefault
-                                                           )
-               );
-    
-    
-    // Mix (%)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-                                                           Parameters::mixId,
-                                                           Parameters::mixName,
-                                                           juce::NormalisableRange<float>(Parameters::mixMin, Parameters::mixMax, 0.1f),
-                                                           Parameters::mixDefault
-                                                           )
-               );
-    
-    // Waveshaper options
-    juce::StringArray processorChoices { "FoldToRange", "SinFold", "ComboFold" };
-    
-    layout.add (std::make_unique<juce::AudioParameterChoice>(
-                                                             "wavefolder",           // Parameter ID
-                                                             "Wavefolder Type",          // Parameter name
-                                                             processorChoices,          // Choices
-                                                             0                          // Default index
-                                                             )
-                );
+    for (const auto& spec : getParameterSpecs())
+        layout.add (spec.create());
     
     return layout;
 }
 
+void WavefolderProcessor::addFactoryPresets()
+{
+    using namespace Parameters;
+    
+    // Plain values: dB, %, choice indices. Anything not listed stays at its default.
+    presets.addFactoryPreset ("Init", {});
+    presets.addFactoryPreset ("Gentle Sine", { { driveId, 6.0f }, { thresId, 0.8f }, { mixId, 60.0f }, { wfTypeId, 1.0f }, { aaModeId, 1.0f } });
+    presets.addFactoryPreset ("Hard Triangle", { { driveId, 24.0f }, { outGainId, -6.0f }, { thresId, 0.5f }, { wfTypeId, 0.0f }, { osId, 2.0f } });
+    presets.addFactoryPreset ("Asymmetric Combo", { { driveId, 18.0f }, { outGainId, -4.0f }, { biasPreId, 0.3f }, { biasPostId, -0.1f },
+                                                    { wfTypeId, 2.0f }, { aaModeId, 2.0f } });
+    presets.addFactoryPreset ("Morph Halfway", { { driveId, 12.0f }, { thresId, 0.6f }, { wfTypeId, (float) wfTypeMorph }, { morphId, 1.5f } });
+    presets.addFactoryPreset ("West Coast", { { driveId, 36.0f }, { outGainId, -9.0f }, { thresId, 0.3f }, { wfTypeId, 1.0f },
+                                              { osId, 3.0f }, { osPhaseId, 1.0f } });
+    presets.addFactoryPreset ("Multiband Grit", { { bandsId, 2.0f }, { crossoverIds[0], 150.0f }, { crossoverIds[1], 2500.0f },
+                                                  { bandDriveIds[0], 3.0f }, { bandThresIds[0], 0.9f },
+                                                  { bandTypeIds[1], 2.0f }, { bandDriveIds[1], 18.0f }, { bandThresIds[1], 0.5f },
+                                                  { bandTypeIds[2], 1.0f }, { bandDriveIds[2], 12.0f }, { bandThresIds[2], 0.6f },
+                                                  { outGainId, -4.0f }, { osId, 1.0f } });
+}
+
 //==============================================================================
-void WavefolderProcessor::updateParameters()
+bool WavefolderProcessor::updateParameters()
 {
-    wf.setDrive( juce::Decibels::decibelsToGain( apvts.getRawParameterValue(Parameters::driveId)->load() ) );
-    wf.setOutGain( juce::Decibels::decibelsToGain( apvts.getRawParameterValue(Parameters::outGainId)->load() ) );
+    bool changed = false;
     
-    wf.setBiasPre( apvts.getRawParameterValue(Parameters::biasPreId)->load() );
-    wf.setBiasPost( apvts.getRawParameterValue(Parameters::biasPostId)->load() );
+    // dB -> gain only when the value actually moved
+    const float driveDb = parameters.drive->load();
+    const float outGainDb = parameters.outGain->load();
     
-    wf.setThreshold( apvts.getRawParameterValue(Parameters::thresId)->load() );
-    wf.setMix( apvts.getRawParameterValue(Parameters::mixId)->load() / 100.0f);
+    FoldDSP::FoldParams targets = foldParams;
+    
+    if (driveDb != lastDriveDb)
+    {
+        targets.drive = juce::Decibels::decibelsToGain (driveDb);
+        lastDriveDb = driveDb;
+    }
+    
+    if (outGainDb != lastOutGainDb)
+    {
+        targets.outGain = juce::Decibels::decibelsToGain (outGainDb);
+        lastOutGainDb = outGainDb;
+    }
+    
+    targets.biasPre = parameters.biasPre->load();
+    targets.biasPost = parameters.biasPost->load();
+    targets.threshold = parameters.thres->load();
+    targets.mix = parameters.mix->load() / 100.0f;
     
     // Get the current processor type
-    int typesIndex = (int) apvts.getRawParameterValue ("wavefolder")->load();
-    wfType = juce::jlimit(0, 2, typesIndex);
+    const int newWfType = juce::jlimit (0, Parameters::wfTypeMorph, (int) parameters.wfType->load());
+    const bool typeChanged = newWfType != wfType;
+    
+    // Crossfade from wherever the shape is now, which may be halfway through another crossfade
+    if (typeChanged)
+    {
+        fadeFrom = getBlendAt (0);
+        fadeRemaining = fadeLength;
+    }
+    
+    foldParams = targets;
+    wfType = newWfType;
+    
+    // The morph position only glides while it's in use, a type change crossfades to it instead
+    const float newMorph = parameters.morph->load();
+    
+    if (wfType == Parameters::wfTypeMorph && ! typeChanged)
+    {
+        changed = changed || newMorph != morph.getTarget();
+        morph.setTarget (newMorph);
+    }
+    else
+    {
+        morph.setCurrentAndTarget (newMorph);
+    }
+    
+    for (size_t g = 0; g < groups.size(); ++g)
+    {
+        auto& group = groups[g];
+        const auto& groupParameters = parameters.groups[g];
+        auto groupTargets = targets;
+        
+        // Unlinked groups only override the drive & threshold
+        if (groupParameters.link->load() < 0.5f)
+        {
+            const float groupDriveDb = groupParameters.drive->load();
+            
+            if (groupDriveDb != group.lastDriveDb)
+            {
+                group.driveGain = juce::Decibels::decibelsToGain (groupDriveDb);
+                group.lastDriveDb = groupDriveDb;
+            }
+            
+            groupTargets.drive = group.driveGain;
+            groupTargets.threshold = groupParameters.thres->load();
+        }
+        
+        if (groupTargets != group.params || typeChanged)
+        {
+            group.params = groupTargets;
+            group.smoother.setTargets (group.params);
+            changed = true;
+        }
+    }
+    
+    changed = updateStereoSides (targets, typeChanged) || changed;
+    changed = updateBands (targets) || changed;
+    
+    const bool wasModulating = modulating;
+    updateEnvelopeParameters();
+    changed = changed || modulating != wasModulating;
+    
+    // The table is memoryless, so it can't stand in for ADAA
+    const bool newLutEnabled = parameters.lut->load() >= 0.5f;
+    changed = changed || newLutEnabled != lutEnabled;
+    lutEnabled = newLutEnabled;
+    
+    if (lutEnabled && aaMode == 0 && wfType != Parameters::wfTypeMorph && multiband.getNumBands() < 2)
+        lut.request ((FoldDSP::FoldType) wfType, foldParams);
+    
+    // Oversampling factor & filter phase, the host is told whenever the latency changes
+    const int osIndex = (int) parameters.os->load();
+    const auto osPhase = (int) parameters.osPhase->load() == 0 ? FoldDSP::Oversampler::Phase::minimum
+                                                               : FoldDSP::Oversampler::Phase::linear;
+    
+    const int newAaMode = juce::jlimit (0, 2, (int) parameters.aaMode->load());
+    const bool osChanged = oversampler.setMode (osIndex, osPhase);
+    
+    if (osChanged)
+    {
+        for (auto& group : groups)
+            group.smoother.reset (currentSampleRate * oversampler.getFactor(), smoothingSeconds, group.params);
+        
+        for (auto& side : stereoSides)
+            side.smoother.reset (currentSampleRate * oversampler.getFactor(), smoothingSeconds, side.params);
+        
+        multiband.setSampleRate (currentSampleRate * oversampler.getFactor());
+        resetShapeRamps();
+    }
+    
+    if (osChanged || newAaMode != aaMode)
+    {
+        // The ADAA history belongs to the previous rate/mode, start again from the next input
+        aaMode = newAaMode;
+        
+        for (auto& group : groups)
+            group.adaa.reset();
+        
+        for (auto& side : stereoSides)
+            side.adaa.reset();
+        
+        updateLatency();
+        changed = true;
+    }
+    
+    return updateOutputStages() || changed;
+}
+
+bool WavefolderProcessor::updateOutputStages()
+{
+    bool changed = false;
+    
+    const bool newDcBlockEnabled = parameters.dcBlock->load() >= 0.5f;
+    const bool newLimiterEnabled = parameters.limiter->load() >= 0.5f;
+    
+    if (newDcBlockEnabled != dcBlockEnabled)
+    {
+        dcBlockEnabled = newDcBlockEnabled;
+        dcBlocker.reset();
+        changed = true;
+    }
+    
+    if (newLimiterEnabled != limiterEnabled)
+    {
+        limiterEnabled = newLimiterEnabled;
+        limiter.reset();
+        changed = true;
+    }
+    
+    // The lookahead is part of the latency, and the release of how long the output takes
+    // to settle
+    const bool releaseChanged = limiter.setRelease (parameters.limiterRelease->load());
+    
+    if (changed || (releaseChanged && limiterEnabled))
+        updateLatency();
+    
+    return limiter.setCeiling (parameters.limiterCeiling->load()) || changed;
+}
+
+bool WavefolderProcessor::updateBands (const FoldDSP::FoldParams& targets)
+{
+    // Switching the mode on or off starts the crossovers and the ADAA history from scratch
+    const bool modeChanged = multiband.setNumBands ((int) parameters.numBands->load() + 1);
+    
+    if (modeChanged)
+    {
+        for (auto& group : groups)
+            group.adaa.reset();
+        
+        for (auto& side : stereoSides)
+            side.adaa.reset();
+        
+        updateLatency();
+    }
+    
+    // Nothing else to do for the bands that aren't in use
+    const int numBands = multiband.getNumBands();
+    bool changed = modeChanged;
+    
+    if (numBands < 2)
+        return changed;
+    
+    for (int c = 0; c < numBands - 1; ++c)
+        changed = multiband.setCrossover (c, parameters.crossovers[(size_t) c]->load()) || changed;
+    
+    for (int b = 0; b < numBands; ++b)
+    {
+        const auto& bandParameters = parameters.bands[(size_t) b];
+        const float driveDb = bandParameters.drive->load();
+        
+        if (driveDb != lastBandDriveDb[(size_t) b])
+        {
+            bandDriveGain[(size_t) b] = juce::Decibels::decibelsToGain (driveDb);
+            lastBandDriveDb[(size_t) b] = driveDb;
+        }
+        
+        auto bandTargets = targets;
+        bandTargets.drive = bandDriveGain[(size_t) b];
+        bandTargets.threshold = bandParameters.thres->load();
+        
+        const auto type = (FoldDSP::FoldType) juce::jlimit (0, 2, (int) bandParameters.type->load());
+        changed = multiband.setBand (b, type, bandTargets) || changed;
+    }
+    
+    return changed;
+}
+
+bool WavefolderProcessor::updateStereoSides (const FoldDSP::FoldParams& targets, bool typeChanged)
+{
+    bool changed = false;
+    
+    // The front channels move to the other mode's ADAA history, start it from scratch
+    const int newStereoMode = juce::jlimit (0, Parameters::stereoModeMidSide, (int) parameters.stereoMode->load());
+    
+    if (newStereoMode != stereoMode)
+    {
+        stereoMode = newStereoMode;
+        groups[0].adaa.reset();
+        
+        for (auto& side : stereoSides)
+            side.adaa.reset();
+        
+        changed = true;
+    }
+    
+    // Kept up to date while the mode is off, so switching it on doesn't ramp in from the defaults
+    for (size_t s = 0; s < stereoSides.size(); ++s)
+    {
+        auto& side = stereoSides[s];
+        const auto& sideParameters = parameters.stereoSides[s];
+        const float driveDb = sideParameters.drive->load();
+        
+        if (driveDb != side.lastDriveDb)
+        {
+            side.driveGain = juce::Decibels::decibelsToGain (driveDb);
+            side.lastDriveDb = driveDb;
+        }
+        
+        auto sideTargets = targets;
+        sideTargets.drive = side.driveGain;
+        sideTargets.biasPre = sideParameters.bias->load();
+        sideTargets.threshold = sideParameters.thres->load();
+        
+        if (sideTargets != side.params || typeChanged)
+        {
+            side.params = sideTargets;
+            side.smoother.setTargets (side.params);
+            changed = changed || isStereoActive();
+        }
+    }
+    
+    return changed;
+}
+
+void WavefolderProcessor::updateEnvelopeParameters()
+{
+    envDriveDepthDb = parameters.envDriveDepth->load();
+    envThresDepth = parameters.envThresDepth->load();
+    
+    // Keeps going after the depths are set to 0 until the last step has ramped back to no
+    // modulation. The bands aren't modulated.
+    const bool wasModulating = modulating;
+    modulating = multiband.getNumBands() < 2
+              && (envDriveDepthDb != 0.0f || envThresDepth != 0.0f || lastModDriveGain != 1.0f || lastModThresScale != 1.0f);
+    
+    if (! modulating)
+    {
+        lastModDriveGain = lastModThresScale = 1.0f;
+        return;
+    }
+    
+    if (! wasModulating)
+        envelope.reset();
+    
+    envelope.setMode ((FoldDSP::EnvelopeFollower::Mode) juce::jlimit (0, 1, (int) parameters.envMode->load()));
+    envelope.setTimes (parameters.envAttack->load(), parameters.envRelease->load());
+    envFromSidechain = parameters.envSource->load() >= 0.5f && numSidechainChannels > 0;
+}
+
+template <typename SampleType>
+void WavefolderProcessor::updateModulation (const juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    numModulationSteps = 0;
+    
+    if (! modulating)
+        return;
+    
+    // The sidechain when there is one to read, the input otherwise
+    const auto* const* channels = buffer.getArrayOfReadPointers() + (envFromSidechain ? firstSidechainChannel : 0);
+    const int numChannels = envFromSidechain ? numSidechainChannels : juce::jmin (getTotalNumOutputChannels(), buffer.getNumChannels());
+    const auto foldFactor = (float) oversampler.getFactor();
+    
+    for (int offset = 0; offset < numSamples && numModulationSteps < (int) modulationSteps.size(); offset += envelopeStep)
+    {
+        const int length = juce::jmin (envelopeStep, numSamples - offset);
+        const float level = juce::jmin (1.0f, envelope.process (channels, numChannels, startSample + offset, length));
+        const float driveGain = juce::Decibels::decibelsToGain (envDriveDepthDb * level);
+        const float thresScale = juce::jlimit (0.1f, 2.0f, 1.0f + envThresDepth * level);
+        const float foldLength = (float) length * foldFactor;
+        
+        // From where the previous step ended to this step's value
+        auto& step = modulationSteps[(size_t) numModulationSteps++];
+        step.driveGain = lastModDriveGain;
+        step.driveRatio = driveGain == lastModDriveGain ? 1.0f : std::pow (driveGain / lastModDriveGain, 1.0f / foldLength);
+        step.thresScale = lastModThresScale;
+        step.thresScaleDelta = (thresScale - lastModThresScale) / foldLength;
+        
+        lastModDriveGain = driveGain;
+        lastModThresScale = thresScale;
+    }
+}
+
+void WavefolderProcessor::applyModulation (int offset, FoldDSP::FoldParams& current, FoldDSP::FoldRamp& ramp) const noexcept
+{
+    if (numModulationSteps == 0)
+        return;
+    
+    const int stepLength = getModulationStepLength();
+    const int index = juce::jmin (offset / stepLength, numModulationSteps - 1);
+    const auto& step = modulationSteps[(size_t) index];
+    const auto position = (float) (offset - index * stepLength);
+    
+    const float driveGain = position > 0.0f && step.driveRatio != 1.0f ? step.driveGain * std::pow (step.driveRatio, position) : step.driveGain;
+    const float thresScale = step.thresScale + step.thresScaleDelta * position;
+    
+    // Smoothed value times modulation. Both gains are geometric, so the drive stays exact;
+    // the threshold is a product of two lines, linearised over the (short) segment.
+    ramp.thresholdDelta = ramp.thresholdDelta * thresScale + current.threshold * step.thresScaleDelta;
+    ramp.driveRatio *= step.driveRatio;
+    current.threshold *= thresScale;
+    current.drive *= driveGain;
+}
+
+void WavefolderProcessor::updateLatency()
+{
+    double latency = oversampler.getLatencyInSamples();
+    
+    // ADAA delays the signal by a fraction of a sample at the fold rate, the bands don't use it
+    if (aaMode != 0 && multiband.getNumBands() < 2)
+        latency += FoldDSP::AdaaFolder::getDelayInSamples ((FoldDSP::AdaaFolder::Order) aaMode) / oversampler.getFactor();
+    
+    // The limiter's lookahead is at the host rate already
+    if (limiterEnabled)
+        latency += limiter.getLatencySamples();
+    
+    currentLatencySamples = juce::roundToInt (latency);
+    
+    // The output stages take longer to settle than the fold chain
+    double outputSettleSeconds = 0.0;
+    
+    if (dcBlockEnabled)
+        outputSettleSeconds += dcBlocker.getSettleSeconds();
+    
+    if (limiterEnabled)
+        outputSettleSeconds += limiter.getSettleSeconds();
+    
+    // Reported to the host: the oversampling filters ring for about their length, twice
+    // their delay, then the output stages settle
+    tailSeconds = 2.0 * oversampler.getLatencyInSamples() / currentSampleRate + outputSettleSeconds;
+    
+    // Silence has to last for the filter tails before the output can be considered settled
+    silenceHoldSamples = juce::roundToInt ((silenceHoldSeconds + outputSettleSeconds) * currentSampleRate) + 2 * currentLatencySamples.load();
+}
+
+void WavefolderProcessor::timerCallback()
+{
+    // Picks up the latency changes made on the audio thread
+    if (const int latency = currentLatencySamples.load(); latency != getLatencySamples())
+        setLatencySamples (latency);
+    
+    // The table builder is shared and takes a lock to join, so LUT mode is followed from here
+    lut.setBuilding (parameters.lut->load() >= 0.5f);
+    
+    // Programs recalled on the audio thread reach the host and the editor from here. Some
+    // hosts keep a plugin prepared without calling processBlock (inactive or sleeping
+    // tracks), so a program change still pending is recalled here too: whichever thread
+    // gets to it first does it.
+    applyPendingProgram();
+    notifyRecalledProgram();
 }
 
 void WavefolderProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // juce::dsp::ProcessSpec spec;
-    // spec.maximumBlockSize = samplesPerBlock;
-    // spec.numChannels = getTotalNumOutputChannels();
-    // spec.sampleRate = sampleRate;
-    // waveshaper.prepare(spec);
-    juce::ignoreUnused(sampleRate, samplesPerBlock);
+    currentSampleRate = sampleRate;
+    
+   #if WAVEFOLDER_PERF_METER
+    blockTimer.prepare (sampleRate);
+   #endif
+    
+    // Every oversampling setting is allocated here so the audio thread can switch freely,
+    // in the precision the host will call processBlock with
+    oversampler.prepare (getTotalNumOutputChannels(), samplesPerBlock, isUsingDoublePrecision());
+    oversampler.reset();
     
+    scopeFifo.prepare (sampleRate, samplesPerBlock);
+    
+    // Split the bus into channel groups by speaker position. Discrete and ambisonic
+    // layouts have no positions, all of their channels are in the front group.
+    const auto layout = getChannelLayoutOfBus (false, 0);
+    
+    for (auto& group : groups)
+        group.channels.clear();
+    
+    for (int ch = 0; ch < getTotalNumOutputChannels(); ++ch)
+        groups[(size_t) getChannelGroup (layout.getTypeOfChannel (ch))].channels.push_back (ch);
+    
+    for (auto& group : groups)
+        group.adaa.prepare ((int) group.channels.size());
+    
+    // A stereo bus has both of its channels in the front group, the stereo modes replace it
+    stereoLayout = getTotalNumOutputChannels() == 2 && groups[0].channels.size() == 2;
+    
+    for (auto& side : stereoSides)
+        side.adaa.prepare (1);
+    
+    multiband.prepare (getTotalNumOutputChannels(), sampleRate * oversampler.getFactor(), isUsingDoublePrecision());
+    
+    // Output stages at the host rate, whether they are on or not
+    dcBlocker.prepare (getTotalNumOutputChannels(), sampleRate);
+    limiter.prepare (getTotalNumOutputChannels(), sampleRate, isUsingDoublePrecision());
+    
+    // Envelope steps of the largest block, and where the sidechain is in the host's buffers
+    envelope.prepare (sampleRate, envelopeStep);
+    modulationSteps.assign ((size_t) (samplesPerBlock / envelopeStep + 2), {});
+    lastModDriveGain = lastModThresScale = 1.0f;
+    
+    const auto* sidechain = getBus (true, 1);
+    numSidechainChannels = sidechain != nullptr && sidechain->isEnabled() ? sidechain->getNumberOfChannels() : 0;
+    firstSidechainChannel = numSidechainChannels > 0 ? getChannelIndexInProcessBlockBuffer (true, 1, 0) : 0;
+    
+    settledOutput.assign ((size_t) getTotalNumOutputChannels(), 0.0f);
+    silentSamples = 0;
+    bypassed = false;
+    
+    applyPendingProgram();
+    notifyRecalledProgram();
     updateParameters();
+    updateLatency();
+    lut.setBuilding (lutEnabled);
+    
+    // The host reads the latency right after this returns, later changes are polled for
+    setLatencySamples (currentLatencySamples.load());
+    startTimerHz (latencyPollHz);
+    
+    // Start from the current settings rather than ramping in from the defaults
+    for (auto& group : groups)
+        group.smoother.reset (sampleRate * oversampler.getFactor(), smoothingSeconds, group.params);
+    
+    for (auto& side : stereoSides)
+        side.smoother.reset (sampleRate * oversampler.getFactor(), smoothingSeconds, side.params);
+    
+    multiband.setSampleRate (sampleRate * oversampler.getFactor());
+    resetShapeRamps();
+    prepared = true;
+}
+
+void WavefolderProcessor::resetShapeRamps()
+{
+    // Ramp lengths are in samples at the fold rate, jump to the current shape
+    const double foldRate = currentSampleRate * oversampler.getFactor();
+    
+    morph.setRampLength (juce::roundToInt (smoothingSeconds * foldRate));
+    morph.setCurrentAndTarget (morph.getTarget());
+    
+    fadeLength = juce::jmax (1, juce::roundToInt (crossfadeSeconds * foldRate));
+    fadeRemaining = 0;
 }
 
 void WavefolderProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    prepared = false;
+    stopTimer();
+    applyPendingProgram();
+    notifyRecalledProgram();
+    lut.setBuilding (false);
 }
 
 bool WavefolderProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
@@ -198,16 +900,21 @@ bool WavefolderProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
     juce::ignoreUnused (layouts);
     return true;
 #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout from mono up to 64 channels: every channel is folded on its own, the
+    // layout only decides which channel group (and so which settings) it belongs to
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+    
+    if (numChannels < 1 || numChannels > Parameters::maxChannels)
         return false;
     
     // This checks if the input layout matches the output layout
 #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+    
+    // Optional sidechain, only read by the envelope follower
+    if (layouts.inputBuses.size() > 1 && layouts.getChannelSet (true, 1).size() > Parameters::maxChannels)
+        return false;
 #endif
     
     return true;
@@ -218,8 +925,34 @@ void WavefolderProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                      juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused (midiMessages);
-    
+    processBuffer (buffer);
+}
+
+void WavefolderProcessor::processBlock (juce::AudioBuffer<double>& buffer,
+                                     juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processBuffer (buffer);
+}
+
+bool WavefolderProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void WavefolderProcessor::processBuffer (juce::AudioBuffer<SampleType>& buffer)
+{
     juce::ScopedNoDenormals noDenormals;
+    
+   #if WAVEFOLDER_RT_CHECK
+    const Perf::ScopedRealtimeSection realtimeSection;
+   #endif
+    
+   #if WAVEFOLDER_PERF_METER
+    Perf::ScopedBlockTimer scopedTimer (blockTimer, buffer.getNumSamples());
+   #endif
+    
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     
@@ -227,23 +960,584 @@ void WavefolderProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    // Update params
-    updateParameters();
+    // Program changed since the last block: all of it lands before the parameters are read
+    applyPendingProgram();
+    const bool settingsChanged = updateParameters();
+    
+    // Scope taps: the input before it's folded in place, the output at the end
+    const bool scopeActive = scopeFifo.captureInput (buffer);
+    
+    // Long enough silence: the output has settled, no need to run the chain
+    if (skipSilentBlock (buffer, settingsChanged))
+    {
+        if (scopeActive)
+            scopeFifo.pushOutput (buffer);
+        
+       #if WAVEFOLDER_PERF_METER
+        scopedTimer.markSkipped();
+       #endif
+        return;
+    }
+    
+    // Split the block at the host's automation points, if any. The settings are read again
+    // after each batch of events, the first segment uses the ones read above
+    const int numSamples = buffer.getNumSamples();
+    int start = 0;
+    
+    for (int i = 0; i < numAutomationEvents; ++i)
+    {
+        const auto& event = automationEvents[(size_t) i];
+        const int offset = juce::jlimit (start, numSamples, event.sampleOffset);
+        
+        if (offset > start)
+        {
+            if (i > 0)
+                updateParameters();
+            
+            processSegment (buffer, start, offset - start);
+            start = offset;
+        }
+        
+       #if WAVEFOLDER_RT_CHECK
+        // Unavoidable: CLAP delivers automation on the audio thread and clap-juce-extensions
+        // leaves applying it to us. Setting the parameter is the only way to reach its APVTS
+        // value and listeners, which JUCE notifies under their locks, as its own VST3 and AU
+        // wrappers do for host automation. Nothing of ours is waited on.
+        const Perf::ScopedRealtimeExemption exemption ("CLAP automation: parameter listener notifications");
+       #endif
+        event.parameter->setValue (event.normalisedValue);
+        event.parameter->sendValueChangedMessageToListeners (event.normalisedValue);
+    }
+    
+    if (numAutomationEvents > 0)
+        updateParameters();
+    
+    numAutomationEvents = 0;
+    
+    if (start < numSamples)
+        processSegment (buffer, start, numSamples - start);
+    
+    // Where each channel ended up, replayed if the following blocks are silent
+    if (numSamples > 0)
+        for (int ch = 0; ch < juce::jmin (buffer.getNumChannels(), (int) settledOutput.size()); ++ch)
+            settledOutput[(size_t) ch] = (double) buffer.getSample (ch, numSamples - 1);
+    
+    if (scopeActive)
+        scopeFifo.pushOutput (buffer);
+}
+
+template <typename SampleType>
+bool WavefolderProcessor::skipSilentBlock (juce::AudioBuffer<SampleType>& buffer, bool settingsChanged)
+{
+    const int numSamples = buffer.getNumSamples();
+    
+    // Any change restarts the hold time, the settled output is no longer valid
+    if (numAutomationEvents > 0 || settingsChanged || isSmoothing() || numSamples == 0)
+    {
+        silentSamples = 0;
+        bypassed = false;
+        return false;
+    }
+    
+    // No shape is steeper than SinFold's pi / 2, so the input can't move the output by more
+    // than this: treat the block as silent if that stays below the threshold, whatever
+    // the drive. Bias only adds a constant, which is in the settled output already.
+    constexpr auto maxSlope = (float) FoldDSP::Shapes::maxSlope;
+    float inputToOutputGain = 0.0f;
+    
+    if (multiband.getNumBands() > 1)
+    {
+        // The bands add up, and none of them has a gain above 1 before its fold
+        for (int b = 0; b < multiband.getNumBands(); ++b)
+            inputToOutputGain += foldParams.outGain * (foldParams.mix * bandDriveGain[(size_t) b] * maxSlope + 1.0f - foldParams.mix);
+    }
+    else
+    {
+        const auto getGain = [] (const FoldDSP::FoldParams& p) { return p.outGain * (p.mix * p.drive * maxSlope + 1.0f - p.mix); };
+        
+        for (const auto& group : groups)
+            if (! group.channels.empty())
+                inputToOutputGain = juce::jmax (inputToOutputGain, getGain (group.params));
+        
+        // Mid & side are at most as loud as the input, and both end up in each channel
+        if (isStereoActive())
+        {
+            const float first = getGain (stereoSides[0].params), second = getGain (stereoSides[1].params);
+            inputToOutputGain = juce::jmax (inputToOutputGain, stereoMode == Parameters::stereoModeMidSide ? first + second
+                                                                                                           : juce::jmax (first, second));
+        }
+    }
     
-    // Process
-    switch (wfType) {
-        case 0:
-            wf.foldToRangeBuffer(buffer);
-            break;
-        case 1:
-            wf.foldSinBuffer(buffer);
-            break;
-        case 2:
-            wf.comboFoldBuffer(buffer);
-            break;
+    // The output stages never raise the level (the DC blocker by a few thousandths of a dB at
+    // most), the envelope can raise the drive by up to its depth
+    if (modulating)
+        inputToOutputGain *= juce::Decibels::decibelsToGain (juce::jmax (0.0f, envDriveDepthDb));
+    
+    // The main bus only, and the sidechain when it moves the settings
+    const int numMainChannels = juce::jmin (getTotalNumOutputChannels(), buffer.getNumChannels());
+    float peak = 0.0f;
+    
+    for (int ch = 0; ch < numMainChannels; ++ch)
+        peak = juce::jmax (peak, (float) buffer.getMagnitude (ch, 0, numSamples));
+    
+    if (modulating && envFromSidechain)
+        for (int ch = firstSidechainChannel; ch < juce::jmin (firstSidechainChannel + numSidechainChannels, buffer.getNumChannels()); ++ch)
+            peak = juce::jmax (peak, (float) buffer.getMagnitude (ch, 0, numSamples));
+    
+    if (peak * inputToOutputGain >= silenceThreshold)
+    {
+        silentSamples = 0;
+        bypassed = false;
+        return false;
+    }
+    
+    if (! bypassed)
+    {
+        // Keep running the chain until the filters have rung out
+        silentSamples += numSamples;
+    
+        if (silentSamples < silenceHoldSamples)
+            return false;
+    
+        bypassed = true;
+    }
+    
+    // The oversampling filters and ADAA history are left as they were: they had settled on
+    // silence, which is what they would still be holding when the signal comes back
+    for (int ch = 0; ch < numMainChannels; ++ch)
+    {
+        const auto value = ch < (int) settledOutput.size() ? (SampleType) settledOutput[(size_t) ch] : SampleType();
+        juce::FloatVectorOperations::fill (buffer.getWritePointer (ch), value, numSamples);
+    }
+    
+    return true;
+}
+
+template <typename SampleType>
+void WavefolderProcessor::processSegment (juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples)
+{
+    // Envelope of the segment's input, before it is folded in place
+    updateModulation (buffer, startSample, numSamples);
+    
+    // Process (at the oversampled rate when enabled), the main bus only
+    const auto numMainChannels = (size_t) juce::jmin (getTotalNumOutputChannels(), buffer.getNumChannels());
+    auto block = juce::dsp::AudioBlock<SampleType> (buffer).getSubsetChannelBlock (0, numMainChannels)
+                                                           .getSubBlock ((size_t) startSample, (size_t) numSamples);
+    oversampler.process (block, [this] (juce::dsp::AudioBlock<SampleType>& b) { foldBlock (b); });
+    
+    // Output stages, back at the host rate
+    if (dcBlockEnabled)
+        dcBlocker.process (block);
+    
+    if (limiterEnabled)
+        limiter.process (block);
+}
+
+template <typename SampleType>
+void WavefolderProcessor::foldBlock (juce::dsp::AudioBlock<SampleType>& block)
+{
+    const auto numChannels = (int) block.getNumChannels();
+    std::array<SampleType*, (size_t) Parameters::maxChannels> groupChannelPointers;
+    
+    // Multiband: every channel is split and folded band by band, the groups only keep time
+    const bool multibandActive = multiband.getNumBands() > 1;
+    
+    if (multibandActive)
+        multiband.process (block);
+    
+    // Stereo modes: the sides fold the front channels instead of the front group
+    const bool stereoActive = isStereoActive() && numChannels == 2;
+    
+    if (stereoActive)
+        foldStereo (block);
+    else
+        for (auto& side : stereoSides)
+            side.smoother.skip ((int) block.getNumSamples());
+    
+    for (auto& group : groups)
+    {
+        // View of the group's channels only, they needn't be next to each other on the bus
+        size_t numGroupChannels = 0;
+        
+        for (const int ch : group.channels)
+            if (ch < numChannels)
+                groupChannelPointers[numGroupChannels++] = block.getChannelPointer ((size_t) ch);
+        
+        if (numGroupChannels == 0 || multibandActive || (stereoActive && &group == &groups[0]))
+        {
+            group.smoother.skip ((int) block.getNumSamples());
+            continue;
+        }
+        
+        juce::dsp::AudioBlock<SampleType> groupBlock (groupChannelPointers.data(), numGroupChannels, block.getNumSamples());
+        foldGroup (group, groupBlock);
+    }
+    
+    // Every group has folded this block with the same shape, move it along
+    const auto numSamples = (int) block.getNumSamples();
+    morph.skip (numSamples);
+    fadeRemaining = juce::jmax (0, fadeRemaining - numSamples);
+}
+
+template <typename SampleType>
+void WavefolderProcessor::foldStereo (juce::dsp::AudioBlock<SampleType>& block)
+{
+    std::array<SampleType*, 2> channels { block.getChannelPointer (0), block.getChannelPointer (1) };
+    const auto numSamples = (int) block.getNumSamples();
+    
+    if (stereoMode == Parameters::stereoModeLeftRight)
+    {
+        for (size_t s = 0; s < stereoSides.size(); ++s)
+        {
+            juce::dsp::AudioBlock<SampleType> sideBlock (&channels[s], 1, (size_t) numSamples);
+            foldGroup (stereoSides[s], sideBlock);
+        }
+        
+        return;
+    }
+    
+    // Mid/side, one chunk at a time: encoded into the scratch channels, folded there by the
+    // same kernels as any group, and decoded straight back onto the bus
+    std::array<SampleType, (size_t) stereoChunk> mid, side;
+    std::array<SampleType*, 2> scratch { mid.data(), side.data() };
+    
+    for (int start = 0; start < numSamples; start += stereoChunk)
+    {
+        const int length = juce::jmin (stereoChunk, numSamples - start);
+        auto* left = channels[0] + start;
+        auto* right = channels[1] + start;
+        
+        for (int i = 0; i < length; ++i)
+        {
+            mid[(size_t) i] = (left[i] + right[i]) * (SampleType) 0.5;
+            side[(size_t) i] = (left[i] - right[i]) * (SampleType) 0.5;
+        }
+        
+        for (size_t s = 0; s < stereoSides.size(); ++s)
+        {
+            juce::dsp::AudioBlock<SampleType> sideBlock (&scratch[s], 1, (size_t) length);
+            foldGroup (stereoSides[s], sideBlock, start);
+        }
+        
+        for (int i = 0; i < length; ++i)
+        {
+            left[i] = mid[(size_t) i] + side[(size_t) i];
+            right[i] = mid[(size_t) i] - side[(size_t) i];
+        }
+    }
+}
+
+template <typename SampleType>
+void WavefolderProcessor::foldGroup (ChannelGroup& group, juce::dsp::AudioBlock<SampleType>& block, int blockOffset)
+{
+    const auto numSamples = (int) block.getNumSamples();
+    
+    // The table is baked for the targets, so it only takes over once the ramp towards them
+    // is over: the exact kernels below ramp, jumping to the table would step. It is baked for
+    // the main settings, so unlinked groups with their own settings keep using the kernels,
+    // and for a single type, so crossfades and morphs do too. Until a table of the current
+    // type and settings is ready the exact kernels are used as well.
+    if (lutEnabled && aaMode == 0 && group.params == foldParams && ! group.smoother.isSmoothing()
+        && wfType != Parameters::wfTypeMorph && ! isShapeChanging() && ! modulating)
+    {
+        if (auto* table = lut.acquire(); table != nullptr && (int) table->type == wfType && table->params == group.params)
+        {
+            for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+                FoldDSP::TransferLut::process (*table, block.getChannelPointer (ch), numSamples);
+            
+            group.smoother.skip (numSamples);
+            return;
+        }
+    }
+    
+    int start = 0;
+    
+    // Fold in segments over which neither the shape nor any parameter reaches its target,
+    // nor the modulation the end of its step. Once everything has settled, the rest of the
+    // block is a single static segment. Shape & modulation offsets are from the start of the
+    // whole fold block, which this one may only be a chunk of.
+    while (start < numSamples)
+    {
+        const bool smoothing = group.smoother.isSmoothing();
+        const bool ramping = smoothing || modulating;
+        const int offset = blockOffset + start;
+        const int maxLength = aaMode != 0 && ramping ? adaaSmoothingStep : numSamples - start;
+        auto shape = getShapeSegment (offset, juce::jmin (maxLength, numSamples - start));
+        
+        if (smoothing)
+            shape.length = group.smoother.getSegmentLength (shape.length);
+        
+        if (modulating)
+            shape.length = juce::jmin (shape.length, getModulationStepLength() - offset % getModulationStepLength());
+        
+        auto segment = block.getSubBlock ((size_t) start, (size_t) shape.length);
+        foldSegment (group, segment, offset, ramping, shape);
+        
+        if (smoothing)
+            group.smoother.skip (shape.length);
+        
+        start += shape.length;
+    }
+}
+
+template <typename SampleType>
+void WavefolderProcessor::foldSegment (ChannelGroup& group, juce::dsp::AudioBlock<SampleType>& block, int offset, bool ramping, const ShapeSegment& shape)
+{
+    const auto numSamples = (int) block.getNumSamples();
+    auto current = group.smoother.getCurrent();
+    auto ramp = ramping ? group.smoother.getRamp() : FoldDSP::FoldRamp {};
+    
+    if (modulating)
+        applyModulation (offset, current, ramp);
+    
+    // ADAA runs sample by sample anyway, while ramping its settings are stepped per segment,
+    // and so are the blend weights
+    if (aaMode != 0)
+    {
+        if (shape.blended)
+            group.adaa.process (block, shape.blend, (FoldDSP::AdaaFolder::Order) aaMode, current);
+        else
+            group.adaa.process (block, shape.type, (FoldDSP::AdaaFolder::Order) aaMode, current);
+        
+        return;
+    }
+    
+    // Both shapes at once, only while crossfading or morphing
+    if (shape.blended)
+    {
+        const auto kernel = kernels.getBlended<SampleType> (ramping);
+        
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+            kernel (block.getChannelPointer (ch), numSamples, current, ramp, shape.blend);
+        
+        return;
+    }
+    
+    if (ramping)
+    {
+        const auto kernel = kernels.getRamped<SampleType> (shape.type);
+        
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+            kernel (block.getChannelPointer (ch), numSamples, current, ramp);
+        
+        return;
+    }
+    
+    // Cheapest kernel that is exact for these settings (e.g. no bias, 100% wet by default)
+    const auto kernel = kernels.select<SampleType> (shape.type, group.params);
+    
+    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        kernel (block.getChannelPointer (ch), numSamples, current);
+}
+
+//==============================================================================
+float WavefolderProcessor::getMorphAt (int offset) const noexcept
+{
+    // Exactly the target once the ramp is over, so a position on one of the types is recognised
+    if (offset >= morph.getRemaining())
+        return morph.getTarget();
+    
+    return morph.getCurrent() + morph.getStep() * (float) offset;
+}
+
+FoldDSP::ShapeBlend WavefolderProcessor::getBlendAt (int offset) const noexcept
+{
+    const auto target = wfType == Parameters::wfTypeMorph ? FoldDSP::getMorphBlend (getMorphAt (offset))
+                                                          : FoldDSP::getShapeBlend ((FoldDSP::FoldType) wfType);
+    const int fadeLeft = fadeRemaining - offset;
+    
+    if (fadeLeft <= 0)
+        return target;
+    
+    // Equal power: cos / sin over a quarter turn
+    const float angle = juce::MathConstants<float>::halfPi * (float) (fadeLength - fadeLeft) / (float) fadeLength;
+    const float from = std::cos (angle), to = std::sin (angle);
+    
+    return { from * fadeFrom.triangle + to * target.triangle, from * fadeFrom.sine + to * target.sine };
+}
+
+WavefolderProcessor::ShapeSegment WavefolderProcessor::getShapeSegment (int offset, int maxLength) const noexcept
+{
+    ShapeSegment segment;
+    segment.length = maxLength;
+    
+    const int fadeLeft = fadeRemaining - offset;
+    const int morphLeft = wfType == Parameters::wfTypeMorph ? morph.getRemaining() - offset : 0;
+    
+    if (fadeLeft <= 0 && morphLeft <= 0)
+    {
+        // Settled: a morph position right on one of the types runs that type's own kernel
+        const float position = wfType == Parameters::wfTypeMorph ? getMorphAt (offset) : (float) wfType;
+        
+        if (position == 0.0f || position == 1.0f || position == 2.0f)
+        {
+            segment.type = (FoldDSP::FoldType) (int) position;
+            return segment;
+        }
+        
+        segment.blended = true;
+        segment.blend = FoldDSP::getMorphBlend (position);
+        return segment;
+    }
+    
+    // Linear in between the weights every shapeStep samples, stopping where a ramp ends
+    segment.length = juce::jmin (maxLength, shapeStep);
+    
+    if (fadeLeft > 0)
+        segment.length = juce::jmin (segment.length, fadeLeft);
+    
+    if (morphLeft > 0)
+        segment.length = juce::jmin (segment.length, morphLeft);
+    
+    const auto first = getBlendAt (offset);
+    const auto last = getBlendAt (offset + segment.length);
+    
+    segment.blended = true;
+    segment.blend = first;
+    segment.blend.triangleDelta = (last.triangle - first.triangle) / (float) segment.length;
+    segment.blend.sineDelta = (last.sine - first.sine) / (float) segment.length;
+    return segment;
+}
+
+FoldDSP::FoldParams WavefolderProcessor::getDisplayParams() const noexcept
+{
+    FoldDSP::FoldParams p;
+    p.drive = juce::Decibels::decibelsToGain (parameters.drive->load());
+    p.outGain = juce::Decibels::decibelsToGain (parameters.outGain->load());
+    p.biasPre = parameters.biasPre->load();
+    p.biasPost = parameters.biasPost->load();
+    p.threshold = parameters.thres->load();
+    p.mix = parameters.mix->load() / 100.0f;
+    return p;
+}
+
+FoldDSP::ShapeBlend WavefolderProcessor::getDisplayShape() const noexcept
+{
+    const int type = juce::jlimit (0, Parameters::wfTypeMorph, (int) parameters.wfType->load());
+    
+    if (type == Parameters::wfTypeMorph)
+        return FoldDSP::getMorphBlend (parameters.morph->load());
+    
+    return FoldDSP::getShapeBlend ((FoldDSP::FoldType) type);
+}
+
+bool WavefolderProcessor::hasState() const noexcept
+{
+    // The stereo sides share the main ADAA and oversampling settings. The bands choice is
+    // the number of bands minus one.
+    return (int) parameters.aaMode->load() != 0
+        || (int) parameters.os->load() != 0
+        || (int) parameters.numBands->load() > 0
+        || parameters.envDriveDepth->load() != 0.0f
+        || parameters.envThresDepth->load() != 0.0f
+        || parameters.dcBlock->load() >= 0.5f
+        || parameters.limiter->load() >= 0.5f;
+}
+
+bool WavefolderProcessor::isSmoothing() const noexcept
+{
+    if (isShapeChanging() || multiband.isSmoothing())
+        return true;
+    
+    // The modulated drive moves the settled output while the envelope decays, or while
+    // ramping back after the depths were set to 0
+    if (modulating && (envelope.getLevel() > envelopeSettledLevel || (envDriveDepthDb == 0.0f && envThresDepth == 0.0f)))
+        return true;
+    
+    for (const auto& group : groups)
+        if (group.smoother.isSmoothing())
+            return true;
+    
+    if (isStereoActive())
+        for (const auto& side : stereoSides)
+            if (side.smoother.isSmoothing())
+                return true;
+    
+    return false;
+}
+
+int WavefolderProcessor::getChannelGroup (juce::AudioChannelSet::ChannelType type) noexcept
+{
+    using Set = juce::AudioChannelSet;
+    
+    switch (type)
+    {
+        case Set::LFE:
+        case Set::LFE2:
+            return 1;
+            
+        case Set::leftSurround:
+        case Set::rightSurround:
+        case Set::centreSurround:
+        case Set::leftSurroundSide:
+        case Set::rightSurroundSide:
+        case Set::leftSurroundRear:
+        case Set::rightSurroundRear:
+            return 2;
+            
+        case Set::topMiddle:
+        case Set::topFrontLeft:
+        case Set::topFrontCentre:
+        case Set::topFrontRight:
+        case Set::topRearLeft:
+        case Set::topRearCentre:
+        case Set::topRearRight:
+        case Set::topSideLeft:
+        case Set::topSideRight:
+        case Set::bottomFrontLeft:
+        case Set::bottomFrontCentre:
+        case Set::bottomFrontRight:
+        case Set::bottomSideLeft:
+        case Set::bottomSideRight:
+        case Set::bottomRearLeft:
+        case Set::bottomRearCentre:
+        case Set::bottomRearRight:
+            return 3;
+            
         default:
-            wf.foldToRangeBuffer(buffer);
-            break;
+            return 0;
+    }
+}
+
+//==============================================================================
+bool WavefolderProcessor::supportsDirectEvent (uint16_t spaceId, uint16_t type)
+{
+    return spaceId == CLAP_CORE_EVENT_SPACE_ID && type == CLAP_EVENT_PARAM_VALUE;
+}
+
+void WavefolderProcessor::handleDirectEvent (const clap_event_header_t* event, int sampleOffset)
+{
+    if (! supportsDirectEvent (event->space_id, event->type))
+        return;
+    
+    const auto* paramEvent = reinterpret_cast<const clap_event_param_value_t*> (event);
+    const uint32_t paramId = paramEvent->param_id;
+    
+    const auto found = std::lower_bound (clapParameterIds.begin(), clapParameterIds.end(), paramId,
+                                         [] (const auto& entry, uint32_t id) { return entry.first < id; });
+    
+    if (found == clapParameterIds.end() || found->first != paramId)
+        return;
+    
+    auto* param = found->second;
+    
+    // The wrapper exposes every parameter in its normalised 0..1 range
+    const auto value = (float) paramEvent->value;
+    
+    if (numAutomationEvents < (int) automationEvents.size())
+    {
+        automationEvents[(size_t) numAutomationEvents++] = { sampleOffset, param, value };
+    }
+    else
+    {
+        // Queue full: fall back to applying the change at the start of the block
+       #if WAVEFOLDER_RT_CHECK
+        // Unavoidable, same as in processBuffer: the event has to reach the parameter now
+        // and only setValue does that. Rare, it needs more than 512 events in one block.
+        const Perf::ScopedRealtimeExemption exemption ("CLAP automation overflow: parameter listener notifications");
+       #endif
+        param->setValue (value);
+        param->sendValueChangedMessageToListeners (value);
     }
 }
 
@@ -262,17 +1556,32 @@ juce::AudioProcessorEditor* WavefolderProcessor::createEditor()
 //==============================================================================
 void WavefolderProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    juce::ignoreUnused (destData);
+    // A program change the audio thread hasn't picked up or notified yet is part of the
+    // state already
+    applyPendingProgram();
+    notifyRecalledProgram();
+    
+    auto state = apvts.copyState();
+    state.setProperty (programPropertyId, currentProgram.load(), nullptr);
+    
+    if (auto xml = state.createXml())
+        copyXmlToBinary (*xml, destData);
 }
 
 void WavefolderProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-    juce::ignoreUnused (data, sizeInBytes);
+    auto xml = getXmlFromBinary (data, sizeInBytes);
+    
+    if (xml == nullptr || ! xml->hasTagName (apvts.state.getType()))
+        return;
+    
+    // The saved values win over a program change still in flight
+    pendingProgram.store (-1);
+    recalledProgram.store (-1);
+    
+    auto state = juce::ValueTree::fromXml (*xml);
+    currentProgram = juce::jlimit (0, getNumPrograms() - 1, (int) state.getProperty (programPropertyId, 0));
+    apvts.replaceState (state);
 }
 
 //==============================================================================
@@ -1,7 +1,21 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <clap-juce-extensions/clap-juce-extensions.h>
 #include "punk_dsp/punk_dsp.h"
+#include "display/ScopeFifo.h"
+#include "dsp/AdaaFolder.h"
+#include "dsp/DcBlocker.h"
+#include "dsp/EnvelopeFollower.h"
+#include "dsp/FoldKernels.h"
+#include "dsp/MultibandFolder.h"
+#include "dsp/Oversampler.h"
+#include "dsp/ParameterSmoother.h"
+#include "dsp/TransferLut.h"
+#include "dsp/TruePeakLimiter.h"
+#include "perf/PerfMeter.h"
+#include "perf/RealtimeCheck.h"
+#include "presets/PresetBank.h"
 
 #if (MSVC)
 #include "ipps.h"
@@ -45,9 +59,142 @@ namespace Parameters
     constexpr auto mixDefault = 100.0f;
     constexpr auto mixMin = 0.0f;
     constexpr auto mixMax = 100.0f;
+
+    // Wavefolder type, the last choice follows the morph position instead
+    constexpr auto wfTypeId = "wavefolder";
+    constexpr auto wfTypeName = "Wavefolder Type";
+    constexpr int wfTypeMorph = 3;
+    
+    // Morph position (FoldToRange -> SinFold -> ComboFold)
+    constexpr auto morphId = "morph";
+    constexpr auto morphName = "Morph";
+    constexpr auto morphDefault = 0.0f;
+    constexpr auto morphMin = 0.0f;
+    constexpr auto morphMax = 2.0f;
+
+    // Anti-aliasing mode (Off, ADAA 1st order, ADAA 2nd order)
+    constexpr auto aaModeId = "aaMode";
+    constexpr auto aaModeName = "AA Mode";
+    constexpr auto aaModeDefault = 0;
+
+    // Baked transfer-function lookup table
+    constexpr auto lutId = "lut";
+    constexpr auto lutName = "LUT Mode";
+    constexpr auto lutDefault = false;
+
+    // Oversampling (1x, 2x, 4x, 8x, 16x)
+    constexpr auto osId = "oversampling";
+    constexpr auto osName = "Oversampling";
+    constexpr auto osDefault = 0;
+
+    // Oversampling filter phase
+    constexpr auto osPhaseId = "osPhase";
+    constexpr auto osPhaseName = "Oversampling Filters";
+    constexpr auto osPhaseDefault = 0;
+
+    // Channel groups of multichannel layouts (Front, LFE, Surround, Height). A linked group
+    // follows the main drive & threshold, an unlinked one uses its own
+    constexpr int numChannelGroups = 4;
+    constexpr const char* groupNames[numChannelGroups] = { "Front", "LFE", "Surround", "Height" };
+    constexpr const char* groupLinkIds[numChannelGroups] = { "frontLink", "lfeLink", "surroundLink", "heightLink" };
+    constexpr const char* groupDriveIds[numChannelGroups] = { "frontDrive", "lfeDrive", "surroundDrive", "heightDrive" };
+    constexpr const char* groupThresIds[numChannelGroups] = { "frontThres", "lfeThres", "surroundThres", "heightThres" };
+    constexpr auto groupLinkDefault = true;
+
+    // Multiband mode (Off, 2, 3 or 4 bands). Each band folds with its own type, drive &
+    // threshold, the other settings are the main ones
+    constexpr auto bandsId = "bands";
+    constexpr auto bandsName = "Bands";
+    constexpr auto bandsDefault = 0;
+    constexpr int maxBands = FoldDSP::MultibandFolder::maxBands;
+    constexpr const char* bandNames[maxBands] = { "Band 1", "Band 2", "Band 3", "Band 4" };
+    constexpr const char* bandTypeIds[maxBands] = { "band1Type", "band2Type", "band3Type", "band4Type" };
+    constexpr const char* bandDriveIds[maxBands] = { "band1Drive", "band2Drive", "band3Drive", "band4Drive" };
+    constexpr const char* bandThresIds[maxBands] = { "band1Thres", "band2Thres", "band3Thres", "band4Thres" };
+    
+    // Crossover frequencies (Hz) between consecutive bands
+    constexpr const char* crossoverIds[maxBands - 1] = { "crossover1", "crossover2", "crossover3" };
+    constexpr const char* crossoverNames[maxBands - 1] = { "Crossover 1 (Hz)", "Crossover 2 (Hz)", "Crossover 3 (Hz)" };
+    constexpr float crossoverDefaults[maxBands - 1] = { 200.0f, 1000.0f, 5000.0f };
+    constexpr auto crossoverMin = 20.0f;
+    constexpr auto crossoverMax = 20000.0f;
+
+    // Envelope follower on the input (or the sidechain), modulating drive & threshold
+    constexpr auto envSourceId = "envSource";
+    constexpr auto envSourceName = "Envelope Source";
+    constexpr auto envSourceDefault = 0;
+    
+    constexpr auto envModeId = "envMode";
+    constexpr auto envModeName = "Envelope Mode";
+    constexpr auto envModeDefault = 0;
+    
+    constexpr auto envAttackId = "envAttack";
+    constexpr auto envAttackName = "Envelope Attack (ms)";
+    constexpr auto envAttackDefault = 5.0f;
+    constexpr auto envAttackMin = 0.1f;
+    constexpr auto envAttackMax = 200.0f;
+    
+    constexpr auto envReleaseId = "envRelease";
+    constexpr auto envReleaseName = "Envelope Release (ms)";
+    constexpr auto envReleaseDefault = 150.0f;
+    constexpr auto envReleaseMin = 5.0f;
+    constexpr auto envReleaseMax = 2000.0f;
+    
+    // Drive change (dB) at full scale
+    constexpr auto envDriveDepthId = "envDriveDepth";
+    constexpr auto envDriveDepthName = "Envelope Drive Depth (dB)";
+    constexpr auto envDriveDepthDefault = 0.0f;
+    constexpr auto envDriveDepthMin = -24.0f;
+    constexpr auto envDriveDepthMax = 24.0f;
+    
+    // Relative threshold change at full scale
+    constexpr auto envThresDepthId = "envThresDepth";
+    constexpr auto envThresDepthName = "Envelope Threshold Depth";
+    constexpr auto envThresDepthDefault = 0.0f;
+    constexpr auto envThresDepthMin = -0.9f;
+    constexpr auto envThresDepthMax = 1.0f;
+
+    // Output stages after the fold: DC blocker, then a lookahead true-peak limiter
+    constexpr auto dcBlockId = "dcBlock";
+    constexpr auto dcBlockName = "DC Blocker";
+    constexpr auto dcBlockDefault = false;
+    
+    constexpr auto limiterId = "limiter";
+    constexpr auto limiterName = "Limiter";
+    constexpr auto limiterDefault = false;
+    
+    constexpr auto limiterCeilingId = "limiterCeiling";
+    constexpr auto limiterCeilingName = "Limiter Ceiling (dBTP)";
+    constexpr auto limiterCeilingDefault = -1.0f;
+    constexpr auto limiterCeilingMin = -24.0f;
+    constexpr auto limiterCeilingMax = 0.0f;
+    
+    constexpr auto limiterReleaseId = "limiterRelease";
+    constexpr auto limiterReleaseName = "Limiter Release (ms)";
+    constexpr auto limiterReleaseDefault = 100.0f;
+    constexpr auto limiterReleaseMin = 10.0f;
+    constexpr auto limiterReleaseMax = 1000.0f;
+
+    // Stereo mode of stereo layouts: both channels on the main settings (linked), or left &
+    // right, or mid & side, each side with its own drive, pre-drive bias & threshold
+    constexpr auto stereoModeId = "stereoMode";
+    constexpr auto stereoModeName = "Stereo Mode";
+    constexpr auto stereoModeDefault = 0;
+    constexpr int stereoModeLeftRight = 1;
+    constexpr int stereoModeMidSide = 2;
+    constexpr int numStereoSides = 2;
+    constexpr const char* stereoSideNames[numStereoSides] = { "Left / Mid", "Right / Side" };
+    constexpr const char* stereoDriveIds[numStereoSides] = { "stereo1Drive", "stereo2Drive" };
+    constexpr const char* stereoBiasIds[numStereoSides] = { "stereo1Bias", "stereo2Bias" };
+    constexpr const char* stereoThresIds[numStereoSides] = { "stereo1Thres", "stereo2Thres" };
+
+    // Widest bus layout accepted, in channels
+    constexpr int maxChannels = 64;
 }
 
-class WavefolderProcessor : public juce::AudioProcessor
+class WavefolderProcessor : public juce::AudioProcessor,
+                            public clap_juce_extensions::clap_juce_audio_processor_capabilities,
+                            private juce::Timer
 {
 public:
     WavefolderProcessor();
@@ -60,6 +207,8 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -80,16 +229,299 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
+    // CLAP sample-accurate automation ==============================================
+    bool supportsDirectEvent (uint16_t spaceId, uint16_t type) override;
+    void handleDirectEvent (const clap_event_header_t* event, int sampleOffset) override;
+    
     // ===== MY STUFF ===============================================================
     juce::AudioProcessorValueTreeState apvts;
     
-    void updateParameters();
+    /** Returns true if any setting changed since the last call. */
+    bool updateParameters();
+    
+    /** Saves the current settings as a new user program and writes the user bank. Returns
+        the program index, or -1 if the bank is full or couldn't be written. Message thread only. */
+    int saveUserPreset (const juce::String& name);
+    
+    /** Max error of the current lookup table against the exact chain (LUT mode only). */
+    float getLutMaxError() const noexcept { return lut.getMaxError(); }
+    
+    /** True once the background thread has baked a table, so offline renders can wait for it. */
+    bool isLutReady() const noexcept { return lut.getNumBuilds() > 0; }
+    
+    /** Decimated input & output of the first channel, read by the editor's scope. */
+    Display::ScopeFifo& getScopeFifo() noexcept { return scopeFifo; }
+    
+    /** Main settings and fold shape as the parameters currently stand, for the transfer
+        curve display. Message thread, reads the parameters and not the audio thread state. */
+    FoldDSP::FoldParams getDisplayParams() const noexcept;
+    FoldDSP::ShapeBlend getDisplayShape() const noexcept;
+    
+    /** True if the output depends on earlier input as the parameters currently stand: ADAA
+        (in every stereo mode), oversampling, multiband crossovers, envelope modulation, the
+        DC blocker or the limiter. Otherwise each sample is folded on its own, so offline
+        renders can be split anywhere. Reads the parameters, any thread. */
+    bool hasState() const noexcept;
+    
+   #if WAVEFOLDER_PERF_METER
+    /** Callback timing, read by the editor's load meter. */
+    Perf::BlockTimer& getBlockTimer() noexcept { return blockTimer; }
+   #endif
 
 private:
     juce::AudioProcessorValueTreeState::ParameterLayout createParams();
+    void addFactoryPresets();
+    
+    // Shared by the float and double processBlock, every stage computes in SampleType
+    template <typename SampleType>
+    void processBuffer (juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType>
+    bool skipSilentBlock (juce::AudioBuffer<SampleType>& buffer, bool settingsChanged);
+    template <typename SampleType>
+    void processSegment (juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+    template <typename SampleType>
+    void foldBlock (juce::dsp::AudioBlock<SampleType>& block);
+    void updateLatency();
+    void timerCallback() override;
+    
+    // Raw parameter values, looked up once instead of by string ID on every block
+    struct ParameterPointers
+    {
+        std::atomic<float>* drive = nullptr;
+        std::atomic<float>* outGain = nullptr;
+        std::atomic<float>* biasPre = nullptr;
+        std::atomic<float>* biasPost = nullptr;
+        std::atomic<float>* thres = nullptr;
+        std::atomic<float>* mix = nullptr;
+        std::atomic<float>* wfType = nullptr;
+        std::atomic<float>* morph = nullptr;
+        std::atomic<float>* aaMode = nullptr;
+        std::atomic<float>* lut = nullptr;
+        std::atomic<float>* os = nullptr;
+        std::atomic<float>* osPhase = nullptr;
+    
+        struct Group
+        {
+            std::atomic<float>* link = nullptr;
+            std::atomic<float>* drive = nullptr;
+            std::atomic<float>* thres = nullptr;
+        };
+    
+        std::array<Group, Parameters::numChannelGroups> groups;
+    
+        std::atomic<float>* numBands = nullptr;
+        std::array<std::atomic<float>*, Parameters::maxBands - 1> crossovers {};
+    
+        struct Band
+        {
+            std::atomic<float>* type = nullptr;
+            std::atomic<float>* drive = nullptr;
+            std::atomic<float>* thres = nullptr;
+        };
+    
+        std::array<Band, Parameters::maxBands> bands;
+    
+        std::atomic<float>* envSource = nullptr;
+        std::atomic<float>* envMode = nullptr;
+        std::atomic<float>* envAttack = nullptr;
+        std::atomic<float>* envRelease = nullptr;
+        std::atomic<float>* envDriveDepth = nullptr;
+        std::atomic<float>* envThresDepth = nullptr;
+    
+        std::atomic<float>* dcBlock = nullptr;
+        std::atomic<float>* limiter = nullptr;
+        std::atomic<float>* limiterCeiling = nullptr;
+        std::atomic<float>* limiterRelease = nullptr;
+    
+        std::atomic<float>* stereoMode = nullptr;
+    
+        struct StereoSide
+        {
+            std::atomic<float>* drive = nullptr;
+            std::atomic<float>* bias = nullptr;
+            std::atomic<float>* thres = nullptr;
+        };
+    
+        std::array<StereoSide, Parameters::numStereoSides> stereoSides;
+    };
+    
+    ParameterPointers parameters;
+    
+    int wfType = 0; // Index for choosing wavefolder, or Parameters::wfTypeMorph
+    
+    // Programs: factory presets then the user bank, pre-parsed into parameter values. A program
+    // change while playing is handed to the audio thread, which copies the whole preset into
+    // the raw parameter values at the start of its next block, so no block ever runs with half
+    // of it. The parameters, host and listeners catch up on the message thread (timerCallback).
+    Presets::PresetBank presets { *this };
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<int> pendingProgram { -1 };
+    std::atomic<int> recalledProgram { -1 };    // Recalled, not notified yet
+    std::atomic<bool> prepared { false };
+    std::vector<std::atomic<float>*> rawParameterValues;    // getParameters() order
+    static constexpr auto programPropertyId = "program";
+    
+    void applyPendingProgram() noexcept;
+    void notifyRecalledProgram();
+    
+    // Vectorized fold kernels for this CPU, picked once at construction
+    const FoldDSP::Kernels::KernelTable& kernels;
+    
+    FoldDSP::FoldParams foldParams; // Linear-domain targets of the main (linked) settings
+    int aaMode = 0;                 // Antiderivative anti-aliasing, 0 = off, otherwise the ADAA order
+    
+    static constexpr double smoothingSeconds = 0.02;
+    static constexpr int adaaSmoothingStep = 32; // ADAA is stepped at this rate instead
+    double currentSampleRate = 44100.0;
+    float lastDriveDb = std::numeric_limits<float>::quiet_NaN();
+    float lastOutGainDb = std::numeric_limits<float>::quiet_NaN();
+    
+    // Channels sharing the same settings, processed together one channel at a time. The
+    // kernels vectorise along time, so every group runs at full width whatever its size.
+    struct ChannelGroup
+    {
+        FoldDSP::FoldParams params;                             // Targets, the main ones when linked
+        FoldDSP::FoldParamSmoother smoother;                    // Per-sample smoothing towards params
+        FoldDSP::AdaaFolder adaa;                               // History of the group's channels
+        std::vector<int> channels;                              // Bus channels in this group
+        float lastDriveDb = std::numeric_limits<float>::quiet_NaN();
+        float driveGain = 1.0f;                                 // Own drive, when unlinked
+    };
+    
+    std::array<ChannelGroup, Parameters::numChannelGroups> groups;
+    
+    // Fold shape, shared by every group. Type changes crossfade from the old shape to the new
+    // one with equal power, and the morph position is smoothed like the other parameters. Both
+    // run as a blend of the triangle and sine folds (see FoldDSP::ShapeBlend), so only those
+    // segments pay for two shapes: a pure type runs its own kernel.
+    static constexpr double crossfadeSeconds = 0.01;
+    static constexpr int shapeStep = 32; // Blend weights are interpolated linearly in between
+    FoldDSP::ParameterRamp morph { FoldDSP::ParameterRamp::Mode::linear };
+    FoldDSP::ShapeBlend fadeFrom;        // Shape when the crossfade started
+    int fadeLength = 1, fadeRemaining = 0;
+    
+    struct ShapeSegment
+    {
+        int length = 0;
+        bool blended = false;
+        FoldDSP::FoldType type = FoldDSP::FoldType::foldToRange; // When not blended
+        FoldDSP::ShapeBlend blend;
+    };
+    
+    void resetShapeRamps();
+    float getMorphAt (int offset) const noexcept;
+    FoldDSP::ShapeBlend getBlendAt (int offset) const noexcept;
+    ShapeSegment getShapeSegment (int offset, int maxLength) const noexcept;
+    bool isShapeChanging() const noexcept { return fadeRemaining > 0 || (wfType == Parameters::wfTypeMorph && morph.isSmoothing()); }
+    
+    static int getChannelGroup (juce::AudioChannelSet::ChannelType type) noexcept;
+    bool isSmoothing() const noexcept;
+    template <typename SampleType>
+    void foldGroup (ChannelGroup& group, juce::dsp::AudioBlock<SampleType>& block, int blockOffset = 0);
+    template <typename SampleType>
+    void foldSegment (ChannelGroup& group, juce::dsp::AudioBlock<SampleType>& block, int offset, bool ramping, const ShapeSegment& shape);
+    
+    // Multiband mode, replaces the channel groups while on. Runs the memoryless chain only,
+    // so ADAA is left out, and the fold shape of each band is switched without crossfading.
+    FoldDSP::MultibandFolder multiband { kernels };
+    std::array<float, Parameters::maxBands> lastBandDriveDb, bandDriveGain;
+    
+    bool updateBands (const FoldDSP::FoldParams& targets);
+    
+    // Stereo modes, in place of the front group while on (stereo layouts only, and not in
+    // multiband mode). Each side is a group of one channel with its own settings: left/right
+    // folds the bus channels in place, mid/side encodes, folds and decodes the block one
+    // chunk at a time, so the chunk stays in cache between the steps and the bus is read and
+    // written once, as in the linked mode.
+    static constexpr int stereoChunk = 256;
+    std::array<ChannelGroup, Parameters::numStereoSides> stereoSides;
+    int stereoMode = 0;
+    bool stereoLayout = false;
+    
+    bool updateStereoSides (const FoldDSP::FoldParams& targets, bool typeChanged);
+    bool isStereoActive() const noexcept { return stereoLayout && stereoMode != 0 && multiband.getNumBands() < 2; }
+    template <typename SampleType>
+    void foldStereo (juce::dsp::AudioBlock<SampleType>& block);
+    
+    // Envelope modulation of the drive & threshold. The level is followed once per step of
+    // input samples, and the drive gain & threshold scale it sets are ramped linearly from
+    // one step to the next by the ramped kernels. Nothing runs while both depths are 0.
+    static constexpr int envelopeStep = 32;
+    static constexpr float envelopeSettledLevel = 1.0e-4f;
+    FoldDSP::EnvelopeFollower envelope;
+    bool modulating = false, envFromSidechain = false;
+    float envDriveDepthDb = 0.0f, envThresDepth = 0.0f;
+    float lastModDriveGain = 1.0f, lastModThresScale = 1.0f; // Where the last step ended
+    int firstSidechainChannel = 0, numSidechainChannels = 0;
+    
+    // Modulation over one step of the current segment, per sample at the fold rate
+    struct ModulationStep
+    {
+        float driveGain = 1.0f, driveRatio = 1.0f;
+        float thresScale = 1.0f, thresScaleDelta = 0.0f;
+    };
+    
+    std::vector<ModulationStep> modulationSteps;
+    int numModulationSteps = 0;
+    
+    void updateEnvelopeParameters();
+    template <typename SampleType>
+    void updateModulation (const juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples);
+    int getModulationStepLength() const noexcept { return envelopeStep * oversampler.getFactor(); }
+    void applyModulation (int offset, FoldDSP::FoldParams& current, FoldDSP::FoldRamp& ramp) const noexcept;
+    
+    // Output stages on the main bus at the host rate, after the oversampling. Each is skipped
+    // entirely while off, and switching one on starts it from silence. The limiter's
+    // lookahead is only part of the latency while it's on.
+    FoldDSP::DcBlocker dcBlocker;
+    FoldDSP::TruePeakLimiter limiter;
+    bool dcBlockEnabled = false, limiterEnabled = false;
+    
+    bool updateOutputStages();
+    
+    // Parameter changes at sample offsets inside the current block (CLAP only)
+    struct AutomationEvent
+    {
+        int sampleOffset;
+        juce::AudioProcessorParameter* parameter;
+        float normalisedValue;
+    };
+    
+    std::array<AutomationEvent, 512> automationEvents;
+    int numAutomationEvents = 0;
+    std::vector<std::pair<uint32_t, juce::AudioProcessorParameter*>> clapParameterIds;    // Sorted by ID
+    
+    // Latency in samples at the host rate. Changes made on the audio thread are reported to
+    // the host from the message thread, since that notifies its listeners under a lock
+    std::atomic<int> currentLatencySamples { 0 };
+    static constexpr int latencyPollHz = 10;
+    
+    // How long the output rings on after the input stops, for the enabled stages
+    std::atomic<double> tailSeconds { 0.0 };
+    
+    // Baked transfer function, rebuilt in the background when the settings change. The
+    // builder thread is only joined while LUT mode is on (see timerCallback)
+    FoldDSP::TransferLut lut;
+    bool lutEnabled = false;
+    
+    // Oversampling around the fold kernels
+    FoldDSP::Oversampler oversampler;
+    
+    // Silence bypass: once the input has been below the threshold for longer than the filter
+    // tails, the settled output of each channel is replayed instead of running the chain
+    static constexpr float silenceThreshold = 1.0e-6f; // -120 dB, at the output
+    static constexpr double silenceHoldSeconds = 0.1;
+    int silenceHoldSamples = 0;
+    int silentSamples = 0;
+    bool bypassed = false;
+    std::vector<double> settledOutput;
+    
+    // Scope feed, only written while an editor is showing it
+    Display::ScopeFifo scopeFifo;
     
-    punk_dsp::Wavefolder wf;
-    int wfType = 0; // Index for choosing wavefolder
+   #if WAVEFOLDER_PERF_METER
+    Perf::BlockTimer blockTimer;
+   #endif
     
     // =============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavefolderProcessor)
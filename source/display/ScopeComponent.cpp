@@ -0,0 +1,155 @@
+#include "ScopeComponent.h"
+#include "punk_dsp/punk_dsp.h"
+
+namespace Display
+{
+    namespace
+    {
+        // Vertical full scale of the display, a bit above 0 dBFS
+        constexpr float displayRange = 1.25f;
+    }
+
+    ScopeComponent::ScopeComponent (ScopeFifo& fifoToRead, const juce::AudioProcessor& processorToShow)
+        : fifo (fifoToRead), processor (processorToShow)
+    {
+        setOpaque (true);
+        startTimerHz (refreshRateHz);
+    }
+
+    ScopeComponent::~ScopeComponent()
+    {
+        stopTimer();
+        fifo.setActive (false);
+    }
+
+    //==============================================================================
+    void ScopeComponent::timerCallback()
+    {
+        // The audio thread only captures while someone is looking
+        const bool showing = isShowing();
+        fifo.setActive (showing);
+
+        if (! showing)
+            return;
+
+        int total = 0;
+
+        for (;;)
+        {
+            const int numRead = fifo.pop (popped.data(), (int) popped.size());
+
+            for (int i = 0; i < numRead; ++i)
+            {
+                history[(size_t) historyEnd] = popped[(size_t) i];
+                historyEnd = (historyEnd + 1) % historySize;
+            }
+
+            total += numRead;
+
+            if (numRead < (int) popped.size())
+                break;
+        }
+
+        if (total == 0)
+            return;
+
+        imageIsStale = true;
+        repaint();
+    }
+
+    void ScopeComponent::resized()
+    {
+        imageIsStale = true;
+    }
+
+    void ScopeComponent::paint (juce::Graphics& g)
+    {
+        if (imageIsStale)
+        {
+            renderImage();
+            imageIsStale = false;
+        }
+
+        if (image.isValid())
+            g.drawImage (image, getLocalBounds().toFloat());
+        else
+            g.fillAll (punk_dsp::UIConstants::background);
+    }
+
+    //==============================================================================
+    void ScopeComponent::renderImage()
+    {
+        const auto bounds = getLocalBounds();
+
+        if (bounds.isEmpty())
+            return;
+
+        // At the display's resolution, so the traces stay sharp on high DPI screens
+        const float scale = juce::Component::getApproximateScaleFactorForComponent (this);
+        const int width = juce::roundToInt ((float) bounds.getWidth() * scale);
+        const int height = juce::roundToInt ((float) bounds.getHeight() * scale);
+
+        if (! image.isValid() || image.getWidth() != width || image.getHeight() != height)
+            image = juce::Image (juce::Image::RGB, width, height, false);
+
+        juce::Graphics g (image);
+        g.addTransform (juce::AffineTransform::scale (scale));
+
+        const auto area = bounds.toFloat();
+        const float centreY = area.getCentreY();
+        const float unitHeight = area.getHeight() * 0.5f / displayRange;
+
+        g.fillAll (punk_dsp::UIConstants::background.brighter (0.1f));
+
+        // Zero and +/- full scale
+        g.setColour (juce::Colours::white.withAlpha (0.1f));
+        for (float level : { -1.0f, 0.0f, 1.0f })
+            g.drawHorizontalLine (juce::roundToInt (centreY - level * unitHeight), area.getX(), area.getRight());
+
+        const int window = juce::jlimit (16, historySize / 2, juce::roundToInt (windowSeconds * fifo.getPointRate()));
+        const int shift = juce::jlimit (0, historySize / 4, juce::roundToInt (processor.getLatencySamples() / (double) fifo.getDecimation()));
+
+        // Index 0 is the oldest point, historySize - 1 the newest
+        const auto at = [this] (int index) -> const ScopeFifo::Point& { return history[(size_t) ((historyEnd + index) % historySize)]; };
+
+        // Latest window whose output has arrived, moved back to a rising zero crossing of
+        // the input within one more window if there is one
+        const int newest = historySize - 1 - shift;
+        int start = newest - window;
+
+        for (int k = start; k > newest - 2 * window && k > 0; --k)
+        {
+            if (at (k - 1).input < 0.0f && at (k).input >= 0.0f)
+            {
+                start = k;
+                break;
+            }
+        }
+
+        juce::Path input, output;
+        const float xStep = area.getWidth() / (float) (window - 1);
+
+        for (int i = 0; i < window; ++i)
+        {
+            const float x = area.getX() + (float) i * xStep;
+            const float yIn = centreY - juce::jlimit (-displayRange, displayRange, at (start + i).input) * unitHeight;
+            const float yOut = centreY - juce::jlimit (-displayRange, displayRange, at (start + i + shift).output) * unitHeight;
+
+            if (i == 0)
+            {
+                input.startNewSubPath (x, yIn);
+                output.startNewSubPath (x, yOut);
+            }
+            else
+            {
+                input.lineTo (x, yIn);
+                output.lineTo (x, yOut);
+            }
+        }
+
+        g.setColour (juce::Colours::white.withAlpha (0.35f));
+        g.strokePath (input, juce::PathStrokeType (1.0f));
+        g.setColour (punk_dsp::UIConstants::highlight);
+        g.strokePath (output, juce::PathStrokeType (1.5f));
+    }
+}
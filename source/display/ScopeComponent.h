@@ -0,0 +1,50 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "ScopeFifo.h"
+
+namespace Display
+{
+    //==============================================================================
+    /** Oscilloscope of the input (dim) and folded output (bright) of the first channel,
+        triggered on rising zero crossings of the input so periodic signals stand still.
+        The output trace is shifted back by the plugin latency to line up with its input.
+
+        The FIFO is polled at a fixed rate, and only while the component is on screen.
+        The traces are rendered into an image the first time it's painted after new points
+        arrived or a resize, so opening the editor doesn't render anything up front and
+        paint() is a single blit whatever else triggered it.
+    */
+    class ScopeComponent : public juce::Component,
+                           private juce::Timer
+    {
+    public:
+        ScopeComponent (ScopeFifo& fifoToRead, const juce::AudioProcessor& processorToShow);
+        ~ScopeComponent() override;
+
+        void paint (juce::Graphics&) override;
+        void resized() override;
+
+        static constexpr int refreshRateHz = 30;
+        static constexpr double windowSeconds = 0.02;    // Width of the display
+
+    private:
+        void timerCallback() override;
+        void renderImage();
+
+        ScopeFifo& fifo;
+        const juce::AudioProcessor& processor;
+
+        // Most recent points, oldest overwritten first
+        static constexpr int historySize = 4096;
+        std::array<ScopeFifo::Point, (size_t) historySize> history;
+        int historyEnd = 0;
+        std::array<ScopeFifo::Point, 1024> popped;
+
+        juce::Image image;
+        bool imageIsStale = true;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScopeComponent)
+    };
+}
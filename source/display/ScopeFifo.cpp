@@ -0,0 +1,85 @@
+#include "ScopeFifo.h"
+
+namespace Display
+{
+    void ScopeFifo::prepare (double sampleRate, int maximumBlockSize)
+    {
+        decimation = juce::jmax (1, juce::roundToInt (sampleRate / targetPointRate));
+        pointRate.store (sampleRate / decimation, std::memory_order_relaxed);
+
+        pendingInput.assign ((size_t) (maximumBlockSize / decimation + 2), 0.0f);
+        phase = firstIndex = numPending = 0;
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    bool ScopeFifo::captureInput (const juce::AudioBuffer<SampleType>& buffer) noexcept
+    {
+        numPending = 0;
+
+        if (! active.load (std::memory_order_acquire) || buffer.getNumChannels() == 0 || pendingInput.empty())
+            return false;
+
+        const auto* data = buffer.getReadPointer (0);
+        const int numSamples = buffer.getNumSamples();
+        const int maxPending = (int) pendingInput.size();
+
+        firstIndex = phase;
+
+        for (int i = firstIndex; i < numSamples && numPending < maxPending; i += decimation)
+            pendingInput[(size_t) numPending++] = (float) data[i];
+
+        // Carry the decimation phase over to the next block. Blocks larger than prepared
+        // for just lose their last points.
+        const int next = firstIndex + numPending * decimation;
+        phase = next >= numSamples ? next - numSamples : 0;
+
+        return numPending > 0;
+    }
+
+    template <typename SampleType>
+    void ScopeFifo::pushOutput (const juce::AudioBuffer<SampleType>& buffer) noexcept
+    {
+        if (numPending == 0 || buffer.getNumChannels() == 0)
+            return;
+
+        const auto* data = buffer.getReadPointer (0);
+        const auto writer = fifo.write (numPending);
+        int n = 0;
+
+        writer.forEach ([&] (int index)
+        {
+            points[(size_t) index] = { pendingInput[(size_t) n], (float) data[firstIndex + n * decimation] };
+            ++n;
+        });
+
+        if (n < numPending)
+            numDropped.fetch_add (numPending - n, std::memory_order_relaxed);
+
+        numPending = 0;
+    }
+
+    void ScopeFifo::setActive (bool shouldBeActive)
+    {
+        // Never freed before the FIFO itself, the audio thread may still be writing to it
+        if (shouldBeActive && points.empty())
+            points.resize ((size_t) capacity);
+
+        active.store (shouldBeActive, std::memory_order_release);
+    }
+
+    int ScopeFifo::pop (Point* dest, int maxPoints) noexcept
+    {
+        const auto reader = fifo.read (juce::jmin (maxPoints, fifo.getNumReady()));
+        int numRead = 0;
+
+        reader.forEach ([&] (int index) { dest[numRead++] = points[(size_t) index]; });
+        return numRead;
+    }
+
+    //==============================================================================
+    template bool ScopeFifo::captureInput (const juce::AudioBuffer<float>&) noexcept;
+    template bool ScopeFifo::captureInput (const juce::AudioBuffer<double>&) noexcept;
+    template void ScopeFifo::pushOutput (const juce::AudioBuffer<float>&) noexcept;
+    template void ScopeFifo::pushOutput (const juce::AudioBuffer<double>&) noexcept;
+}
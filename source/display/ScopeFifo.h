@@ -0,0 +1,80 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+namespace Display
+{
+    //==============================================================================
+    /** Feeds the scope: decimated (input, output) pairs of the first channel, handed from
+        the audio thread to the editor through a wait-free single producer / single consumer
+        FIFO. The input is captured before the block is folded in place, the output after,
+        at the same sample positions.
+
+        Nothing is captured unless a reader has switched the FIFO on, so a closed editor
+        costs the audio thread one atomic load per block, and the point storage is only
+        allocated the first time a reader does: an instance whose editor is never opened
+        doesn't carry it. When the reader falls behind the newest points are dropped.
+        Points are picked, not filtered: the scope shows the samples themselves, not a
+        band-limited version.
+    */
+    class ScopeFifo
+    {
+    public:
+        struct Point
+        {
+            float input = 0.0f;
+            float output = 0.0f;
+        };
+
+        /** Roughly this many points per second are captured, whatever the sample rate. */
+        static constexpr double targetPointRate = 24000.0;
+
+        ScopeFifo() = default;
+
+        /** Not real-time safe: allocates the capture buffer for blocks up to maximumBlockSize. */
+        void prepare (double sampleRate, int maximumBlockSize);
+
+        //==============================================================================
+        /** Audio thread: keeps the decimated input of the block. Returns false, having done
+            nothing, when no reader is active. */
+        template <typename SampleType>
+        bool captureInput (const juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+        /** Audio thread: pairs the captured input with the processed block and pushes them. */
+        template <typename SampleType>
+        void pushOutput (const juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+        //==============================================================================
+        /** Reader thread: starts or stops the capture. Not real-time safe the first time it
+            starts, when the point storage is allocated. */
+        void setActive (bool shouldBeActive);
+
+        /** Reader thread: copies up to maxPoints pending points, oldest first, returns how many. */
+        int pop (Point* dest, int maxPoints) noexcept;
+
+        /** Points per second, for converting sample delays to points. */
+        double getPointRate() const noexcept { return pointRate.load (std::memory_order_relaxed); }
+        int getDecimation() const noexcept { return decimation; }
+
+        int getNumDropped() const noexcept { return numDropped.load (std::memory_order_relaxed); }
+
+    private:
+        static constexpr int capacity = 8192;
+
+        juce::AbstractFifo fifo { capacity };
+        std::vector<Point> points;  // Allocated before the first activation is published
+
+        // Audio thread only
+        std::vector<float> pendingInput;
+        int decimation = 1;
+        int phase = 0;          // Index of the first sample to capture in the next block
+        int firstIndex = 0;     // Index of the first sample captured in this block
+        int numPending = 0;
+
+        std::atomic<bool> active { false };
+        std::atomic<double> pointRate { targetPointRate };
+        std::atomic<int> numDropped { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScopeFifo)
+    };
+}
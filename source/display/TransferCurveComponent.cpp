@@ -0,0 +1,108 @@
+#include "TransferCurveComponent.h"
+#include "../dsp/FoldKernels.h"
+#include "punk_dsp/punk_dsp.h"
+
+namespace Display
+{
+    TransferCurveComponent::TransferCurveComponent (SettingsSource source)
+        : getSettings (std::move (source))
+    {
+        for (int i = 0; i < numPoints; ++i)
+            inputs[(size_t) i] = inputRange * (2.0f * (float) i / (float) (numPoints - 1) - 1.0f);
+
+        setOpaque (true);
+        startTimerHz (pollRateHz);
+    }
+
+    TransferCurveComponent::~TransferCurveComponent()
+    {
+        stopTimer();
+    }
+
+    //==============================================================================
+    void TransferCurveComponent::timerCallback()
+    {
+        if (! isShowing())
+            return;
+
+        const auto current = getSettings();
+
+        if (hasSettings && current == settings)
+            return;
+
+        settings = current;
+        hasSettings = true;
+
+        // Blend kernel with fixed weights: any type or morph position, through the full
+        // chain (bias, drive, mix, output gain) exactly as it is processed
+        outputs = inputs;
+        FoldDSP::Kernels::getActiveTable().getBlended<float> (false) (outputs.data(), numPoints, settings.params, {}, settings.shape);
+
+        imageIsStale = true;
+        repaint();
+    }
+
+    void TransferCurveComponent::resized()
+    {
+        imageIsStale = true;
+    }
+
+    void TransferCurveComponent::paint (juce::Graphics& g)
+    {
+        if (imageIsStale && hasSettings)
+        {
+            renderImage();
+            imageIsStale = false;
+        }
+
+        if (image.isValid())
+            g.drawImage (image, getLocalBounds().toFloat());
+        else
+            g.fillAll (punk_dsp::UIConstants::background);
+    }
+
+    //==============================================================================
+    void TransferCurveComponent::renderImage()
+    {
+        const auto bounds = getLocalBounds();
+
+        if (bounds.isEmpty() || ! hasSettings)
+            return;
+
+        const float scale = juce::Component::getApproximateScaleFactorForComponent (this);
+        const int width = juce::roundToInt ((float) bounds.getWidth() * scale);
+        const int height = juce::roundToInt ((float) bounds.getHeight() * scale);
+
+        if (! image.isValid() || image.getWidth() != width || image.getHeight() != height)
+            image = juce::Image (juce::Image::RGB, width, height, false);
+
+        juce::Graphics g (image);
+        g.addTransform (juce::AffineTransform::scale (scale));
+
+        const auto area = bounds.toFloat();
+        const auto toX = [&area] (float x) { return area.getCentreX() + x / inputRange * area.getWidth() * 0.5f; };
+        const auto toY = [&area] (float y) { return area.getCentreY() - juce::jlimit (-inputRange, inputRange, y) / inputRange * area.getHeight() * 0.5f; };
+
+        g.fillAll (punk_dsp::UIConstants::background.brighter (0.1f));
+
+        // Axes, the identity and the fold threshold
+        g.setColour (juce::Colours::white.withAlpha (0.1f));
+        g.drawHorizontalLine (juce::roundToInt (toY (0.0f)), area.getX(), area.getRight());
+        g.drawVerticalLine (juce::roundToInt (toX (0.0f)), area.getY(), area.getBottom());
+        g.drawLine (toX (-inputRange), toY (-inputRange), toX (inputRange), toY (inputRange));
+
+        g.setColour (juce::Colours::white.withAlpha (0.2f));
+        const float threshold = settings.params.threshold * settings.params.outGain;
+        for (float level : { -threshold, threshold })
+            g.drawHorizontalLine (juce::roundToInt (toY (level)), area.getX(), area.getRight());
+
+        juce::Path curve;
+        curve.startNewSubPath (toX (inputs[0]), toY (outputs[0]));
+
+        for (int i = 1; i < numPoints; ++i)
+            curve.lineTo (toX (inputs[(size_t) i]), toY (outputs[(size_t) i]));
+
+        g.setColour (punk_dsp::UIConstants::highlight);
+        g.strokePath (curve, juce::PathStrokeType (1.5f));
+    }
+}
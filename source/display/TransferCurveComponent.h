@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "../dsp/FoldFunctions.h"
+
+namespace Display
+{
+    //==============================================================================
+    /** Plot of the fold chain's transfer curve (output against input) for the current
+        settings, computed with the same kernels the audio thread runs.
+
+        The settings are polled at a low rate. The curve is only recomputed when they
+        change, and rendered into the cached image on the next paint after that or a
+        resize, so an editor left open costs a few comparisons per tick and opening one
+        renders nothing before it's on screen.
+    */
+    class TransferCurveComponent : public juce::Component,
+                                   private juce::Timer
+    {
+    public:
+        struct Settings
+        {
+            FoldDSP::FoldParams params;
+            FoldDSP::ShapeBlend shape;
+
+            bool operator== (const Settings& other) const noexcept
+            {
+                return params == other.params && shape.triangle == other.shape.triangle && shape.sine == other.shape.sine;
+            }
+
+            bool operator!= (const Settings& other) const noexcept { return ! (*this == other); }
+        };
+
+        /** Called on the message thread to read the current settings. */
+        using SettingsSource = std::function<Settings()>;
+
+        explicit TransferCurveComponent (SettingsSource source);
+        ~TransferCurveComponent() override;
+
+        void paint (juce::Graphics&) override;
+        void resized() override;
+
+        static constexpr int pollRateHz = 15;
+        static constexpr float inputRange = 1.5f;   // The curve spans +/- this input
+        static constexpr int numPoints = 256;
+
+    private:
+        void timerCallback() override;
+        void renderImage();
+
+        SettingsSource getSettings;
+        Settings settings;
+        bool hasSettings = false;
+
+        std::array<float, (size_t) numPoints> inputs, outputs;
+        juce::Image image;
+        bool imageIsStale = true;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransferCurveComponent)
+    };
+}
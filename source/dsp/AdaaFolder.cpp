@@ -0,0 +1,165 @@
+#include "AdaaFolder.h"
+
+namespace FoldDSP
+{
+    void AdaaFolder::prepare (int numChannels)
+    {
+        states.assign ((size_t) juce::jmax (1, numChannels), ChannelState {});
+    }
+
+    void AdaaFolder::reset()
+    {
+        for (auto& s : states)
+            s = ChannelState {};
+    }
+
+    template <typename SampleType>
+    void AdaaFolder::process (juce::dsp::AudioBlock<SampleType>& block, FoldType type, Order order, const FoldParams& params)
+    {
+        switch (type)
+        {
+            case FoldType::foldToRange:
+                processWithShape (block, Shape<FoldType::foldToRange> {}, order, params);
+                break;
+            case FoldType::sinFold:
+                processWithShape (block, Shape<FoldType::sinFold> {}, order, params);
+                break;
+            case FoldType::comboFold:
+                processWithShape (block, Shape<FoldType::comboFold> {}, order, params);
+                break;
+        }
+    }
+
+    template <typename SampleType>
+    void AdaaFolder::process (juce::dsp::AudioBlock<SampleType>& block, const ShapeBlend& blend, Order order, const FoldParams& params)
+    {
+        processWithShape (block, BlendedShape { blend.triangle, blend.sine }, order, params);
+    }
+
+    template <typename ShapeType, typename SampleType>
+    void AdaaFolder::processWithShape (juce::dsp::AudioBlock<SampleType>& block, const ShapeType& shape, Order order, const FoldParams& params)
+    {
+        const auto numChannels = juce::jmin ((int) block.getNumChannels(), (int) states.size());
+        const auto numSamples = (int) block.getNumSamples();
+        const double t = params.threshold;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& s = states[(size_t) ch];
+            auto* data = block.getChannelPointer ((size_t) ch);
+
+            if (! s.primed)
+            {
+                // Start from a steady state at the first input instead of from zero,
+                // otherwise the bias would produce a step on the very first sample
+                const double u0 = (double) params.drive * ((double) data[0] + params.biasPre) + params.biasPost;
+                s.u1 = s.u2 = u0;
+                s.dry1 = data[0];
+                s.d1 = shape.ad1 (u0, t);
+                s.primed = true;
+            }
+
+            // The cached antiderivatives depend on the shape and threshold, both of which
+            // may have changed since the last block, so refresh them from the stored inputs
+            if (order == Order::first)
+            {
+                s.ad1 = shape.ad1 (s.u1, t);
+                processFirstOrder (data, numSamples, s, shape, params);
+            }
+            else
+            {
+                s.ad1 = shape.ad2 (s.u1, t);
+                const double delta = s.u1 - s.u2;
+                s.d1 = std::abs (delta) > secondOrderTolerance * t ? (s.ad1 - shape.ad2 (s.u2, t)) / delta
+                                                                   : shape.ad1 (0.5 * (s.u1 + s.u2), t);
+                processSecondOrder (data, numSamples, s, shape, params);
+            }
+        }
+    }
+
+    template <typename ShapeType, typename SampleType>
+    void AdaaFolder::processFirstOrder (SampleType* data, int numSamples, ChannelState& s, const ShapeType& shape, const FoldParams& p) noexcept
+    {
+        const double t = p.threshold;
+        const double tol = firstOrderTolerance * t;
+        const double drive = p.drive, biasPre = p.biasPre, biasPost = p.biasPost;
+        const SampleType wetGain = (SampleType) p.outGain * (SampleType) p.mix;
+        const SampleType dryGain = (SampleType) p.outGain * (1 - (SampleType) p.mix);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const SampleType x = data[i];
+            const double u = drive * ((double) x + biasPre) + biasPost;
+            const double ad1 = shape.ad1 (u, t);
+            const double delta = u - s.u1;
+
+            const double wet = std::abs (delta) > tol ? (ad1 - s.ad1) / delta
+                                                      : shape.f (0.5 * (u + s.u1), t);
+
+            // Half-sample delayed dry to line up with the wet path
+            const SampleType dry = (SampleType) 0.5 * (x + (SampleType) s.dry1);
+
+            data[i] = wetGain * (SampleType) wet + dryGain * dry;
+
+            s.u1 = u;
+            s.ad1 = ad1;
+            s.dry1 = x;
+        }
+    }
+
+    template <typename ShapeType, typename SampleType>
+    void AdaaFolder::processSecondOrder (SampleType* data, int numSamples, ChannelState& s, const ShapeType& shape, const FoldParams& p) noexcept
+    {
+        const double t = p.threshold;
+        const double tol = secondOrderTolerance * t;
+        const double drive = p.drive, biasPre = p.biasPre, biasPost = p.biasPost;
+        const SampleType wetGain = (SampleType) p.outGain * (SampleType) p.mix;
+        const SampleType dryGain = (SampleType) p.outGain * (1 - (SampleType) p.mix);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const SampleType x = data[i];
+            const double u = drive * ((double) x + biasPre) + biasPost;
+            const double ad2 = shape.ad2 (u, t);
+
+            // First divided difference of F2 between u[n] and u[n-1]
+            const double delta1 = u - s.u1;
+            const double d1 = std::abs (delta1) > tol ? (ad2 - s.ad1) / delta1
+                                                      : shape.ad1 (0.5 * (u + s.u1), t);
+
+            double wet;
+            const double delta2 = u - s.u2;
+
+            if (std::abs (delta2) > tol)
+            {
+                wet = 2.0 * (d1 - s.d1) / delta2;
+            }
+            else
+            {
+                // u[n] ~ u[n-2]: expand around the midpoint of the outer samples instead
+                const double uBar = 0.5 * (u + s.u2);
+                const double delta = uBar - s.u1;
+
+                wet = std::abs (delta) > tol ? (2.0 / delta) * (shape.ad1 (uBar, t) + (s.ad1 - shape.ad2 (uBar, t)) / delta)
+                                             : shape.f (0.5 * (uBar + s.u1), t);
+            }
+
+            // One-sample delayed dry to line up with the wet path
+            const SampleType dry = (SampleType) s.dry1;
+
+            data[i] = wetGain * (SampleType) wet + dryGain * dry;
+
+            s.u2 = s.u1;
+            s.u1 = u;
+            s.ad1 = ad2;
+            s.d1 = d1;
+            s.dry1 = x;
+        }
+    }
+
+    //==============================================================================
+    template void AdaaFolder::process (juce::dsp::AudioBlock<float>&, FoldType, Order, const FoldParams&);
+    template void AdaaFolder::process (juce::dsp::AudioBlock<double>&, FoldType, Order, const FoldParams&);
+    template void AdaaFolder::process (juce::dsp::AudioBlock<float>&, const ShapeBlend&, Order, const FoldParams&);
+    template void AdaaFolder::process (juce::dsp::AudioBlock<double>&, const ShapeBlend&, Order, const FoldParams&);
+}
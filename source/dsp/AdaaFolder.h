@@ -0,0 +1,74 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "FoldFunctions.h"
+
+namespace FoldDSP
+{
+    //==============================================================================
+    /** Antiderivative anti-aliased (ADAA) versions of the three fold algorithms.
+
+        First order evaluates (F1(u[n]) - F1(u[n-1])) / (u[n] - u[n-1]), second order
+        uses the divided difference of F2 over three samples. When consecutive inputs get
+        too close the quotient is ill-conditioned, so both orders fall back to evaluating
+        the shape (or its first antiderivative) at the midpoint instead.
+
+        The wet path is delayed by half a sample (1st order) or one sample (2nd order),
+        the dry path is delayed by the same amount before mixing to avoid comb filtering.
+        The state is kept per channel between blocks, all of it allocated in prepare().
+    */
+    class AdaaFolder
+    {
+    public:
+        enum class Order
+        {
+            first = 1,
+            second = 2
+        };
+
+        AdaaFolder() = default;
+
+        void prepare (int numChannels);
+        void reset();
+
+        /** Defined for float and double, the state is double precision either way. */
+        template <typename SampleType>
+        void process (juce::dsp::AudioBlock<SampleType>& block, FoldType type, Order order, const FoldParams& params);
+
+        /** Same with a blend of the fold shapes, whose weights are held for the whole block
+            (the deltas are ignored): step them by calling this on short segments. */
+        template <typename SampleType>
+        void process (juce::dsp::AudioBlock<SampleType>& block, const ShapeBlend& blend, Order order, const FoldParams& params);
+
+        /** Group delay introduced by the given order, in samples at the processing rate. */
+        static double getDelayInSamples (Order order) noexcept { return order == Order::first ? 0.5 : 1.0; }
+
+    private:
+        struct ChannelState
+        {
+            double u1 = 0.0, u2 = 0.0;  // Previous shaper inputs
+            double ad1 = 0.0;           // F1 (u1) for 1st order, F2 (u1) for 2nd order
+            double d1 = 0.0;            // Previous 1st divided difference of F2 (2nd order only)
+            double dry1 = 0.0;          // Previous dry sample
+            bool primed = false;
+        };
+
+        // ShapeType is Shape<type> or BlendedShape
+        template <typename ShapeType, typename SampleType>
+        static void processFirstOrder (SampleType* data, int numSamples, ChannelState& s, const ShapeType& shape, const FoldParams& p) noexcept;
+
+        template <typename ShapeType, typename SampleType>
+        static void processSecondOrder (SampleType* data, int numSamples, ChannelState& s, const ShapeType& shape, const FoldParams& p) noexcept;
+
+        template <typename ShapeType, typename SampleType>
+        void processWithShape (juce::dsp::AudioBlock<SampleType>& block, const ShapeType& shape, Order order, const FoldParams& params);
+
+        std::vector<ChannelState> states;
+
+        // Tolerances on |u[n] - u[n-k]| relative to the threshold
+        static constexpr double firstOrderTolerance = 1.0e-5;
+        static constexpr double secondOrderTolerance = 1.0e-4;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AdaaFolder)
+    };
+}
@@ -0,0 +1,316 @@
+#include "BatchFolder.h"
+
+namespace FoldDSP
+{
+    template <typename SampleType>
+    void BatchFolder<SampleType>::prepare (int newNumStreams, double sampleRate, double rampSeconds)
+    {
+        jassert (newNumStreams > 0);
+
+        numStreams = juce::jmax (1, newNumStreams);
+        frameStride = (numStreams + streamAlignment - 1) / streamAlignment * streamAlignment;
+        vectorWidth = kernels.getWidth<SampleType>();
+        setRampTime (sampleRate, rampSeconds);
+        numRamping = 0;
+
+        const auto defaults = toFields (FoldParams {});
+
+        for (int f = 0; f < numFields; ++f)
+        {
+            current[(size_t) f].assign ((size_t) frameStride, defaults[(size_t) f]);
+            target[(size_t) f].assign ((size_t) frameStride, defaults[(size_t) f]);
+            steps[(size_t) f].assign ((size_t) frameStride, getIdentityStep (f));
+        }
+
+        triangleWeight.assign ((size_t) frameStride, (SampleType) 1);
+        sineWeight.assign ((size_t) frameStride, (SampleType) 0);
+        remaining.assign ((size_t) frameStride, 0);
+        types.assign ((size_t) frameStride, FoldType::foldToRange);
+
+        vectorTypes.assign ((size_t) (frameStride / vectorWidth), (int) FoldType::foldToRange);
+        vectorRamping.assign ((size_t) (frameStride / vectorWidth), 0);
+
+        streamParams = { current[drive].data(), current[outGain].data(), current[biasPre].data(), current[biasPost].data(),
+                         current[threshold].data(), current[mix].data(), triangleWeight.data(), sineWeight.data() };
+        streamSteps = { steps[drive].data(), steps[outGain].data(), steps[biasPre].data(),
+                        steps[biasPost].data(), steps[threshold].data(), steps[mix].data() };
+
+        setNumActiveStreams (numStreams);
+    }
+
+    template <typename SampleType>
+    void BatchFolder<SampleType>::setNumActiveStreams (int numActive) noexcept
+    {
+        numActiveStreams = juce::jlimit (0, numStreams, numActive);
+        numActiveVectors = (numActiveStreams + vectorWidth - 1) / vectorWidth;
+    }
+
+    template <typename SampleType>
+    void BatchFolder<SampleType>::setRampTime (double sampleRate, double rampSeconds) noexcept
+    {
+        rampLength = juce::jmax (1, juce::roundToInt (sampleRate * rampSeconds));
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    void BatchFolder<SampleType>::setType (int stream, FoldType type) noexcept
+    {
+        const auto s = (size_t) stream;
+        const SampleType weight = type == FoldType::foldToRange ? (SampleType) 1
+                                : type == FoldType::sinFold     ? (SampleType) 0
+                                                                : (SampleType) 0.5;
+        types[s] = type;
+        triangleWeight[s] = weight;
+        sineWeight[s] = 1 - weight;
+
+        updateVectorType (stream / vectorWidth);
+    }
+
+    template <typename SampleType>
+    void BatchFolder<SampleType>::setParameters (int stream, const FoldParams& params) noexcept
+    {
+        const auto s = (size_t) stream;
+        const auto values = toFields (params);
+        bool changed = false;
+
+        for (int f = 0; f < numFields; ++f)
+            changed = changed || values[(size_t) f] != target[(size_t) f][s];
+
+        if (! changed)
+            return;
+
+        for (int f = 0; f < numFields; ++f)
+        {
+            const auto value = values[(size_t) f];
+            const auto from = current[(size_t) f][s];
+
+            target[(size_t) f][s] = value;
+
+            if (value == from)
+                steps[(size_t) f][s] = getIdentityStep (f);
+            else if (isMultiplicative (f))
+                steps[(size_t) f][s] = std::pow (value / from, (SampleType) 1 / (SampleType) rampLength);
+            else
+                steps[(size_t) f][s] = (value - from) / (SampleType) rampLength;
+        }
+
+        if (remaining[s] == 0)
+        {
+            ++numRamping;
+            ++vectorRamping[(size_t) (stream / vectorWidth)];
+        }
+
+        remaining[s] = rampLength;
+    }
+
+    template <typename SampleType>
+    void BatchFolder<SampleType>::resetParameters (int stream, const FoldParams& params) noexcept
+    {
+        const auto s = (size_t) stream;
+        const auto values = toFields (params);
+
+        for (int f = 0; f < numFields; ++f)
+            current[(size_t) f][s] = target[(size_t) f][s] = values[(size_t) f];
+
+        if (remaining[s] > 0)
+            finishRamp (stream);
+    }
+
+    template <typename SampleType>
+    FoldParams BatchFolder<SampleType>::getParameters (int stream) const noexcept
+    {
+        const auto s = (size_t) stream;
+
+        FoldParams p;
+        p.drive = (float) target[drive][s];
+        p.outGain = (float) target[outGain][s];
+        p.biasPre = (float) target[biasPre][s];
+        p.biasPost = (float) target[biasPost][s];
+        p.threshold = (float) target[threshold][s];
+        p.mix = (float) target[mix][s];
+        return p;
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    void BatchFolder<SampleType>::process (SampleType* const* streams, int numSamples) noexcept
+    {
+        for (int stream = 0; stream < numActiveStreams; ++stream)
+        {
+            auto* data = streams[stream];
+            const auto type = types[(size_t) stream];
+            int done = 0;
+
+            if (remaining[(size_t) stream] > 0)
+            {
+                done = juce::jmin (remaining[(size_t) stream], numSamples);
+                kernels.getRamped<SampleType> (type) (data, done, getCurrent (stream), getRamp (stream));
+                advance (stream, done);
+            }
+
+            if (done < numSamples)
+            {
+                const auto params = getCurrent (stream);
+                kernels.select<SampleType> (type, params) (data + done, numSamples - done, params);
+            }
+        }
+
+        for (int stream = numActiveStreams; stream < numStreams; ++stream)
+            if (remaining[(size_t) stream] > 0)
+                finishRamp (stream);
+    }
+
+    template <typename SampleType>
+    void BatchFolder<SampleType>::processInterleaved (SampleType* frames, int numFrames) noexcept
+    {
+        for (int start = 0; start < numFrames;)
+        {
+            const int length = getSegmentLength (juce::jmin (framesPerTile, numFrames - start));
+            auto* segment = frames + (size_t) start * (size_t) frameStride;
+
+            for (int v = 0; v < numActiveVectors; ++v)
+            {
+                const int type = vectorTypes[(size_t) v];
+
+                if (vectorRamping[(size_t) v] > 0)
+                    kernels.getRampedStreams<SampleType> (type) (segment, length, frameStride, v * vectorWidth, streamParams, streamSteps);
+                else
+                    kernels.getStreams<SampleType> (type) (segment, length, frameStride, v * vectorWidth, streamParams);
+            }
+
+            // The ramped kernels have advanced the current settings already, the segment
+            // ends where the first ramp does so no stream overshoots its target
+            if (numRamping > 0)
+            {
+                for (int stream = 0; stream < numStreams; ++stream)
+                {
+                    auto& left = remaining[(size_t) stream];
+
+                    if (left > 0 && (left -= length) == 0)
+                        finishRamp (stream);
+                }
+            }
+
+            start += length;
+        }
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    std::array<SampleType, BatchFolder<SampleType>::numFields> BatchFolder<SampleType>::toFields (const FoldParams& p) noexcept
+    {
+        return { (SampleType) p.drive, (SampleType) p.outGain, (SampleType) p.biasPre,
+                 (SampleType) p.biasPost, (SampleType) p.threshold, (SampleType) p.mix };
+    }
+
+    template <typename SampleType>
+    FoldParams BatchFolder<SampleType>::getCurrent (int stream) const noexcept
+    {
+        const auto s = (size_t) stream;
+
+        FoldParams p;
+        p.drive = (float) current[drive][s];
+        p.outGain = (float) current[outGain][s];
+        p.biasPre = (float) current[biasPre][s];
+        p.biasPost = (float) current[biasPost][s];
+        p.threshold = (float) current[threshold][s];
+        p.mix = (float) current[mix][s];
+        return p;
+    }
+
+    template <typename SampleType>
+    FoldRamp BatchFolder<SampleType>::getRamp (int stream) const noexcept
+    {
+        const auto s = (size_t) stream;
+
+        FoldRamp r;
+        r.driveRatio = (float) steps[drive][s];
+        r.outGainRatio = (float) steps[outGain][s];
+        r.biasPreDelta = (float) steps[biasPre][s];
+        r.biasPostDelta = (float) steps[biasPost][s];
+        r.thresholdDelta = (float) steps[threshold][s];
+        r.mixDelta = (float) steps[mix][s];
+        return r;
+    }
+
+    template <typename SampleType>
+    void BatchFolder<SampleType>::advance (int stream, int numSamples) noexcept
+    {
+        const auto s = (size_t) stream;
+
+        if (numSamples >= remaining[s])
+        {
+            finishRamp (stream);
+            return;
+        }
+
+        remaining[s] -= numSamples;
+
+        // Settings that aren't moving skip the pow(), which dominates small blocks otherwise
+        for (int f = 0; f < numFields; ++f)
+        {
+            auto& value = current[(size_t) f][s];
+            const auto step = steps[(size_t) f][s];
+
+            if (step == getIdentityStep (f))
+                continue;
+
+            value = isMultiplicative (f) ? value * std::pow (step, (SampleType) numSamples) : value + step * (SampleType) numSamples;
+        }
+    }
+
+    template <typename SampleType>
+    void BatchFolder<SampleType>::finishRamp (int stream) noexcept
+    {
+        const auto s = (size_t) stream;
+
+        for (int f = 0; f < numFields; ++f)
+        {
+            current[(size_t) f][s] = target[(size_t) f][s];
+            steps[(size_t) f][s] = getIdentityStep (f);
+        }
+
+        remaining[s] = 0;
+        --numRamping;
+        --vectorRamping[(size_t) (stream / vectorWidth)];
+    }
+
+    template <typename SampleType>
+    void BatchFolder<SampleType>::updateVectorType (int vector) noexcept
+    {
+        // Padding streams take whatever kernel their vector runs, their output isn't used
+        const int first = vector * vectorWidth;
+        const int end = juce::jmin (numStreams, first + vectorWidth);
+        int type = (int) types[(size_t) first];
+
+        for (int s = first + 1; s < end; ++s)
+        {
+            if ((int) types[(size_t) s] != type)
+            {
+                type = Kernels::mixedFoldTypes;
+                break;
+            }
+        }
+
+        vectorTypes[(size_t) vector] = type;
+    }
+
+    template <typename SampleType>
+    int BatchFolder<SampleType>::getSegmentLength (int maxLength) const noexcept
+    {
+        if (numRamping == 0)
+            return maxLength;
+
+        int length = maxLength;
+
+        for (int s = 0; s < numStreams; ++s)
+            if (remaining[(size_t) s] > 0)
+                length = juce::jmin (length, remaining[(size_t) s]);
+
+        return length;
+    }
+
+    //==============================================================================
+    template class BatchFolder<float>;
+    template class BatchFolder<double>;
+}
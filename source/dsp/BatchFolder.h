@@ -0,0 +1,129 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "FoldKernels.h"
+
+namespace FoldDSP
+{
+    //==============================================================================
+    /** Folds many independent streams (voices, stems, render jobs...) in one call.
+
+        Every stream has its own fold type and FoldParams, smoothed per sample the same way
+        FoldParamSmoother does it. All of it is kept in structure-of-arrays layout, one array
+        per setting indexed by stream, so updating a stream is a few stores and nothing is
+        allocated after prepare(). Two buffer layouts are accepted:
+
+        - process(): one buffer per stream. Each stream runs the kernels vectorised along
+          time, which is the fastest way to fold streams that live in separate buffers.
+        - processInterleaved(): frame after frame, getFrameStride() samples per frame, one
+          per stream. The vectors then run across streams, each lane with its own settings
+          loaded straight from the arrays, so a block costs the same per stream whatever
+          its length, with no per-stream call or setup at all.
+
+        Only the memoryless chain is covered: no ADAA or oversampling, which need filter
+        state per stream. Gains (drive, outGain) must stay above zero, since they are
+        smoothed multiplicatively. Not thread safe: set parameters and process from the
+        same thread.
+
+        Defined for float and double.
+    */
+    template <typename SampleType>
+    class BatchFolder
+    {
+    public:
+        /** Frames of processInterleaved() are padded to a multiple of this many streams,
+            the widest vector of any instruction set. */
+        static constexpr int streamAlignment = 16;
+
+        explicit BatchFolder (const Kernels::KernelTable& kernelTable = Kernels::getActiveTable()) : kernels (kernelTable) {}
+
+        /** Allocates numStreams streams, all FoldToRange with the default FoldParams. */
+        void prepare (int numStreams, double sampleRate, double rampSeconds = 0.02);
+
+        int getNumStreams() const noexcept { return numStreams; }
+
+        /** Only the first numActive streams are folded from now on, the others are skipped
+            (in processInterleaved(), whole vectors past the last active stream are). Lets a
+            caller keep streams allocated and only pay for those in use. Skipped streams jump
+            to their targets when their ramps end. */
+        void setNumActiveStreams (int numActive) noexcept;
+
+        /** Changes the ramp time of the ramps started from now on, without allocating. */
+        void setRampTime (double sampleRate, double rampSeconds) noexcept;
+
+        /** Samples per frame in processInterleaved(): the number of streams rounded up to
+            streamAlignment. The padding samples are processed too, with the default settings. */
+        int getFrameStride() const noexcept { return frameStride; }
+
+        void setType (int stream, FoldType type) noexcept;
+        FoldType getType (int stream) const noexcept { return types[(size_t) stream]; }
+
+        /** Ramps the stream towards new settings over the ramp time. */
+        void setParameters (int stream, const FoldParams& params) noexcept;
+
+        /** Jumps straight to new settings, e.g. when a stream starts a new voice. */
+        void resetParameters (int stream, const FoldParams& params) noexcept;
+
+        /** Target settings of the stream. */
+        FoldParams getParameters (int stream) const noexcept;
+
+        bool isSmoothing() const noexcept { return numRamping > 0; }
+
+        /** Folds numSamples samples of every stream, streams[s] being the buffer of stream s. */
+        void process (SampleType* const* streams, int numSamples) noexcept;
+
+        /** Folds numFrames frames of getFrameStride() samples: the sample of stream s in
+            frame i is frames[i * getFrameStride() + s]. */
+        void processInterleaved (SampleType* frames, int numFrames) noexcept;
+
+    private:
+        // Settings in the order of FoldParams. Gains ramp multiplicatively, the rest linearly.
+        enum Field
+        {
+            drive = 0,
+            outGain,
+            biasPre,
+            biasPost,
+            threshold,
+            mix,
+            numFields
+        };
+
+        static bool isMultiplicative (int field) noexcept { return field == drive || field == outGain; }
+        static SampleType getIdentityStep (int field) noexcept { return isMultiplicative (field) ? (SampleType) 1 : (SampleType) 0; }
+        static std::array<SampleType, numFields> toFields (const FoldParams& params) noexcept;
+
+        FoldParams getCurrent (int stream) const noexcept;
+        FoldRamp getRamp (int stream) const noexcept;
+
+        void advance (int stream, int numSamples) noexcept;
+        void finishRamp (int stream) noexcept;
+        void updateVectorType (int vector) noexcept;
+        int getSegmentLength (int maxLength) const noexcept;
+
+        const Kernels::KernelTable& kernels;
+        int numStreams = 0, frameStride = 0, vectorWidth = 1;
+        int numActiveStreams = 0, numActiveVectors = 0;
+        int rampLength = 1, numRamping = 0;
+
+        // One value per stream (and per padding stream) in each array
+        std::array<std::vector<SampleType>, numFields> current, target, steps;
+        std::vector<SampleType> triangleWeight, sineWeight;
+        std::vector<int> remaining;     // Samples left in the stream's ramp, 0 when static
+        std::vector<FoldType> types;
+
+        // One value per vector of streams, for processInterleaved()
+        std::vector<int> vectorTypes;   // Fold type index shared by its streams, or mixedFoldTypes
+        std::vector<int> vectorRamping; // How many of its streams are ramping
+
+        // Pointers into the arrays above, as passed to the stream kernels
+        Kernels::StreamParams<SampleType> streamParams {};
+        Kernels::StreamSteps<SampleType> streamSteps {};
+
+        // Frames per pass of one vector of streams, so the cache lines a pass shares with
+        // the next vector are still in L1 when it gets to them
+        static constexpr int framesPerTile = 64;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchFolder)
+    };
+}
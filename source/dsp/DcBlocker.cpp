@@ -0,0 +1,93 @@
+#include "DcBlocker.h"
+
+namespace FoldDSP
+{
+    void DcBlocker::prepare (int numChannels, double newSampleRate, double cutoffHz)
+    {
+        sampleRate = newSampleRate;
+        cutoff = cutoffHz;
+
+        const double pole = std::exp (-juce::MathConstants<double>::twoPi * cutoff / sampleRate);
+
+        for (int row = 0; row < laneCount; ++row)
+        {
+            powers[(size_t) row] = std::pow (pole, row + 1);
+
+            for (int column = 0; column < laneCount; ++column)
+                impulse[(size_t) column][(size_t) row] = row >= column ? std::pow (pole, row - column) : 0.0;
+        }
+
+        lastInput.assign ((size_t) juce::jmax (1, numChannels), 0.0);
+        lastOutput.assign (lastInput.size(), 0.0);
+    }
+
+    void DcBlocker::reset() noexcept
+    {
+        std::fill (lastInput.begin(), lastInput.end(), 0.0);
+        std::fill (lastOutput.begin(), lastOutput.end(), 0.0);
+    }
+
+    double DcBlocker::getSettleSeconds() const noexcept
+    {
+        // R^n = 10^-6 with R = e^(-2 pi fc / fs)
+        return std::log (1.0e6) / (juce::MathConstants<double>::twoPi * cutoff);
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    void DcBlocker::process (juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const int numChannels = juce::jmin ((int) block.getNumChannels(), (int) lastInput.size());
+        const auto numSamples = (int) block.getNumSamples();
+        const double pole = powers[0];
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data = block.getChannelPointer ((size_t) ch);
+            double x1 = lastInput[(size_t) ch], y1 = lastOutput[(size_t) ch];
+            int i = 0;
+
+            for (; i + laneCount <= numSamples; i += laneCount)
+            {
+                std::array<double, laneCount> x, d, y;
+
+                for (int k = 0; k < laneCount; ++k)
+                    x[(size_t) k] = (double) data[i + k];
+
+                d[0] = x[0] - x1;
+
+                for (int k = 1; k < laneCount; ++k)
+                    d[(size_t) k] = x[(size_t) k] - x[(size_t) k - 1];
+
+                // Previous output carried in, then each difference's decaying response
+                for (int row = 0; row < laneCount; ++row)
+                    y[(size_t) row] = powers[(size_t) row] * y1;
+
+                for (int column = 0; column < laneCount; ++column)
+                    for (int row = 0; row < laneCount; ++row)
+                        y[(size_t) row] += impulse[(size_t) column][(size_t) row] * d[(size_t) column];
+
+                for (int k = 0; k < laneCount; ++k)
+                    data[i + k] = (SampleType) y[(size_t) k];
+
+                x1 = x[laneCount - 1];
+                y1 = y[laneCount - 1];
+            }
+
+            for (; i < numSamples; ++i)
+            {
+                const auto x = (double) data[i];
+                y1 = x - x1 + pole * y1;
+                x1 = x;
+                data[i] = (SampleType) y1;
+            }
+
+            lastInput[(size_t) ch] = x1;
+            lastOutput[(size_t) ch] = y1;
+        }
+    }
+
+    //==============================================================================
+    template void DcBlocker::process (juce::dsp::AudioBlock<float>&) noexcept;
+    template void DcBlocker::process (juce::dsp::AudioBlock<double>&) noexcept;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+namespace FoldDSP
+{
+    //==============================================================================
+    /** One-pole DC blocker, y[n] = x[n] - x[n-1] + R y[n-1], on every channel.
+
+        The recursion is run four samples at a time: the four outputs are a lower triangular
+        matrix of powers of R times the four input differences, plus powers of R times the
+        previous output. Those lanes don't depend on each other, so the compiler turns each
+        step into a few vector multiply-adds, and only one serial dependency is left per four
+        samples instead of one per sample.
+
+        The state of every channel is allocated in prepare(), in double whatever the host's
+        precision, so the pole stays where it belongs with a float signal.
+    */
+    class DcBlocker
+    {
+    public:
+        static constexpr double defaultCutoff = 5.0;    // Hz
+
+        DcBlocker() = default;
+
+        void prepare (int numChannels, double sampleRate, double cutoffHz = defaultCutoff);
+        void reset() noexcept;
+
+        /** Time for a step at the input to decay by 120 dB at the output, e.g. the DC left
+            when the signal stops. */
+        double getSettleSeconds() const noexcept;
+
+        template <typename SampleType>
+        void process (juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    private:
+        static constexpr int laneCount = 4;
+
+        double sampleRate = 44100.0, cutoff = defaultCutoff;
+        std::array<double, laneCount> powers {};                                // R^1 .. R^4
+        std::array<std::array<double, laneCount>, laneCount> impulse {};        // [column][row], R^(row - column) or 0
+        std::vector<double> lastInput, lastOutput;                              // Per channel
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DcBlocker)
+    };
+}
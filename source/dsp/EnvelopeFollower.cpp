@@ -0,0 +1,96 @@
+#include "EnvelopeFollower.h"
+
+namespace FoldDSP
+{
+    void EnvelopeFollower::prepare (double newSampleRate, int stepSamples)
+    {
+        sampleRate = newSampleRate;
+        step = juce::jmax (1, stepSamples);
+
+        // Recompute the coefficients for the new rate on the next setTimes()
+        attack = release = -1.0f;
+        reset();
+    }
+
+    void EnvelopeFollower::setMode (Mode newMode) noexcept
+    {
+        if (newMode == mode)
+            return;
+
+        // The level is kept in a different domain by each mode
+        level = newMode == Mode::rms ? level * level : std::sqrt (level);
+        mode = newMode;
+    }
+
+    void EnvelopeFollower::setTimes (float attackMs, float releaseMs) noexcept
+    {
+        if (attackMs != attack)
+        {
+            attack = attackMs;
+            attackCoeff = getCoefficient (attackMs);
+        }
+
+        if (releaseMs != release)
+        {
+            release = releaseMs;
+            releaseCoeff = getCoefficient (releaseMs);
+        }
+    }
+
+    float EnvelopeFollower::getCoefficient (float timeMs) const noexcept
+    {
+        // One pole reaching 1 - 1/e of the way after timeMs, applied once per step
+        const double steps = juce::jmax (1.0e-3, (double) timeMs * 0.001 * sampleRate / step);
+        return (float) std::exp (-1.0 / steps);
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    float EnvelopeFollower::process (const SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+    {
+        if (numSamples <= 0 || numChannels <= 0)
+            return getLevel();
+
+        float detected = 0.0f;
+
+        if (mode == Mode::peak)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const auto* data = channels[ch] + startSample;
+                SampleType peak = 0;
+
+                for (int i = 0; i < numSamples; ++i)
+                    peak = juce::jmax (peak, std::abs (data[i]));
+
+                detected = juce::jmax (detected, (float) peak);
+            }
+        }
+        else
+        {
+            SampleType sum = 0;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const auto* data = channels[ch] + startSample;
+
+                for (int i = 0; i < numSamples; ++i)
+                    sum += data[i] * data[i];
+            }
+
+            detected = (float) (sum / (SampleType) (numSamples * numChannels));
+        }
+
+        auto coeff = detected > level ? attackCoeff : releaseCoeff;
+
+        if (numSamples != step)
+            coeff = std::pow (coeff, (float) numSamples / (float) step);
+
+        level = detected + coeff * (level - detected);
+        return getLevel();
+    }
+
+    //==============================================================================
+    template float EnvelopeFollower::process (const float* const*, int, int, int) noexcept;
+    template float EnvelopeFollower::process (const double* const*, int, int, int) noexcept;
+}
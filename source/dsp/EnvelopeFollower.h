@@ -0,0 +1,51 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace FoldDSP
+{
+    //==============================================================================
+    /** Peak or RMS envelope of a multichannel signal, updated once per control step.
+
+        Each call to process() detects one step of samples, the loudest channel's peak or
+        the power averaged over every channel, and moves the level towards it with the
+        attack or release time. Nothing runs per sample except the detection itself, which
+        the compiler vectorises.
+    */
+    class EnvelopeFollower
+    {
+    public:
+        enum class Mode
+        {
+            peak = 0,
+            rms
+        };
+
+        EnvelopeFollower() = default;
+
+        /** stepSamples is the usual number of samples per process() call. */
+        void prepare (double sampleRate, int stepSamples);
+        void reset() noexcept { level = 0.0f; }
+
+        void setMode (Mode newMode) noexcept;
+        void setTimes (float attackMs, float releaseMs) noexcept;
+
+        /** Detects numSamples samples from startSample of each channel as one step and
+            returns the new level, as an amplitude. A step shorter than the prepared one
+            moves the level proportionally less. */
+        template <typename SampleType>
+        float process (const SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+
+        float getLevel() const noexcept { return mode == Mode::rms ? std::sqrt (level) : level; }
+
+    private:
+        float getCoefficient (float timeMs) const noexcept;
+
+        Mode mode = Mode::peak;
+        double sampleRate = 44100.0;
+        int step = 32;
+        float attack = -1.0f, release = -1.0f;          // Times the coefficients are for
+        float attackCoeff = 0.0f, releaseCoeff = 0.0f;  // Per step of `step` samples
+        float level = 0.0f;                             // Amplitude (peak) or power (RMS)
+    };
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cmath>
+
+namespace FoldDSP
+{
+    enum class FoldType
+    {
+        foldToRange = 0,
+        sinFold,
+        comboFold
+    };
+
+    //==============================================================================
+    /** Linear-domain settings shared by every fold kernel.
+
+        The chain is  u = drive * (x + biasPre) + biasPost,  wet = fold (u),
+        y = outGain * (mix * wet + (1 - mix) * x).
+    */
+    struct FoldParams
+    {
+        float drive = 1.0f;
+        float outGain = 1.0f;
+        float biasPre = 0.0f;
+        float biasPost = 0.0f;
+        float threshold = 0.7f;
+        float mix = 1.0f;
+
+        bool operator== (const FoldParams&) const = default;
+    };
+
+    /** Per-sample increments of a FoldParams ramp, used while parameters are smoothed.
+        Gains ramp multiplicatively, everything else linearly. */
+    struct FoldRamp
+    {
+        float driveRatio = 1.0f;
+        float outGainRatio = 1.0f;
+        float biasPreDelta = 0.0f;
+        float biasPostDelta = 0.0f;
+        float thresholdDelta = 0.0f;
+        float mixDelta = 0.0f;
+    };
+
+    /** A fold shape in between the three types, as a weighted sum of the triangle and sine
+        folds: (1, 0) is FoldToRange, (0, 1) SinFold and (1/2, 1/2) ComboFold. Used to morph
+        between adjacent types and to crossfade from one type to another, the weights then
+        moving by the per-sample deltas. */
+    struct ShapeBlend
+    {
+        float triangle = 1.0f;
+        float sine = 0.0f;
+        float triangleDelta = 0.0f;
+        float sineDelta = 0.0f;
+
+        /** The weights numSamples samples further along. */
+        ShapeBlend advanced (int numSamples) const noexcept
+        {
+            return { triangle + triangleDelta * (float) numSamples, sine + sineDelta * (float) numSamples, triangleDelta, sineDelta };
+        }
+    };
+
+    /** Weights of one of the three types. */
+    inline ShapeBlend getShapeBlend (FoldType type) noexcept
+    {
+        switch (type)
+        {
+            case FoldType::sinFold:   return { 0.0f, 1.0f };
+            case FoldType::comboFold: return { 0.5f, 0.5f };
+            default:                  return { 1.0f, 0.0f };
+        }
+    }
+
+    /** Weights of a morph position in [0, 2]: FoldToRange -> SinFold -> ComboFold, linear
+        between adjacent types, so only the triangle and sine folds are ever evaluated. */
+    inline ShapeBlend getMorphBlend (float position) noexcept
+    {
+        if (position <= 1.0f)
+            return { 1.0f - position, position };
+
+        const float towardsCombo = position - 1.0f;
+        return { 0.5f * towardsCombo, 1.0f - 0.5f * towardsCombo };
+    }
+
+    //==============================================================================
+    /** Memoryless fold shapes and their first/second antiderivatives.
+
+        The shapes are punk_dsp::Wavefolder's FoldToRange, SinFold and ComboFold, which
+        WavefolderTests checks them against. All three fold with a period of 4 * t and peak
+        at +/- t, but their slope through the origin differs: 1 for FoldToRange, pi / 2 for
+        SinFold and (1 + pi / 2) / 2 for ComboFold, which is also the steepest each gets.
+
+        The antiderivatives are integrated from those shapes in closed form, anchored at
+        F(0) = 0, and are what the ADAA kernels use. The tests check AD1' = f against the
+        library and AD2' = AD1.
+    */
+    namespace Shapes
+    {
+        constexpr double pi = 3.14159265358979323846;
+
+        /** Steepest slope of any of the shapes or their blends, SinFold's at its zero crossings. */
+        constexpr double maxSlope = pi / 2.0;
+
+        //==============================================================================
+        // Triangle fold: reflects u back into [-t, t]
+        inline double triangleWrap (double u, double t) noexcept
+        {
+            // Position inside the period, shifted so v = 0 sits on the falling edge
+            const double period = 4.0 * t;
+            double m = std::fmod (u + t, period);
+            if (m < 0.0)
+                m += period;
+
+            return m - 2.0 * t; // v in [-2t, 2t)
+        }
+
+        inline double foldToRange (double u, double t) noexcept
+        {
+            return t - std::abs (triangleWrap (u, t));
+        }
+
+        inline double foldToRangeAD1 (double u, double t) noexcept
+        {
+            // f is t + v on the rising edge (v < 0) and t - v on the falling one, so the
+            // integral from u = 0 (v = -t) is a parabola on each edge. It is periodic since
+            // f has a zero mean, and bounded in [0, t^2]
+            const double v = triangleWrap (u, t);
+
+            if (v < 0.0)
+                return 0.5 * (v + t) * (v + t);
+
+            return t * t - 0.5 * (v - t) * (v - t);
+        }
+
+        inline double foldToRangeAD2 (double u, double t) noexcept
+        {
+            // AD1 has a mean of t^2 / 2, the rest of the integral is periodic
+            const double m = triangleWrap (u, t) + 2.0 * t;
+            const double t3 = t * t * t;
+
+            double h;
+            if (m <= 2.0 * t)
+                h = (m - t) * (m - t) * (m - t) / 6.0 + t3 / 6.0 - 0.5 * t * t * m;
+            else
+                h = -(m - 3.0 * t) * (m - 3.0 * t) * (m - 3.0 * t) / 6.0 + 0.5 * t * t * m - 11.0 * t3 / 6.0;
+
+            return 0.5 * t * t * u + h + t3 / 3.0;
+        }
+
+        //==============================================================================
+        // Sine fold: smooth version of the triangle fold with the same period
+        inline double sinFold (double u, double t) noexcept
+        {
+            const double w = pi / (2.0 * t);
+            return t * std::sin (w * u);
+        }
+
+        // Integrals from 0 of t * sin (w * u): t * (1 - cos (w * u)) / w, then t * (u - sin (w * u) / w) / w
+        inline double sinFoldAD1 (double u, double t) noexcept
+        {
+            const double w = pi / (2.0 * t);
+            return t * (1.0 - std::cos (w * u)) / w;
+        }
+
+        inline double sinFoldAD2 (double u, double t) noexcept
+        {
+            const double w = pi / (2.0 * t);
+            return t * (u - std::sin (w * u) / w) / w;
+        }
+
+        //==============================================================================
+        // Combo fold: equal blend of the triangle and sine folds, so are its antiderivatives
+        inline double comboFold (double u, double t) noexcept { return 0.5 * (foldToRange (u, t) + sinFold (u, t)); }
+        inline double comboFoldAD1 (double u, double t) noexcept { return 0.5 * (foldToRangeAD1 (u, t) + sinFoldAD1 (u, t)); }
+        inline double comboFoldAD2 (double u, double t) noexcept { return 0.5 * (foldToRangeAD2 (u, t) + sinFoldAD2 (u, t)); }
+    }
+
+    //==============================================================================
+    /** Compile-time access to a fold shape, so kernels can be templated on the type. */
+    template <FoldType type>
+    struct Shape;
+
+    template <>
+    struct Shape<FoldType::foldToRange>
+    {
+        static double f (double u, double t) noexcept { return Shapes::foldToRange (u, t); }
+        static double ad1 (double u, double t) noexcept { return Shapes::foldToRangeAD1 (u, t); }
+        static double ad2 (double u, double t) noexcept { return Shapes::foldToRangeAD2 (u, t); }
+    };
+
+    template <>
+    struct Shape<FoldType::sinFold>
+    {
+        static double f (double u, double t) noexcept { return Shapes::sinFold (u, t); }
+        static double ad1 (double u, double t) noexcept { return Shapes::sinFoldAD1 (u, t); }
+        static double ad2 (double u, double t) noexcept { return Shapes::sinFoldAD2 (u, t); }
+    };
+
+    template <>
+    struct Shape<FoldType::comboFold>
+    {
+        static double f (double u, double t) noexcept { return Shapes::comboFold (u, t); }
+        static double ad1 (double u, double t) noexcept { return Shapes::comboFoldAD1 (u, t); }
+        static double ad2 (double u, double t) noexcept { return Shapes::comboFoldAD2 (u, t); }
+    };
+
+    /** Same interface as Shape<type> for a ShapeBlend, with the weights fixed. The
+        antiderivatives are linear in the shape, so they blend with the same weights. */
+    struct BlendedShape
+    {
+        double triangle = 1.0, sine = 0.0;
+
+        double f (double u, double t) const noexcept { return triangle * Shapes::foldToRange (u, t) + sine * Shapes::sinFold (u, t); }
+        double ad1 (double u, double t) const noexcept { return triangle * Shapes::foldToRangeAD1 (u, t) + sine * Shapes::sinFoldAD1 (u, t); }
+        double ad2 (double u, double t) const noexcept { return triangle * Shapes::foldToRangeAD2 (u, t) + sine * Shapes::sinFoldAD2 (u, t); }
+    };
+}
@@ -0,0 +1,403 @@
+#pragma once
+
+#include "FoldKernels.h"
+
+/*  Instruction-set independent body of the fold kernels.
+
+    The shapes are punk_dsp::Wavefolder's FoldToRange, SinFold and ComboFold (see
+    FoldDSP::Shapes), vectorised. Every table built from this body is run against the
+    library by WavefolderTests (tests/Main.cpp), so any change to the arithmetic in here
+    has to keep passing those.
+
+    This header is included by one translation unit per instruction set, each of which
+    provides two `Ops` structs (in an anonymous namespace), one per sample type, wrapping
+    its intrinsics:
+
+        using Sample;  using V;  static constexpr int width;
+        load, store, set1, add, sub, mul, div, min, abs, round, copySign
+
+    Since Ops has internal linkage, so does every instantiation below, which keeps the
+    AVX/AVX-512 code from leaking into the baseline translation units through the linker.
+    Only Ops is used in here (no std:: calls) for the same reason.
+*/
+namespace FoldDSP::Kernels
+{
+    template <typename Ops>
+    struct FoldKernelBody
+    {
+        using Sample = typename Ops::Sample;
+        using V = typename Ops::V;
+
+        static constexpr bool isDouble = sizeof (Sample) == sizeof (double);
+
+        struct Constants
+        {
+            V drive, biasPre, biasPost;
+            V threshold, period, invPeriod;
+            V wetGain, dryGain;
+        };
+
+        static Constants makeConstants (const FoldParams& p) noexcept
+        {
+            const Sample threshold = p.threshold, outGain = p.outGain, mix = p.mix;
+            const Sample period = 4 * threshold;
+
+            return { Ops::set1 (p.drive), Ops::set1 (p.biasPre), Ops::set1 (p.biasPost),
+                     Ops::set1 (threshold), Ops::set1 (period), Ops::set1 (1 / period),
+                     Ops::set1 (outGain * mix), Ops::set1 (outGain * (1 - mix)) };
+        }
+
+        /** Same with settings that differ per lane. */
+        static Constants makeConstants (V drive, V outGain, V biasPre, V biasPost, V threshold, V mix) noexcept
+        {
+            const V one = Ops::set1 (1);
+            const V period = Ops::mul (Ops::set1 (4), threshold);
+
+            return { drive, biasPre, biasPost,
+                     threshold, period, Ops::div (one, period),
+                     Ops::mul (outGain, mix), Ops::mul (outGain, Ops::sub (one, mix)) };
+        }
+
+        //==============================================================================
+        static V triangle (V u, const Constants& c) noexcept
+        {
+            // Reduce (u - t) to [-2t, 2t], the fold is then t - |r|
+            const V p = Ops::mul (Ops::sub (u, c.threshold), c.invPeriod);
+            const V r = Ops::mul (Ops::sub (p, Ops::round (p)), c.period);
+            return Ops::sub (c.threshold, Ops::abs (r));
+        }
+
+        static V sine (V u, const Constants& c) noexcept
+        {
+            // t * sin (2 pi * u / 4t), with the phase reduced to [-1/2, 1/2] cycles and
+            // then mirrored to [0, 1/4] cycles, where a Taylor series of degree 11 (float)
+            // or 21 (double) is < 1 ulp
+            const V phase = Ops::mul (u, c.invPeriod);
+            const V q = Ops::sub (phase, Ops::round (phase));
+            const V a = Ops::abs (q);
+            const V h = Ops::min (a, Ops::sub (Ops::set1 ((Sample) 0.5), a));
+
+            const V x = Ops::mul (h, Ops::set1 ((Sample) 6.283185307179586476925));
+            const V x2 = Ops::mul (x, x);
+
+            // Coefficients are (-1)^k / (2k + 1)!, highest degree first
+            constexpr double taylor[] = { 1.9572941063391262e-20, -8.2206352466243297e-18, 2.8114572543455208e-15,
+                                          -7.6471637318198164e-13, 1.6059043836821615e-10, -2.5052108385441720e-8,
+                                          2.7557319223985893e-6, -1.9841269841269841e-4, 8.3333333333333333e-3,
+                                          -1.6666666666666667e-1, 1.0 };
+            constexpr int numTerms = isDouble ? 11 : 6;
+            constexpr int first = 11 - numTerms;
+
+            V s = Ops::set1 ((Sample) taylor[first]);
+
+            for (int k = first + 1; k < 11; ++k)
+                s = Ops::add (Ops::mul (s, x2), Ops::set1 ((Sample) taylor[k]));
+
+            s = Ops::mul (s, x);
+
+            return Ops::mul (c.threshold, Ops::copySign (s, q));
+        }
+
+        template <FoldType type>
+        static V shape (V u, const Constants& c) noexcept
+        {
+            if constexpr (type == FoldType::foldToRange)
+                return triangle (u, c);
+            else if constexpr (type == FoldType::sinFold)
+                return sine (u, c);
+            else
+                return Ops::mul (Ops::set1 ((Sample) 0.5), Ops::add (triangle (u, c), sine (u, c)));
+        }
+
+        template <FoldType type, bool biasActive, bool mixActive>
+        static V processVector (V x, const Constants& c) noexcept
+        {
+            V u;
+            if constexpr (biasActive)
+                u = Ops::add (Ops::mul (c.drive, Ops::add (x, c.biasPre)), c.biasPost);
+            else
+                u = Ops::mul (c.drive, x);
+
+            const V wet = shape<type> (u, c);
+
+            if constexpr (mixActive)
+                return Ops::add (Ops::mul (c.wetGain, wet), Ops::mul (c.dryGain, x));
+            else
+                return Ops::mul (c.wetGain, wet);
+        }
+
+        //==============================================================================
+        /** Calls processNext on every vector of the block in turn. The ragged tail goes through
+            the same vector code on a zero-padded copy, so the last few samples are bit-identical
+            to the rest of the block. */
+        template <typename Fn>
+        static void forEachVector (Sample* data, int numSamples, Fn&& processNext) noexcept
+        {
+            int i = 0;
+
+            for (; i + Ops::width <= numSamples; i += Ops::width)
+                Ops::store (data + i, processNext (Ops::load (data + i)));
+
+            if (const int remaining = numSamples - i; remaining > 0)
+            {
+                alignas (64) Sample tail[Ops::width] = {};
+
+                for (int j = 0; j < remaining; ++j)
+                    tail[j] = data[i + j];
+
+                Ops::store (tail, processNext (Ops::load (tail)));
+
+                for (int j = 0; j < remaining; ++j)
+                    data[i + j] = tail[j];
+            }
+        }
+
+        template <FoldType type, bool biasActive, bool mixActive>
+        static void process (Sample* data, int numSamples, const FoldParams& params) noexcept
+        {
+            const auto c = makeConstants (params);
+            forEachVector (data, numSamples, [&c] (V x) { return processVector<type, biasActive, mixActive> (x, c); });
+        }
+
+        /** Settings along a ramp, one vector at a time: lane j is j samples further along than
+            lane 0, and every next() advances all lanes by `width` samples. */
+        struct RampLanes
+        {
+            V drive, outGain, biasPre, biasPost, threshold, mix;
+            V driveStep, outGainStep, biasPreStep, biasPostStep, thresholdStep, mixStep;
+
+            RampLanes (const FoldParams& start, const FoldRamp& ramp) noexcept
+            {
+                alignas (64) Sample driveLanes[Ops::width], outGainLanes[Ops::width];
+                Sample driveValue = start.drive, outGainValue = start.outGain;
+
+                for (int j = 0; j < Ops::width; ++j)
+                {
+                    driveLanes[j] = driveValue;
+                    outGainLanes[j] = outGainValue;
+                    driveValue *= ramp.driveRatio;
+                    outGainValue *= ramp.outGainRatio;
+                }
+
+                Sample driveStepRatio = 1, outGainStepRatio = 1;
+                for (int j = 0; j < Ops::width; ++j)
+                {
+                    driveStepRatio *= ramp.driveRatio;
+                    outGainStepRatio *= ramp.outGainRatio;
+                }
+
+                drive = Ops::load (driveLanes);
+                outGain = Ops::load (outGainLanes);
+                biasPre = linearLanes (start.biasPre, ramp.biasPreDelta);
+                biasPost = linearLanes (start.biasPost, ramp.biasPostDelta);
+                threshold = linearLanes (start.threshold, ramp.thresholdDelta);
+                mix = linearLanes (start.mix, ramp.mixDelta);
+
+                driveStep = Ops::set1 (driveStepRatio);
+                outGainStep = Ops::set1 (outGainStepRatio);
+                biasPreStep = Ops::set1 ((Sample) Ops::width * ramp.biasPreDelta);
+                biasPostStep = Ops::set1 ((Sample) Ops::width * ramp.biasPostDelta);
+                thresholdStep = Ops::set1 ((Sample) Ops::width * ramp.thresholdDelta);
+                mixStep = Ops::set1 ((Sample) Ops::width * ramp.mixDelta);
+            }
+
+            /** Constants of the current vector, then steps to the next one. */
+            Constants next() noexcept
+            {
+                const auto c = makeConstants (drive, outGain, biasPre, biasPost, threshold, mix);
+
+                drive = Ops::mul (drive, driveStep);
+                outGain = Ops::mul (outGain, outGainStep);
+                biasPre = Ops::add (biasPre, biasPreStep);
+                biasPost = Ops::add (biasPost, biasPostStep);
+                threshold = Ops::add (threshold, thresholdStep);
+                mix = Ops::add (mix, mixStep);
+
+                return c;
+            }
+        };
+
+        /** value + j * delta in lane j. */
+        static V linearLanes (Sample value, Sample delta) noexcept
+        {
+            alignas (64) Sample laneIndex[Ops::width];
+
+            for (int j = 0; j < Ops::width; ++j)
+                laneIndex[j] = (Sample) j;
+
+            return Ops::add (Ops::set1 (value), Ops::mul (Ops::load (laneIndex), Ops::set1 (delta)));
+        }
+
+        /** Same chain while the parameters ramp: lane j of each vector is j samples further
+            along the ramp, and every vector advances all lanes by `width` samples. */
+        template <FoldType type>
+        static void processRamped (Sample* data, int numSamples, const FoldParams& start, const FoldRamp& ramp) noexcept
+        {
+            RampLanes lanes (start, ramp);
+            forEachVector (data, numSamples, [&lanes] (V x) { return processVector<type, true, true> (x, lanes.next()); });
+        }
+
+        //==============================================================================
+        /** Full chain with a blend of the triangle and sine folds whose weights move linearly,
+            for morphing and for crossfades between fold types. Both shapes are evaluated, which
+            costs about as much as ComboFold. The parameters ramp too when paramsRamping is set,
+            otherwise they are taken from `start` and the ramp is ignored. */
+        template <bool paramsRamping>
+        static void processBlended (Sample* data, int numSamples, const FoldParams& start, const FoldRamp& ramp,
+                                    const ShapeBlend& blend) noexcept
+        {
+            V triangleWeight = linearLanes (blend.triangle, blend.triangleDelta);
+            V sineWeight = linearLanes (blend.sine, blend.sineDelta);
+            const V triangleStep = Ops::set1 ((Sample) Ops::width * blend.triangleDelta);
+            const V sineStep = Ops::set1 ((Sample) Ops::width * blend.sineDelta);
+
+            const auto blendNext = [&] (V x, const Constants& c)
+            {
+                const V y = processStreamVector<mixedFoldTypes> (x, c, triangleWeight, sineWeight);
+                triangleWeight = Ops::add (triangleWeight, triangleStep);
+                sineWeight = Ops::add (sineWeight, sineStep);
+                return y;
+            };
+
+            if constexpr (paramsRamping)
+            {
+                RampLanes lanes (start, ramp);
+                forEachVector (data, numSamples, [&] (V x) { return blendNext (x, lanes.next()); });
+            }
+            else
+            {
+                const auto c = makeConstants (start);
+                forEachVector (data, numSamples, [&] (V x) { return blendNext (x, c); });
+            }
+        }
+
+        //==============================================================================
+        /** Full chain of one vector of streams. Streams of mixed fold types blend both shapes by
+            their weights, which for ComboFold is the same arithmetic as shape<comboFold>(). */
+        template <int typeIndex>
+        static V processStreamVector (V x, const Constants& c, V triangleWeight, V sineWeight) noexcept
+        {
+            if constexpr (typeIndex == mixedFoldTypes)
+            {
+                const V u = Ops::add (Ops::mul (c.drive, Ops::add (x, c.biasPre)), c.biasPost);
+                const V wet = Ops::add (Ops::mul (triangleWeight, triangle (u, c)), Ops::mul (sineWeight, sine (u, c)));
+                return Ops::add (Ops::mul (c.wetGain, wet), Ops::mul (c.dryGain, x));
+            }
+            else
+            {
+                return processVector<(FoldType) typeIndex, true, true> (x, c);
+            }
+        }
+
+        template <int typeIndex>
+        static void processStreams (Sample* frames, int numFrames, int frameStride, int firstStream,
+                                    const StreamParams<Sample>& p) noexcept
+        {
+            const int s = firstStream;
+            const auto c = makeConstants (Ops::load (p.drive + s), Ops::load (p.outGain + s), Ops::load (p.biasPre + s),
+                                          Ops::load (p.biasPost + s), Ops::load (p.threshold + s), Ops::load (p.mix + s));
+            const V triangleWeight = Ops::load (p.triangleWeight + s);
+            const V sineWeight = Ops::load (p.sineWeight + s);
+
+            Sample* frame = frames + s;
+
+            for (int i = 0; i < numFrames; ++i, frame += frameStride)
+                Ops::store (frame, processStreamVector<typeIndex> (Ops::load (frame), c, triangleWeight, sineWeight));
+        }
+
+        template <int typeIndex>
+        static void processStreamsRamped (Sample* frames, int numFrames, int frameStride, int firstStream,
+                                          const StreamParams<Sample>& p, const StreamSteps<Sample>& steps) noexcept
+        {
+            const int s = firstStream;
+
+            V drive = Ops::load (p.drive + s);
+            V outGain = Ops::load (p.outGain + s);
+            V biasPre = Ops::load (p.biasPre + s);
+            V biasPost = Ops::load (p.biasPost + s);
+            V threshold = Ops::load (p.threshold + s);
+            V mix = Ops::load (p.mix + s);
+
+            const V driveRatio = Ops::load (steps.driveRatio + s);
+            const V outGainRatio = Ops::load (steps.outGainRatio + s);
+            const V biasPreDelta = Ops::load (steps.biasPreDelta + s);
+            const V biasPostDelta = Ops::load (steps.biasPostDelta + s);
+            const V thresholdDelta = Ops::load (steps.thresholdDelta + s);
+            const V mixDelta = Ops::load (steps.mixDelta + s);
+
+            const V triangleWeight = Ops::load (p.triangleWeight + s);
+            const V sineWeight = Ops::load (p.sineWeight + s);
+
+            Sample* frame = frames + s;
+
+            for (int i = 0; i < numFrames; ++i, frame += frameStride)
+            {
+                const auto c = makeConstants (drive, outGain, biasPre, biasPost, threshold, mix);
+                Ops::store (frame, processStreamVector<typeIndex> (Ops::load (frame), c, triangleWeight, sineWeight));
+
+                drive = Ops::mul (drive, driveRatio);
+                outGain = Ops::mul (outGain, outGainRatio);
+                biasPre = Ops::add (biasPre, biasPreDelta);
+                biasPost = Ops::add (biasPost, biasPostDelta);
+                threshold = Ops::add (threshold, thresholdDelta);
+                mix = Ops::add (mix, mixDelta);
+            }
+
+            Ops::store (p.drive + s, drive);
+            Ops::store (p.outGain + s, outGain);
+            Ops::store (p.biasPre + s, biasPre);
+            Ops::store (p.biasPost + s, biasPost);
+            Ops::store (p.threshold + s, threshold);
+            Ops::store (p.mix + s, mix);
+        }
+
+        template <int typeIndex>
+        static void fillStreamKernels (KernelSet<Sample>& kernels) noexcept
+        {
+            kernels.streams[typeIndex] = processStreams<typeIndex>;
+            kernels.rampedStreams[typeIndex] = processStreamsRamped<typeIndex>;
+        }
+
+        template <FoldType type>
+        static void fillKernels (BufferKernel<Sample> (&kernels)[2][2]) noexcept
+        {
+            kernels[0][0] = process<type, false, false>;
+            kernels[0][1] = process<type, false, true>;
+            kernels[1][0] = process<type, true, false>;
+            kernels[1][1] = process<type, true, true>;
+        }
+
+        /** Fills the kernels of this sample type into the table. */
+        static void fillTable (KernelTable& table) noexcept
+        {
+            auto& kernels = table.getKernels<Sample>();
+            kernels.width = Ops::width;
+
+            fillKernels<FoldType::foldToRange> (kernels.kernels[(int) FoldType::foldToRange]);
+            fillKernels<FoldType::sinFold> (kernels.kernels[(int) FoldType::sinFold]);
+            fillKernels<FoldType::comboFold> (kernels.kernels[(int) FoldType::comboFold]);
+
+            kernels.ramped[(int) FoldType::foldToRange] = processRamped<FoldType::foldToRange>;
+            kernels.ramped[(int) FoldType::sinFold] = processRamped<FoldType::sinFold>;
+            kernels.ramped[(int) FoldType::comboFold] = processRamped<FoldType::comboFold>;
+
+            fillStreamKernels<(int) FoldType::foldToRange> (kernels);
+            fillStreamKernels<(int) FoldType::sinFold> (kernels);
+            fillStreamKernels<(int) FoldType::comboFold> (kernels);
+            fillStreamKernels<mixedFoldTypes> (kernels);
+
+            kernels.blended[0] = processBlended<false>;
+            kernels.blended[1] = processBlended<true>;
+        }
+    };
+
+    /** Table of both sample types, each with its own vector width. */
+    template <typename FloatOps, typename DoubleOps>
+    KernelTable makeTable (Isa isa, const char* name) noexcept
+    {
+        KernelTable table { isa, name, {}, {} };
+        FoldKernelBody<FloatOps>::fillTable (table);
+        FoldKernelBody<DoubleOps>::fillTable (table);
+        return table;
+    }
+}
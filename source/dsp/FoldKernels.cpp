@@ -0,0 +1,106 @@
+#include "FoldKernels.h"
+
+#include <initializer_list>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <immintrin.h>
+    #include <intrin.h>
+#endif
+
+namespace FoldDSP::Kernels
+{
+    namespace
+    {
+        //==============================================================================
+        bool cpuSupports (Isa isa) noexcept
+        {
+            switch (isa)
+            {
+                case Isa::scalar:
+                    return true;
+
+                case Isa::neon:
+                    return getNeonTable() != nullptr;
+
+                case Isa::sse2:
+                case Isa::avx2:
+                case Isa::avx512:
+                {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+                    // These also check that the OS saves the wider registers
+                    __builtin_cpu_init();
+
+                    if (isa == Isa::sse2)
+                        return __builtin_cpu_supports ("sse2");
+                    if (isa == Isa::avx2)
+                        return __builtin_cpu_supports ("avx2");
+
+                    return __builtin_cpu_supports ("avx512f");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+                    int info[4] {};
+                    __cpuid (info, 1);
+
+                    if (isa == Isa::sse2)
+                        return (info[3] & (1 << 26)) != 0;
+
+                    // OSXSAVE, then ask the OS which register states it preserves
+                    if ((info[2] & (1 << 27)) == 0)
+                        return false;
+
+                    const auto xcr0 = _xgetbv (0);
+                    __cpuidex (info, 7, 0);
+
+                    if (isa == Isa::avx2)
+                        return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+
+                    return (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) != 0;
+#else
+                    return false;
+#endif
+                }
+            }
+
+            return false;
+        }
+
+        const KernelTable* getCompiledTable (Isa isa) noexcept
+        {
+            switch (isa)
+            {
+                case Isa::scalar: return getScalarTable();
+                case Isa::sse2:   return getSse2Table();
+                case Isa::avx2:   return getAvx2Table();
+                case Isa::avx512: return getAvx512Table();
+                case Isa::neon:   return getNeonTable();
+            }
+
+            return nullptr;
+        }
+
+        const KernelTable& selectBestTable() noexcept
+        {
+            for (auto isa : { Isa::avx512, Isa::avx2, Isa::neon, Isa::sse2 })
+            {
+                if (auto* table = getTable (isa))
+                    return *table;
+            }
+
+            return *getScalarTable();
+        }
+    }
+
+    //==============================================================================
+    const KernelTable* getTable (Isa isa) noexcept
+    {
+        if (! cpuSupports (isa))
+            return nullptr;
+
+        return getCompiledTable (isa);
+    }
+
+    const KernelTable& getActiveTable() noexcept
+    {
+        static const KernelTable& table = selectBestTable();
+        return table;
+    }
+}
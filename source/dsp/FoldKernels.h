@@ -0,0 +1,181 @@
+#pragma once
+
+#include "FoldFunctions.h"
+
+#include <type_traits>
+
+namespace FoldDSP::Kernels
+{
+    //==============================================================================
+    /** In-place fold of one channel: bias/drive, the fold shape and the mix/outGain
+        stage in a single pass over the samples. */
+    template <typename SampleType>
+    using BufferKernel = void (*) (SampleType* data, int numSamples, const FoldParams& params);
+
+    /** Same as BufferKernel while the parameters are being smoothed: sample i uses the
+        settings `start` advanced by i steps of `ramp`. */
+    template <typename SampleType>
+    using RampKernel = void (*) (SampleType* data, int numSamples, const FoldParams& start, const FoldRamp& ramp);
+
+    /** In-place fold with a blend of the shapes (see ShapeBlend), whose weights move by their
+        deltas every sample. The parameters ramp as in RampKernel, or stay at `start` for the
+        static variant. */
+    template <typename SampleType>
+    using BlendKernel = void (*) (SampleType* data, int numSamples, const FoldParams& start, const FoldRamp& ramp,
+                                  const ShapeBlend& blend);
+
+    //==============================================================================
+    /** Settings of many independent streams in structure-of-arrays layout: element s of every
+        array belongs to stream s. The two weights blend the shapes per stream (1, 0 is
+        FoldToRange, 0, 1 SinFold and 1/2, 1/2 ComboFold), so streams of different fold types
+        can share a vector. */
+    template <typename SampleType>
+    struct StreamParams
+    {
+        SampleType* drive;
+        SampleType* outGain;
+        SampleType* biasPre;
+        SampleType* biasPost;
+        SampleType* threshold;
+        SampleType* mix;
+        SampleType* triangleWeight;
+        SampleType* sineWeight;
+    };
+
+    /** Per-sample increments of StreamParams while smoothing, the identity for static streams. */
+    template <typename SampleType>
+    struct StreamSteps
+    {
+        const SampleType* driveRatio;
+        const SampleType* outGainRatio;
+        const SampleType* biasPreDelta;
+        const SampleType* biasPostDelta;
+        const SampleType* thresholdDelta;
+        const SampleType* mixDelta;
+    };
+
+    /** In-place fold of one vector of streams stored frame by frame: the sample of stream s in
+        frame i is frames[i * frameStride + s], and the vector holds the streams from firstStream
+        on, each lane with its own settings. */
+    template <typename SampleType>
+    using StreamKernel = void (*) (SampleType* frames, int numFrames, int frameStride, int firstStream,
+                                   const StreamParams<SampleType>& params);
+
+    /** Same as StreamKernel while smoothing: every frame advances the settings by one step, and
+        the settings reached at the end are written back to `params`. */
+    template <typename SampleType>
+    using StreamRampKernel = void (*) (SampleType* frames, int numFrames, int frameStride, int firstStream,
+                                       const StreamParams<SampleType>& params, const StreamSteps<SampleType>& steps);
+
+    /** Stream kernel index for vectors whose streams don't all have the same fold type. */
+    constexpr int mixedFoldTypes = 3;
+
+    enum class Isa
+    {
+        scalar = 0,
+        sse2,
+        avx2,
+        avx512,
+        neon
+    };
+
+    /** All kernels of one instruction set and sample type, specialised at compile time on
+        the fold type and on whether the bias and dry/wet stages do anything. The default
+        settings (no bias, 100% wet) then run a minimal inner loop with no dead arithmetic. */
+    template <typename SampleType>
+    struct KernelSet
+    {
+        int width;  // Samples per vector
+
+        // [fold type][bias active][mix active]
+        BufferKernel<SampleType> kernels[3][2][2];
+
+        // [fold type], only used while smoothing so not specialised any further
+        RampKernel<SampleType> ramped[3];
+
+        // [parameters ramping], for morphs and crossfades between fold types
+        BlendKernel<SampleType> blended[2];
+
+        // [fold type or mixedFoldTypes], vectorised across streams instead of along time
+        StreamKernel<SampleType> streams[4];
+        StreamRampKernel<SampleType> rampedStreams[4];
+    };
+
+    /** The float and double kernels of one instruction set. Both precisions are computed
+        in their own type throughout, so the double path keeps its precision at high drive. */
+    struct KernelTable
+    {
+        Isa isa;
+        const char* name;
+
+        KernelSet<float> floatKernels;
+        KernelSet<double> doubleKernels;
+
+        template <typename SampleType>
+        KernelSet<SampleType>& getKernels() noexcept
+        {
+            if constexpr (std::is_same_v<SampleType, double>)
+                return doubleKernels;
+            else
+                return floatKernels;
+        }
+
+        template <typename SampleType>
+        const KernelSet<SampleType>& getKernels() const noexcept
+        {
+            if constexpr (std::is_same_v<SampleType, double>)
+                return doubleKernels;
+            else
+                return floatKernels;
+        }
+
+        /** Samples per vector for the given sample type. */
+        template <typename SampleType = float>
+        int getWidth() const noexcept { return getKernels<SampleType>().width; }
+
+        template <typename SampleType = float>
+        BufferKernel<SampleType> get (FoldType type, bool biasActive = true, bool mixActive = true) const noexcept
+        {
+            return getKernels<SampleType>().kernels[(int) type][biasActive ? 1 : 0][mixActive ? 1 : 0];
+        }
+
+        template <typename SampleType = float>
+        RampKernel<SampleType> getRamped (FoldType type) const noexcept { return getKernels<SampleType>().ramped[(int) type]; }
+
+        template <typename SampleType = float>
+        BlendKernel<SampleType> getBlended (bool paramsRamping) const noexcept { return getKernels<SampleType>().blended[paramsRamping ? 1 : 0]; }
+
+        /** Stream kernels for a fold type index, or mixedFoldTypes. */
+        template <typename SampleType = float>
+        StreamKernel<SampleType> getStreams (int typeIndex) const noexcept { return getKernels<SampleType>().streams[typeIndex]; }
+
+        template <typename SampleType = float>
+        StreamRampKernel<SampleType> getRampedStreams (int typeIndex) const noexcept { return getKernels<SampleType>().rampedStreams[typeIndex]; }
+
+        /** Picks the cheapest kernel that is still exact for these settings. */
+        template <typename SampleType = float>
+        BufferKernel<SampleType> select (FoldType type, const FoldParams& params) const noexcept
+        {
+            return get<SampleType> (type, isBiasActive (params), isMixActive (params));
+        }
+
+        static bool isBiasActive (const FoldParams& params) noexcept { return params.biasPre != 0.0f || params.biasPost != 0.0f; }
+        static bool isMixActive (const FoldParams& params) noexcept { return params.mix < 1.0f; }
+    };
+
+    // Per instruction set tables, defined in FoldKernels<Isa>.cpp. These return nullptr when
+    // the ISA isn't available for the target architecture, and must only be called once the
+    // CPU is known to support it: use getTable() instead.
+    const KernelTable* getScalarTable() noexcept;
+    const KernelTable* getSse2Table() noexcept;
+    const KernelTable* getAvx2Table() noexcept;
+    const KernelTable* getAvx512Table() noexcept;
+    const KernelTable* getNeonTable() noexcept;
+
+    /** Returns the table for the given instruction set, or nullptr if it wasn't compiled
+        into this binary or the CPU we're running on doesn't support it. */
+    const KernelTable* getTable (Isa isa) noexcept;
+
+    /** The fastest supported table, picked once by CPU feature detection. */
+    const KernelTable& getActiveTable() noexcept;
+}
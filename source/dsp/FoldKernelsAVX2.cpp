@@ -0,0 +1,98 @@
+#include "FoldKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define FOLDDSP_HAS_AVX2 1
+    #include <immintrin.h>
+#else
+    #define FOLDDSP_HAS_AVX2 0
+#endif
+
+#if FOLDDSP_HAS_AVX2
+    // Only the kernels below are compiled for AVX2, the rest of the binary stays on the
+    // baseline ISA. FMA is deliberately left out so the multiply-adds round the same way
+    // as in the scalar reference.
+    #if defined(__clang__)
+        #pragma clang attribute push (__attribute__ ((target ("avx2"))), apply_to = function)
+    #elif defined(__GNUC__)
+        #pragma GCC push_options
+        #pragma GCC target ("avx2")
+    #endif
+
+    #include "FoldKernelBody.h"
+
+namespace FoldDSP::Kernels
+{
+    namespace
+    {
+        struct Avx2Ops
+        {
+            using Sample = float;
+            using V = __m256;
+            static constexpr int width = 8;
+
+            static V load (const float* p) noexcept { return _mm256_loadu_ps (p); }
+            static void store (float* p, V v) noexcept { _mm256_storeu_ps (p, v); }
+            static V set1 (float v) noexcept { return _mm256_set1_ps (v); }
+
+            static V add (V a, V b) noexcept { return _mm256_add_ps (a, b); }
+            static V sub (V a, V b) noexcept { return _mm256_sub_ps (a, b); }
+            static V mul (V a, V b) noexcept { return _mm256_mul_ps (a, b); }
+            static V div (V a, V b) noexcept { return _mm256_div_ps (a, b); }
+            static V min (V a, V b) noexcept { return _mm256_min_ps (a, b); }
+            static V abs (V v) noexcept { return _mm256_andnot_ps (_mm256_set1_ps (-0.0f), v); }
+            static V round (V v) noexcept { return _mm256_round_ps (v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+            static V copySign (V mag, V sign) noexcept
+            {
+                const V signMask = _mm256_set1_ps (-0.0f);
+                return _mm256_or_ps (_mm256_andnot_ps (signMask, mag), _mm256_and_ps (signMask, sign));
+            }
+        };
+
+        struct Avx2DoubleOps
+        {
+            using Sample = double;
+            using V = __m256d;
+            static constexpr int width = 4;
+
+            static V load (const double* p) noexcept { return _mm256_loadu_pd (p); }
+            static void store (double* p, V v) noexcept { _mm256_storeu_pd (p, v); }
+            static V set1 (double v) noexcept { return _mm256_set1_pd (v); }
+
+            static V add (V a, V b) noexcept { return _mm256_add_pd (a, b); }
+            static V sub (V a, V b) noexcept { return _mm256_sub_pd (a, b); }
+            static V mul (V a, V b) noexcept { return _mm256_mul_pd (a, b); }
+            static V div (V a, V b) noexcept { return _mm256_div_pd (a, b); }
+            static V min (V a, V b) noexcept { return _mm256_min_pd (a, b); }
+            static V abs (V v) noexcept { return _mm256_andnot_pd (_mm256_set1_pd (-0.0), v); }
+            static V round (V v) noexcept { return _mm256_round_pd (v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+            static V copySign (V mag, V sign) noexcept
+            {
+                const V signMask = _mm256_set1_pd (-0.0);
+                return _mm256_or_pd (_mm256_andnot_pd (signMask, mag), _mm256_and_pd (signMask, sign));
+            }
+        };
+    }
+}
+
+    // Back to the baseline ISA, the getter runs before we know whether the CPU has AVX2
+    #if defined(__clang__)
+        #pragma clang attribute pop
+    #elif defined(__GNUC__)
+        #pragma GCC pop_options
+    #endif
+#endif
+
+namespace FoldDSP::Kernels
+{
+#if FOLDDSP_HAS_AVX2
+    const KernelTable* getAvx2Table() noexcept
+    {
+        static const KernelTable table = makeTable<Avx2Ops, Avx2DoubleOps> (Isa::avx2, "AVX2");
+        return &table;
+    }
+#else
+    const KernelTable* getAvx2Table() noexcept { return nullptr; }
+#endif
+}
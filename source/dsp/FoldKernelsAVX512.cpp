@@ -0,0 +1,99 @@
+#include "FoldKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define FOLDDSP_HAS_AVX512 1
+    #include <immintrin.h>
+#else
+    #define FOLDDSP_HAS_AVX512 0
+#endif
+
+#if FOLDDSP_HAS_AVX512
+    // Only the kernels below are compiled for AVX-512F, see FoldKernelsAVX2.cpp
+    #if defined(__clang__)
+        #pragma clang attribute push (__attribute__ ((target ("avx512f"))), apply_to = function)
+    #elif defined(__GNUC__)
+        #pragma GCC push_options
+        #pragma GCC target ("avx512f")
+    #endif
+
+    #include "FoldKernelBody.h"
+
+namespace FoldDSP::Kernels
+{
+    namespace
+    {
+        struct Avx512Ops
+        {
+            using Sample = float;
+            using V = __m512;
+            static constexpr int width = 16;
+
+            static V load (const float* p) noexcept { return _mm512_loadu_ps (p); }
+            static void store (float* p, V v) noexcept { _mm512_storeu_ps (p, v); }
+            static V set1 (float v) noexcept { return _mm512_set1_ps (v); }
+
+            static V add (V a, V b) noexcept { return _mm512_add_ps (a, b); }
+            static V sub (V a, V b) noexcept { return _mm512_sub_ps (a, b); }
+            static V mul (V a, V b) noexcept { return _mm512_mul_ps (a, b); }
+            static V div (V a, V b) noexcept { return _mm512_div_ps (a, b); }
+            static V min (V a, V b) noexcept { return _mm512_min_ps (a, b); }
+            static V abs (V v) noexcept { return _mm512_abs_ps (v); }
+            static V round (V v) noexcept { return _mm512_roundscale_ps (v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+            static V copySign (V mag, V sign) noexcept
+            {
+                // Float and/or need AVX-512DQ, the integer versions are plain AVX-512F
+                const __m512i signMask = _mm512_set1_epi32 ((int) 0x80000000);
+                return _mm512_castsi512_ps (_mm512_or_si512 (_mm512_andnot_si512 (signMask, _mm512_castps_si512 (mag)),
+                                                             _mm512_and_si512 (signMask, _mm512_castps_si512 (sign))));
+            }
+        };
+
+        struct Avx512DoubleOps
+        {
+            using Sample = double;
+            using V = __m512d;
+            static constexpr int width = 8;
+
+            static V load (const double* p) noexcept { return _mm512_loadu_pd (p); }
+            static void store (double* p, V v) noexcept { _mm512_storeu_pd (p, v); }
+            static V set1 (double v) noexcept { return _mm512_set1_pd (v); }
+
+            static V add (V a, V b) noexcept { return _mm512_add_pd (a, b); }
+            static V sub (V a, V b) noexcept { return _mm512_sub_pd (a, b); }
+            static V mul (V a, V b) noexcept { return _mm512_mul_pd (a, b); }
+            static V div (V a, V b) noexcept { return _mm512_div_pd (a, b); }
+            static V min (V a, V b) noexcept { return _mm512_min_pd (a, b); }
+            static V abs (V v) noexcept { return _mm512_abs_pd (v); }
+            static V round (V v) noexcept { return _mm512_roundscale_pd (v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+            static V copySign (V mag, V sign) noexcept
+            {
+                const __m512i signMask = _mm512_set1_epi64 ((long long) 0x8000000000000000ull);
+                return _mm512_castsi512_pd (_mm512_or_si512 (_mm512_andnot_si512 (signMask, _mm512_castpd_si512 (mag)),
+                                                             _mm512_and_si512 (signMask, _mm512_castpd_si512 (sign))));
+            }
+        };
+    }
+}
+
+    // Back to the baseline ISA, the getter runs before we know whether the CPU has AVX-512
+    #if defined(__clang__)
+        #pragma clang attribute pop
+    #elif defined(__GNUC__)
+        #pragma GCC pop_options
+    #endif
+#endif
+
+namespace FoldDSP::Kernels
+{
+#if FOLDDSP_HAS_AVX512
+    const KernelTable* getAvx512Table() noexcept
+    {
+        static const KernelTable table = makeTable<Avx512Ops, Avx512DoubleOps> (Isa::avx512, "AVX-512");
+        return &table;
+    }
+#else
+    const KernelTable* getAvx512Table() noexcept { return nullptr; }
+#endif
+}
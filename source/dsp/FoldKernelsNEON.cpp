@@ -0,0 +1,74 @@
+#include "FoldKernels.h"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    #define FOLDDSP_HAS_NEON 1
+    #include "FoldKernelBody.h"
+    #include <arm_neon.h>
+#else
+    #define FOLDDSP_HAS_NEON 0
+#endif
+
+namespace FoldDSP::Kernels
+{
+#if FOLDDSP_HAS_NEON
+    namespace
+    {
+        struct NeonOps
+        {
+            using Sample = float;
+            using V = float32x4_t;
+            static constexpr int width = 4;
+
+            static V load (const float* p) noexcept { return vld1q_f32 (p); }
+            static void store (float* p, V v) noexcept { vst1q_f32 (p, v); }
+            static V set1 (float v) noexcept { return vdupq_n_f32 (v); }
+
+            static V add (V a, V b) noexcept { return vaddq_f32 (a, b); }
+            static V sub (V a, V b) noexcept { return vsubq_f32 (a, b); }
+            static V mul (V a, V b) noexcept { return vmulq_f32 (a, b); }
+            static V div (V a, V b) noexcept { return vdivq_f32 (a, b); }
+            static V min (V a, V b) noexcept { return vminq_f32 (a, b); }
+            static V abs (V v) noexcept { return vabsq_f32 (v); }
+            static V round (V v) noexcept { return vrndnq_f32 (v); }
+
+            static V copySign (V mag, V sign) noexcept
+            {
+                return vbslq_f32 (vdupq_n_u32 (0x80000000u), sign, mag);
+            }
+        };
+
+        struct NeonDoubleOps
+        {
+            using Sample = double;
+            using V = float64x2_t;
+            static constexpr int width = 2;
+
+            static V load (const double* p) noexcept { return vld1q_f64 (p); }
+            static void store (double* p, V v) noexcept { vst1q_f64 (p, v); }
+            static V set1 (double v) noexcept { return vdupq_n_f64 (v); }
+
+            static V add (V a, V b) noexcept { return vaddq_f64 (a, b); }
+            static V sub (V a, V b) noexcept { return vsubq_f64 (a, b); }
+            static V mul (V a, V b) noexcept { return vmulq_f64 (a, b); }
+            static V div (V a, V b) noexcept { return vdivq_f64 (a, b); }
+            static V min (V a, V b) noexcept { return vminq_f64 (a, b); }
+            static V abs (V v) noexcept { return vabsq_f64 (v); }
+            static V round (V v) noexcept { return vrndnq_f64 (v); }
+
+            static V copySign (V mag, V sign) noexcept
+            {
+                return vbslq_f64 (vdupq_n_u64 (0x8000000000000000ull), sign, mag);
+            }
+        };
+    }
+
+    // NEON is part of the AArch64 baseline, so there's nothing to detect at runtime
+    const KernelTable* getNeonTable() noexcept
+    {
+        static const KernelTable table = makeTable<NeonOps, NeonDoubleOps> (Isa::neon, "NEON");
+        return &table;
+    }
+#else
+    const KernelTable* getNeonTable() noexcept { return nullptr; }
+#endif
+}
@@ -0,0 +1,89 @@
+#include "FoldKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FOLDDSP_HAS_SSE2 1
+    #include "FoldKernelBody.h"
+    #include <emmintrin.h>
+#else
+    #define FOLDDSP_HAS_SSE2 0
+#endif
+
+namespace FoldDSP::Kernels
+{
+#if FOLDDSP_HAS_SSE2
+    namespace
+    {
+        struct Sse2Ops
+        {
+            using Sample = float;
+            using V = __m128;
+            static constexpr int width = 4;
+
+            static V load (const float* p) noexcept { return _mm_loadu_ps (p); }
+            static void store (float* p, V v) noexcept { _mm_storeu_ps (p, v); }
+            static V set1 (float v) noexcept { return _mm_set1_ps (v); }
+
+            static V add (V a, V b) noexcept { return _mm_add_ps (a, b); }
+            static V sub (V a, V b) noexcept { return _mm_sub_ps (a, b); }
+            static V mul (V a, V b) noexcept { return _mm_mul_ps (a, b); }
+            static V div (V a, V b) noexcept { return _mm_div_ps (a, b); }
+            static V min (V a, V b) noexcept { return _mm_min_ps (a, b); }
+            static V abs (V v) noexcept { return _mm_andnot_ps (_mm_set1_ps (-0.0f), v); }
+
+            static V round (V v) noexcept
+            {
+                // No roundps before SSE4.1: go through int32, which is exact below 2^22
+                const V limit = _mm_set1_ps (4194304.0f);
+                v = _mm_max_ps (_mm_min_ps (v, limit), _mm_sub_ps (_mm_setzero_ps(), limit));
+                return _mm_cvtepi32_ps (_mm_cvtps_epi32 (v));
+            }
+
+            static V copySign (V mag, V sign) noexcept
+            {
+                const V signMask = _mm_set1_ps (-0.0f);
+                return _mm_or_ps (_mm_andnot_ps (signMask, mag), _mm_and_ps (signMask, sign));
+            }
+        };
+
+        struct Sse2DoubleOps
+        {
+            using Sample = double;
+            using V = __m128d;
+            static constexpr int width = 2;
+
+            static V load (const double* p) noexcept { return _mm_loadu_pd (p); }
+            static void store (double* p, V v) noexcept { _mm_storeu_pd (p, v); }
+            static V set1 (double v) noexcept { return _mm_set1_pd (v); }
+
+            static V add (V a, V b) noexcept { return _mm_add_pd (a, b); }
+            static V sub (V a, V b) noexcept { return _mm_sub_pd (a, b); }
+            static V mul (V a, V b) noexcept { return _mm_mul_pd (a, b); }
+            static V div (V a, V b) noexcept { return _mm_div_pd (a, b); }
+            static V min (V a, V b) noexcept { return _mm_min_pd (a, b); }
+            static V abs (V v) noexcept { return _mm_andnot_pd (_mm_set1_pd (-0.0), v); }
+
+            static V round (V v) noexcept
+            {
+                // Same trick through int32, exact over the whole clamped range
+                const V limit = _mm_set1_pd (1073741824.0);
+                v = _mm_max_pd (_mm_min_pd (v, limit), _mm_sub_pd (_mm_setzero_pd(), limit));
+                return _mm_cvtepi32_pd (_mm_cvtpd_epi32 (v));
+            }
+
+            static V copySign (V mag, V sign) noexcept
+            {
+                const V signMask = _mm_set1_pd (-0.0);
+                return _mm_or_pd (_mm_andnot_pd (signMask, mag), _mm_and_pd (signMask, sign));
+            }
+        };
+    }
+
+    const KernelTable* getSse2Table() noexcept
+    {
+        static const KernelTable table = makeTable<Sse2Ops, Sse2DoubleOps> (Isa::sse2, "SSE2");
+        return &table;
+    }
+#else
+    const KernelTable* getSse2Table() noexcept { return nullptr; }
+#endif
+}
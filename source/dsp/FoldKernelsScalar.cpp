@@ -0,0 +1,37 @@
+#include "FoldKernelBody.h"
+#include "FoldKernels.h"
+
+#include <cmath>
+
+namespace FoldDSP::Kernels
+{
+    namespace
+    {
+        template <typename SampleType>
+        struct ScalarOps
+        {
+            using Sample = SampleType;
+            using V = SampleType;
+            static constexpr int width = 1;
+
+            static V load (const Sample* p) noexcept { return *p; }
+            static void store (Sample* p, V v) noexcept { *p = v; }
+            static V set1 (Sample v) noexcept { return v; }
+
+            static V add (V a, V b) noexcept { return a + b; }
+            static V sub (V a, V b) noexcept { return a - b; }
+            static V mul (V a, V b) noexcept { return a * b; }
+            static V div (V a, V b) noexcept { return a / b; }
+            static V min (V a, V b) noexcept { return a < b ? a : b; }
+            static V abs (V v) noexcept { return std::abs (v); }
+            static V round (V v) noexcept { return std::nearbyint (v); }
+            static V copySign (V mag, V sign) noexcept { return std::copysign (mag, sign); }
+        };
+    }
+
+    const KernelTable* getScalarTable() noexcept
+    {
+        static const KernelTable table = makeTable<ScalarOps<float>, ScalarOps<double>> (Isa::scalar, "Scalar");
+        return &table;
+    }
+}
@@ -0,0 +1,237 @@
+#include "MultibandFolder.h"
+
+namespace FoldDSP
+{
+    void MultibandFolder::prepare (int newNumChannels, double newSampleRate, bool doublePrecision)
+    {
+        numChannels = juce::jmax (1, newNumChannels);
+        states.assign ((size_t) numChannels, ChannelState {});
+
+        // Every band of every channel is allocated, setNumBands() only changes how many are folded
+        const int numStreams = maxBands * numChannels;
+
+        if (doublePrecision)
+        {
+            doubleFolder = std::make_unique<BatchFolder<double>> (kernels);
+            doubleFolder->prepare (numStreams, newSampleRate, rampSeconds);
+            framesPerChunk = juce::jmax (1, samplesPerChunk / doubleFolder->getFrameStride());
+            doubleFrames.assign ((size_t) (framesPerChunk * doubleFolder->getFrameStride()), 0.0);
+
+            floatFolder.reset();
+            floatFrames = {};
+        }
+        else
+        {
+            floatFolder = std::make_unique<BatchFolder<float>> (kernels);
+            floatFolder->prepare (numStreams, newSampleRate, rampSeconds);
+            framesPerChunk = juce::jmax (1, samplesPerChunk / floatFolder->getFrameStride());
+            floatFrames.assign ((size_t) (framesPerChunk * floatFolder->getFrameStride()), 0.0f);
+
+            doubleFolder.reset();
+            doubleFrames = {};
+        }
+
+        // Start over from silence with the active streams set for the new channel count
+        const int bands = numBands;
+        numBands = 0;
+        setNumBands (bands);
+        setSampleRate (newSampleRate);
+    }
+
+    void MultibandFolder::reset() noexcept
+    {
+        std::fill (states.begin(), states.end(), ChannelState {});
+    }
+
+    void MultibandFolder::setSampleRate (double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+
+        if (floatFolder != nullptr)
+            floatFolder->setRampTime (sampleRate, rampSeconds);
+
+        if (doubleFolder != nullptr)
+            doubleFolder->setRampTime (sampleRate, rampSeconds);
+
+        updateCoefficients();
+    }
+
+    //==============================================================================
+    bool MultibandFolder::setNumBands (int newNumBands) noexcept
+    {
+        newNumBands = juce::jlimit (1, maxBands, newNumBands);
+
+        if (newNumBands == numBands)
+            return false;
+
+        numBands = newNumBands;
+        jumpToSettings = true;
+        reset();
+
+        if (floatFolder != nullptr)
+            floatFolder->setNumActiveStreams (numBands * numChannels);
+
+        if (doubleFolder != nullptr)
+            doubleFolder->setNumActiveStreams (numBands * numChannels);
+
+        return true;
+    }
+
+    bool MultibandFolder::setCrossover (int index, float frequency) noexcept
+    {
+        if (frequencies[(size_t) index] == frequency)
+            return false;
+
+        frequencies[(size_t) index] = frequency;
+        updateCoefficients();
+        return true;
+    }
+
+    bool MultibandFolder::setBand (int band, FoldType type, const FoldParams& params) noexcept
+    {
+        bool changed = false;
+
+        const auto update = [&] (auto& folder)
+        {
+            const int first = band * numChannels;
+            changed = folder.getType (first) != type || folder.getParameters (first) != params;
+
+            if (! changed && ! jumpToSettings)
+                return;
+
+            for (int stream = first; stream < first + numChannels; ++stream)
+            {
+                folder.setType (stream, type);
+
+                if (jumpToSettings)
+                    folder.resetParameters (stream, params);
+                else
+                    folder.setParameters (stream, params);
+            }
+        };
+
+        if (floatFolder != nullptr)
+            update (*floatFolder);
+
+        if (doubleFolder != nullptr)
+            update (*doubleFolder);
+
+        return changed;
+    }
+
+    bool MultibandFolder::isSmoothing() const noexcept
+    {
+        return (floatFolder != nullptr && floatFolder->isSmoothing())
+            || (doubleFolder != nullptr && doubleFolder->isSmoothing());
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    void MultibandFolder::process (juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        auto* folder = getFolder<SampleType>();
+
+        if (numBands < 2 || folder == nullptr)
+            return;
+
+        auto* frames = getFrames<SampleType>().data();
+        const int stride = folder->getFrameStride();
+        const int numBlockChannels = juce::jmin ((int) block.getNumChannels(), numChannels);
+        const auto numSamples = (int) block.getNumSamples();
+
+        for (int start = 0; start < numSamples; start += framesPerChunk)
+        {
+            const int length = juce::jmin (framesPerChunk, numSamples - start);
+
+            // Split: band b of channel ch is stream b * numChannels + ch of each frame
+            for (int ch = 0; ch < numBlockChannels; ++ch)
+            {
+                const auto* data = block.getChannelPointer ((size_t) ch) + start;
+                auto& state = states[(size_t) ch];
+                std::array<double, maxBands> bands;
+
+                for (int i = 0; i < length; ++i)
+                {
+                    splitSample (state, (double) data[i], bands.data());
+                    auto* frame = frames + (size_t) i * (size_t) stride + (size_t) ch;
+
+                    for (int b = 0; b < numBands; ++b)
+                        frame[b * numChannels] = (SampleType) bands[(size_t) b];
+                }
+            }
+
+            // Every band of every channel at once, vectorised across streams
+            folder->processInterleaved (frames, length);
+
+            for (int ch = 0; ch < numBlockChannels; ++ch)
+            {
+                auto* data = block.getChannelPointer ((size_t) ch) + start;
+
+                for (int i = 0; i < length; ++i)
+                {
+                    const auto* frame = frames + (size_t) i * (size_t) stride + (size_t) ch;
+                    SampleType sum = 0;
+
+                    for (int b = 0; b < numBands; ++b)
+                        sum += frame[b * numChannels];
+
+                    data[i] = sum;
+                }
+            }
+        }
+
+        jumpToSettings = false;
+    }
+
+    //==============================================================================
+    void MultibandFolder::updateCoefficients() noexcept
+    {
+        // Ascending, and clear of Nyquist at the processing rate
+        const double maxFrequency = 0.45 * sampleRate;
+        double previous = 10.0;
+
+        for (int c = 0; c < maxCrossovers; ++c)
+        {
+            const double frequency = juce::jlimit (previous, maxFrequency, (double) frequencies[(size_t) c]);
+            const double g = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+
+            coefficients[(size_t) c] = { g, 1.0 / (1.0 + juce::MathConstants<double>::sqrt2 * g + g * g) };
+            previous = frequency;
+        }
+    }
+
+    void MultibandFolder::splitSample (ChannelState& state, double x, double* bands) noexcept
+    {
+        // Each crossover takes the low band off what's left above the previous one
+        const int numCrossovers = numBands - 1;
+        double rest = x;
+        double low, band, high, unused;
+
+        for (int c = 0; c < numCrossovers; ++c)
+        {
+            const auto& coeffs = coefficients[(size_t) c];
+            double lowOut, highOut;
+
+            state.split[(size_t) c].process (coeffs, rest, low, band, high);
+            state.low[(size_t) c].process (coeffs, low, lowOut, unused, unused);
+            state.high[(size_t) c].process (coeffs, high, unused, unused, highOut);
+
+            // Same phase as the bands above, which go through the later crossovers:
+            // low + high of a crossover is the allpass x - 2 sqrt2 band
+            for (int later = c + 1; later < numCrossovers; ++later)
+            {
+                state.allpasses[(size_t) (c * maxCrossovers + later)].process (coefficients[(size_t) later], lowOut, unused, band, unused);
+                lowOut -= 2.0 * juce::MathConstants<double>::sqrt2 * band;
+            }
+
+            bands[c] = lowOut;
+            rest = highOut;
+        }
+
+        bands[numCrossovers] = rest;
+    }
+
+    //==============================================================================
+    template void MultibandFolder::process (juce::dsp::AudioBlock<float>&) noexcept;
+    template void MultibandFolder::process (juce::dsp::AudioBlock<double>&) noexcept;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "BatchFolder.h"
+
+namespace FoldDSP
+{
+    //==============================================================================
+    /** Splits the signal into 2 to 4 bands, folds every band with its own type and settings
+        and sums the bands back.
+
+        The crossovers are 4th order Linkwitz-Riley (two cascaded Butterworth sections, built
+        from TPT state variable filters so their frequencies can move while running). Each
+        band also goes through the allpass of every crossover above it, so unfolded bands
+        sum back to a flat magnitude response.
+
+        The bands of every channel are folded by one BatchFolder in interleaved layout, one
+        (band, channel) stream per vector lane with its own settings. Streams are ordered band
+        by band, so the bands not in use are the last streams and aren't processed at all.
+        With a single band nothing runs: the caller is expected to fold the signal itself.
+
+        Only the memoryless chain is covered, no ADAA. Everything is allocated in prepare(),
+        in the precision the host processes with; process() must be called with that type.
+    */
+    class MultibandFolder
+    {
+    public:
+        static constexpr int maxBands = 4;
+        static constexpr int maxCrossovers = maxBands - 1;
+
+        explicit MultibandFolder (const Kernels::KernelTable& kernelTable = Kernels::getActiveTable()) : kernels (kernelTable) {}
+
+        void prepare (int numChannels, double sampleRate, bool doublePrecision = false);
+        void reset() noexcept;
+
+        /** Rate the bands are processed at, e.g. when the oversampling factor changes. */
+        void setSampleRate (double sampleRate) noexcept;
+
+        /** Returns true if the number of bands changed. The filters start again from silence
+            and the bands jump to the next settings they are given instead of ramping. */
+        bool setNumBands (int numBands) noexcept;
+        int getNumBands() const noexcept { return numBands; }
+
+        /** Crossover between band index and band index + 1, in Hz. Each crossover is kept at
+            or above the one below it. Returns true if the frequency changed. */
+        bool setCrossover (int index, float frequency) noexcept;
+
+        /** Settings of one band, shared by every channel. Returns true if they changed. */
+        bool setBand (int band, FoldType type, const FoldParams& params) noexcept;
+
+        bool isSmoothing() const noexcept;
+
+        template <typename SampleType>
+        void process (juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    private:
+        // 2nd order Butterworth section (k = sqrt 2), lowpass, bandpass & highpass at once
+        struct Coefficients
+        {
+            double g = 0.0, h = 1.0;
+        };
+
+        struct Section
+        {
+            double s1 = 0.0, s2 = 0.0;
+
+            void process (const Coefficients& c, double x, double& low, double& band, double& high) noexcept
+            {
+                const double hp = (x - (juce::MathConstants<double>::sqrt2 + c.g) * s1 - s2) * c.h;
+                const double bp = c.g * hp + s1;
+                const double lp = c.g * bp + s2;
+
+                s1 = c.g * hp + bp;
+                s2 = c.g * bp + lp;
+                low = lp;
+                band = bp;
+                high = hp;
+            }
+        };
+
+        struct ChannelState
+        {
+            std::array<Section, maxCrossovers> split, low, high;                // First section, then one per output
+            std::array<Section, maxCrossovers * maxCrossovers> allpasses;     // [band * maxCrossovers + crossover]
+        };
+
+        template <typename SampleType>
+        BatchFolder<SampleType>* getFolder() const noexcept
+        {
+            if constexpr (std::is_same_v<SampleType, double>)
+                return doubleFolder.get();
+            else
+                return floatFolder.get();
+        }
+
+        template <typename SampleType>
+        std::vector<SampleType>& getFrames() noexcept
+        {
+            if constexpr (std::is_same_v<SampleType, double>)
+                return doubleFrames;
+            else
+                return floatFrames;
+        }
+
+        void updateCoefficients() noexcept;
+        void splitSample (ChannelState& state, double x, double* bands) noexcept;
+
+        const Kernels::KernelTable& kernels;
+        int numChannels = 0, numBands = 1, framesPerChunk = 1;
+        double sampleRate = 44100.0;
+        bool jumpToSettings = true;
+
+        std::array<float, maxCrossovers> frequencies { 200.0f, 1000.0f, 5000.0f };
+        std::array<Coefficients, maxCrossovers> coefficients;
+        std::vector<ChannelState> states;
+
+        // Only the host's precision is allocated
+        std::unique_ptr<BatchFolder<float>> floatFolder;
+        std::unique_ptr<BatchFolder<double>> doubleFolder;
+        std::vector<float> floatFrames;
+        std::vector<double> doubleFrames;
+
+        // Interleaved frames per chunk are capped so a chunk stays in L1/L2 whatever the
+        // channel count
+        static constexpr int samplesPerChunk = 8192;
+        static constexpr double rampSeconds = 0.02;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultibandFolder)
+    };
+}
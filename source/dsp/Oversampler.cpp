@@ -0,0 +1,95 @@
+#include "Oversampler.h"
+
+namespace FoldDSP
+{
+    template <typename SampleType>
+    void Oversampler::prepareStages (Stages<SampleType>& stages, int numChannels, int maxBlockSize)
+    {
+        using Filter = typename juce::dsp::Oversampling<SampleType>::FilterType;
+
+        for (int p = 0; p < numPhases; ++p)
+        {
+            const auto filterType = p == (int) Phase::minimum ? Filter::filterHalfBandPolyphaseIIR
+                                                              : Filter::filterHalfBandFIREquiripple;
+
+            // Index 0 is the 1x setting, which bypasses the filters entirely
+            stages[(size_t) p][0].reset();
+
+            for (int f = 1; f < numFactors; ++f)
+            {
+                auto os = std::make_unique<juce::dsp::Oversampling<SampleType>> ((size_t) juce::jmax (1, numChannels),
+                                                                                 (size_t) f,
+                                                                                 filterType,
+                                                                                 true,
+                                                                                 p == (int) Phase::linear);
+                os->initProcessing ((size_t) maxBlockSize);
+                stages[(size_t) p][(size_t) f] = std::move (os);
+            }
+        }
+    }
+
+    void Oversampler::prepare (int numChannels, int maxBlockSize, bool doublePrecision)
+    {
+        usesDouble = doublePrecision;
+
+        // The other precision is freed, so a host switching precision doesn't keep both
+        if (usesDouble)
+        {
+            prepareStages (doubleStages, numChannels, maxBlockSize);
+            floatStages = {};
+        }
+        else
+        {
+            prepareStages (floatStages, numChannels, maxBlockSize);
+            doubleStages = {};
+        }
+    }
+
+    void Oversampler::reset()
+    {
+        for (auto& phaseStages : floatStages)
+            for (auto& os : phaseStages)
+                if (os != nullptr)
+                    os->reset();
+
+        for (auto& phaseStages : doubleStages)
+            for (auto& os : phaseStages)
+                if (os != nullptr)
+                    os->reset();
+    }
+
+    bool Oversampler::setMode (int newFactorIndex, Phase newPhase)
+    {
+        newFactorIndex = juce::jlimit (0, numFactors - 1, newFactorIndex);
+
+        if (newFactorIndex == factorIndex && newPhase == phase)
+            return false;
+
+        factorIndex = newFactorIndex;
+        phase = newPhase;
+
+        // Start the newly selected cascade from silence instead of stale history
+        if (auto* os = getActive<float>())
+            os->reset();
+
+        if (auto* os = getActive<double>())
+            os->reset();
+
+        return true;
+    }
+
+    double Oversampler::getLatencyInSamples() const noexcept
+    {
+        if (usesDouble)
+        {
+            if (auto* os = getActive<double>())
+                return (double) os->getLatencyInSamples();
+        }
+        else if (auto* os = getActive<float>())
+        {
+            return (double) os->getLatencyInSamples();
+        }
+
+        return 0.0;
+    }
+}
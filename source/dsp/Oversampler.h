@@ -0,0 +1,82 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+namespace FoldDSP
+{
+    //==============================================================================
+    /** Selectable 1x/2x/4x/8x/16x oversampling around the fold kernels.
+
+        Every factor/phase combination is a cascade of polyphase half-band filters
+        (juce::dsp::Oversampling) and is allocated up-front in prepare(), so switching
+        between settings on the audio thread never allocates. Only the filters of the
+        host's processing precision are allocated, process() must be called with that type.
+    */
+    class Oversampler
+    {
+    public:
+        enum class Phase
+        {
+            minimum = 0,    // Polyphase IIR half-bands, low latency
+            linear          // Polyphase equiripple FIR half-bands, integer latency
+        };
+
+        static constexpr int numFactors = 5;    // 1x, 2x, 4x, 8x, 16x
+        static constexpr int numPhases = 2;
+
+        Oversampler() = default;
+
+        void prepare (int numChannels, int maxBlockSize, bool doublePrecision = false);
+        void reset();
+
+        /** Selects the active stage count (0 = 1x ... 4 = 16x) and filter phase.
+            Returns true if the setting changed, so the caller can report the new latency. */
+        bool setMode (int factorIndex, Phase phase);
+
+        int getFactor() const noexcept { return 1 << factorIndex; }
+        double getLatencyInSamples() const noexcept;
+
+        /** Upsamples the block, runs the fold callback at the oversampled rate and
+            downsamples back in place. With 1x the callback sees the host block directly. */
+        template <typename SampleType, typename FoldFn>
+        void process (juce::dsp::AudioBlock<SampleType>& block, FoldFn&& fold)
+        {
+            auto* os = getActive<SampleType>();
+
+            if (os == nullptr)
+            {
+                fold (block);
+                return;
+            }
+
+            auto upBlock = os->processSamplesUp (block);
+            fold (upBlock);
+            os->processSamplesDown (block);
+        }
+
+    private:
+        template <typename SampleType>
+        using Stages = std::array<std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, numFactors>, numPhases>;
+
+        template <typename SampleType>
+        static void prepareStages (Stages<SampleType>& stages, int numChannels, int maxBlockSize);
+
+        template <typename SampleType>
+        juce::dsp::Oversampling<SampleType>* getActive() const noexcept
+        {
+            if constexpr (std::is_same_v<SampleType, double>)
+                return doubleStages[(size_t) phase][(size_t) factorIndex].get();
+            else
+                return floatStages[(size_t) phase][(size_t) factorIndex].get();
+        }
+
+        Stages<float> floatStages;
+        Stages<double> doubleStages;
+        bool usesDouble = false;
+
+        int factorIndex = 0;
+        Phase phase = Phase::minimum;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Oversampler)
+    };
+}
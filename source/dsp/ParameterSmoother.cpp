@@ -0,0 +1,76 @@
+#include "ParameterSmoother.h"
+
+namespace FoldDSP
+{
+    void FoldParamSmoother::reset (double sampleRate, double rampSeconds, const FoldParams& params) noexcept
+    {
+        const auto length = juce::roundToInt (sampleRate * rampSeconds);
+        forEachRamp ([length] (ParameterRamp& r) { r.setRampLength (length); });
+
+        drive.setCurrentAndTarget (params.drive);
+        outGain.setCurrentAndTarget (params.outGain);
+        biasPre.setCurrentAndTarget (params.biasPre);
+        biasPost.setCurrentAndTarget (params.biasPost);
+        threshold.setCurrentAndTarget (params.threshold);
+        mix.setCurrentAndTarget (params.mix);
+    }
+
+    void FoldParamSmoother::setTargets (const FoldParams& params) noexcept
+    {
+        drive.setTarget (params.drive);
+        outGain.setTarget (params.outGain);
+        biasPre.setTarget (params.biasPre);
+        biasPost.setTarget (params.biasPost);
+        threshold.setTarget (params.threshold);
+        mix.setTarget (params.mix);
+    }
+
+    bool FoldParamSmoother::isSmoothing() const noexcept
+    {
+        bool smoothing = false;
+        forEachRamp ([&smoothing] (const ParameterRamp& r) { smoothing = smoothing || r.isSmoothing(); });
+        return smoothing;
+    }
+
+    int FoldParamSmoother::getSegmentLength (int maxLength) const noexcept
+    {
+        int length = maxLength;
+
+        forEachRamp ([&length] (const ParameterRamp& r)
+        {
+            if (r.isSmoothing())
+                length = juce::jmin (length, r.getRemaining());
+        });
+
+        return length;
+    }
+
+    FoldParams FoldParamSmoother::getCurrent() const noexcept
+    {
+        FoldParams p;
+        p.drive = drive.getCurrent();
+        p.outGain = outGain.getCurrent();
+        p.biasPre = biasPre.getCurrent();
+        p.biasPost = biasPost.getCurrent();
+        p.threshold = threshold.getCurrent();
+        p.mix = mix.getCurrent();
+        return p;
+    }
+
+    FoldRamp FoldParamSmoother::getRamp() const noexcept
+    {
+        FoldRamp r;
+        r.driveRatio = drive.getStep();
+        r.outGainRatio = outGain.getStep();
+        r.biasPreDelta = biasPre.getStep();
+        r.biasPostDelta = biasPost.getStep();
+        r.thresholdDelta = threshold.getStep();
+        r.mixDelta = mix.getStep();
+        return r;
+    }
+
+    void FoldParamSmoother::skip (int numSamples) noexcept
+    {
+        forEachRamp ([numSamples] (ParameterRamp& r) { r.skip (numSamples); });
+    }
+}
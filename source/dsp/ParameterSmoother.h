@@ -0,0 +1,129 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "FoldFunctions.h"
+
+namespace FoldDSP
+{
+    //==============================================================================
+    /** A single linear or multiplicative parameter ramp with a fixed length.
+
+        Unlike juce::SmoothedValue this exposes the per-sample step and the number of
+        samples left, which is what the ramped kernels need to run a whole segment in one go.
+    */
+    class ParameterRamp
+    {
+    public:
+        enum class Mode
+        {
+            linear,
+            multiplicative  // Values must be > 0
+        };
+
+        explicit ParameterRamp (Mode rampMode) : mode (rampMode) {}
+
+        void setRampLength (int numSamples) noexcept { rampLength = juce::jmax (1, numSamples); }
+
+        void setCurrentAndTarget (float value) noexcept
+        {
+            current = target = value;
+            remaining = 0;
+        }
+
+        void setTarget (float value) noexcept
+        {
+            if (value == target)
+                return;
+
+            target = value;
+            remaining = rampLength;
+
+            if (mode == Mode::linear)
+                step = (target - current) / (float) remaining;
+            else
+                step = std::pow (target / current, 1.0f / (float) remaining);
+        }
+
+        bool isSmoothing() const noexcept { return remaining > 0; }
+        int getRemaining() const noexcept { return remaining; }
+        float getCurrent() const noexcept { return current; }
+        float getTarget() const noexcept { return target; }
+
+        /** Per-sample delta (linear) or ratio (multiplicative), identity when static. */
+        float getStep() const noexcept
+        {
+            if (remaining == 0)
+                return mode == Mode::linear ? 0.0f : 1.0f;
+
+            return step;
+        }
+
+        void skip (int numSamples) noexcept
+        {
+            if (numSamples >= remaining)
+            {
+                setCurrentAndTarget (target);
+                return;
+            }
+
+            remaining -= numSamples;
+            current = mode == Mode::linear ? current + step * (float) numSamples
+                                           : current * std::pow (step, (float) numSamples);
+        }
+
+    private:
+        Mode mode;
+        float current = 0.0f, target = 0.0f, step = 0.0f;
+        int remaining = 0, rampLength = 1;
+    };
+
+    //==============================================================================
+    /** Smooths every FoldParams field: gains multiplicatively, the rest linearly.
+
+        Static parameters cost nothing: when nothing is ramping isSmoothing() is false and
+        the caller keeps using the plain (specialised) kernels.
+    */
+    class FoldParamSmoother
+    {
+    public:
+        FoldParamSmoother() = default;
+
+        /** Sets the ramp time at the processing rate and jumps straight to `params`. */
+        void reset (double sampleRate, double rampSeconds, const FoldParams& params) noexcept;
+
+        void setTargets (const FoldParams& params) noexcept;
+
+        bool isSmoothing() const noexcept;
+
+        /** Longest segment (up to maxLength) over which no ramp reaches its target, so that
+            the whole segment can be processed with a single FoldRamp. */
+        int getSegmentLength (int maxLength) const noexcept;
+
+        FoldParams getCurrent() const noexcept;
+        FoldRamp getRamp() const noexcept;
+
+        void skip (int numSamples) noexcept;
+
+    private:
+        ParameterRamp drive { ParameterRamp::Mode::multiplicative };
+        ParameterRamp outGain { ParameterRamp::Mode::multiplicative };
+        ParameterRamp biasPre { ParameterRamp::Mode::linear };
+        ParameterRamp biasPost { ParameterRamp::Mode::linear };
+        ParameterRamp threshold { ParameterRamp::Mode::linear };
+        ParameterRamp mix { ParameterRamp::Mode::linear };
+
+        template <typename Fn>
+        void forEachRamp (Fn&& fn)
+        {
+            for (auto* r : { &drive, &outGain, &biasPre, &biasPost, &threshold, &mix })
+                fn (*r);
+        }
+
+        template <typename Fn>
+        void forEachRamp (Fn&& fn) const
+        {
+            for (auto* r : { &drive, &outGain, &biasPre, &biasPost, &threshold, &mix })
+                fn (*r);
+        }
+    };
+}
@@ -0,0 +1,242 @@
+#include "TransferLut.h"
+
+namespace FoldDSP
+{
+    //==============================================================================
+    // One low priority thread for every instance in the process
+    struct TransferLut::BuilderThread : public juce::TimeSliceThread
+    {
+        BuilderThread() : juce::TimeSliceThread ("Wavefolder LUT builder")
+        {
+            startThread (juce::Thread::Priority::low);
+        }
+
+        ~BuilderThread() override
+        {
+            stopThread (2000);
+        }
+    };
+
+    namespace
+    {
+        double exactChain (double x, FoldType type, const FoldParams& p) noexcept
+        {
+            const double u = (double) p.drive * (x + p.biasPre) + p.biasPost;
+            const double t = p.threshold;
+
+            double wet;
+            switch (type)
+            {
+                case FoldType::sinFold:   wet = Shapes::sinFold (u, t); break;
+                case FoldType::comboFold: wet = Shapes::comboFold (u, t); break;
+                case FoldType::foldToRange:
+                default:                  wet = Shapes::foldToRange (u, t); break;
+            }
+
+            return (double) p.outGain * ((double) p.mix * wet + (1.0 - (double) p.mix) * x);
+        }
+
+        template <typename SampleType>
+        inline SampleType hermite (SampleType y0, SampleType y1, SampleType y2, SampleType y3, SampleType frac) noexcept
+        {
+            const SampleType c1 = (SampleType) 0.5 * (y2 - y0);
+            const SampleType c2 = y0 - (SampleType) 2.5 * y1 + 2 * y2 - (SampleType) 0.5 * y3;
+            const SampleType c3 = (SampleType) 0.5 * (y3 - y0) + (SampleType) 1.5 * (y1 - y2);
+            return ((c3 * frac + c2) * frac + c1) * frac + y1;
+        }
+    }
+
+    //==============================================================================
+    TransferLut::~TransferLut()
+    {
+        setBuilding (false);
+    }
+
+    void TransferLut::setBuilding (bool shouldBuild)
+    {
+        if (shouldBuild == (builder != nullptr))
+            return;
+
+        if (shouldBuild)
+        {
+            builder = std::make_unique<juce::SharedResourcePointer<BuilderThread>>();
+            (*builder)->addTimeSliceClient (this);
+        }
+        else
+        {
+            // Blocks until a build in progress for this instance has finished
+            (*builder)->removeTimeSliceClient (this);
+            builder.reset();
+        }
+    }
+
+    void TransferLut::request (FoldType type, const FoldParams& params) noexcept
+    {
+        if (hasRequested && type == lastType && params == lastParams)
+            return;
+
+        lastType = type;
+        lastParams = params;
+        hasRequested = true;
+
+        requestedType.store ((int) type, std::memory_order_relaxed);
+        requestedDrive.store (params.drive, std::memory_order_relaxed);
+        requestedOutGain.store (params.outGain, std::memory_order_relaxed);
+        requestedBiasPre.store (params.biasPre, std::memory_order_relaxed);
+        requestedBiasPost.store (params.biasPost, std::memory_order_relaxed);
+        requestedThreshold.store (params.threshold, std::memory_order_relaxed);
+        requestedMix.store (params.mix, std::memory_order_relaxed);
+        dirty.store (true, std::memory_order_release);
+    }
+
+    const TransferLut::Table* TransferLut::acquire() noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & freshFlag) != 0)
+        {
+            front = middle.exchange (front, std::memory_order_acq_rel) & ~freshFlag;
+            hasTable = true;
+        }
+
+        return hasTable ? &tables[(size_t) front] : nullptr;
+    }
+
+    int TransferLut::useTimeSlice()
+    {
+        if (! dirty.exchange (false, std::memory_order_acquire))
+            return 20;
+
+        FoldParams params;
+        params.drive = requestedDrive.load (std::memory_order_relaxed);
+        params.outGain = requestedOutGain.load (std::memory_order_relaxed);
+        params.biasPre = requestedBiasPre.load (std::memory_order_relaxed);
+        params.biasPost = requestedBiasPost.load (std::memory_order_relaxed);
+        params.threshold = requestedThreshold.load (std::memory_order_relaxed);
+        params.mix = requestedMix.load (std::memory_order_relaxed);
+
+        auto& table = tables[(size_t) back];
+        build (table, (FoldType) requestedType.load (std::memory_order_relaxed), params);
+        lastMaxError.store (table.maxError, std::memory_order_relaxed);
+
+        // Publish, and take back whichever table was waiting in the middle
+        back = middle.exchange (back | freshFlag, std::memory_order_acq_rel) & ~freshFlag;
+        numBuilds.fetch_add (1, std::memory_order_release);
+
+        // If the settings moved on while building (e.g. automation), go again right away
+        return 0;
+    }
+
+    //==============================================================================
+    void TransferLut::build (Table& table, FoldType type, const FoldParams& params)
+    {
+        const double drive = juce::jmax (1.0e-6, (double) params.drive);
+        const double periodInX = 4.0 * params.threshold / drive;
+
+        // Enough points for every fold period inside the input range
+        const double numPeriods = 2.0 * inputRange / periodInX;
+        int size = juce::jlimit (minTableSize, maxTableSize, (int) std::ceil (numPeriods * pointsPerPeriod));
+        double step = 2.0 * inputRange / (size - 1);
+        double xMin = -inputRange;
+
+        table.linear = type == FoldType::foldToRange;
+
+        if (table.linear)
+        {
+            // The corners are at u = t + 2kt: put one on a node and divide the distance between
+            // two of them evenly, so the nodes are on every corner. At drives where that needs
+            // more than the largest table the corners fall in between, as with the other shapes
+            const double cornerSpacing = 0.5 * periodInX;
+            const double corner = ((double) params.threshold - (double) params.biasPost) / drive - (double) params.biasPre;
+            const double alignedStep = cornerSpacing / juce::jmax (1.0, std::ceil (minTableSize * cornerSpacing / (2.0 * inputRange)));
+            const double alignedMin = corner + std::floor ((-inputRange - corner) / alignedStep) * alignedStep;
+            const double alignedSize = std::ceil ((inputRange - alignedMin) / alignedStep) + 1.0;
+
+            if (alignedSize <= (double) maxTableSize)
+            {
+                size = (int) alignedSize;
+                step = alignedStep;
+                xMin = alignedMin;
+            }
+        }
+
+        table.values.resize ((size_t) size + 2);
+        table.xMin = (float) xMin;
+        table.invStep = (float) (1.0 / step);
+        table.type = type;
+        table.params = params;
+
+        for (int i = -1; i <= size; ++i)
+            table.values[(size_t) (i + 1)] = (float) exactChain (xMin + i * step, type, params);
+
+        // Interpolation error, probed between the nodes where it's largest
+        float maxError = 0.0f;
+        for (int i = 0; i < size - 1; ++i)
+        {
+            for (double frac : { 0.25, 0.5, 0.75 })
+            {
+                const double x = xMin + (i + frac) * step;
+                float y = (float) x;
+                process (table, &y, 1);
+                maxError = juce::jmax (maxError, (float) std::abs ((double) y - exactChain (x, type, params)));
+            }
+        }
+
+        table.maxError = maxError;
+    }
+
+    template <typename SampleType>
+    void TransferLut::process (const Table& table, SampleType* data, int numSamples) noexcept
+    {
+        const auto* values = table.values.data();
+        const int lastSegment = (int) table.values.size() - 4;
+
+        // A NaN never raises the peak, but turns the product with zero into a NaN (so does
+        // an infinity). Indexing the table with either would be undefined.
+        SampleType peak = 0, nonFinite = 0;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            peak = juce::jmax (peak, std::abs (data[i]));
+            nonFinite += data[i] * (SampleType) 0;
+        }
+
+        // Rare: something is outside the table, keep the branch out of the common loop
+        if (peak >= inputRange || nonFinite != (SampleType) 0)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                if (! (std::abs (data[i]) < inputRange))
+                    data[i] = (SampleType) exactChain (data[i], table.type, table.params);
+                else
+                    process (table, data + i, 1);
+            }
+
+            return;
+        }
+
+        // values[index + 1] is the node at or below x, thanks to the leading guard point
+        if (table.linear)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const SampleType position = (data[i] - table.xMin) * table.invStep;
+                const int index = juce::jlimit (0, lastSegment, (int) position);
+                const SampleType frac = position - (SampleType) index;
+
+                data[i] = values[index + 1] + frac * (values[index + 2] - values[index + 1]);
+            }
+
+            return;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const SampleType position = (data[i] - table.xMin) * table.invStep;
+            const int index = juce::jlimit (0, lastSegment, (int) position);
+            const SampleType frac = position - (SampleType) index;
+
+            data[i] = hermite<SampleType> (values[index], values[index + 1], values[index + 2], values[index + 3], frac);
+        }
+    }
+
+    template void TransferLut::process (const Table&, float*, int) noexcept;
+    template void TransferLut::process (const Table&, double*, int) noexcept;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "FoldFunctions.h"
+
+namespace FoldDSP
+{
+    //==============================================================================
+    /** The whole fold chain (bias, drive, fold shape, mix and output gain) baked into a
+        table, since for fixed settings it is a memoryless function of the input.
+
+        Lookups use cubic Hermite (Catmull-Rom) interpolation over a guarded input range,
+        samples outside of it are computed exactly. FoldToRange is piecewise linear instead,
+        and would ring at its corners: it gets a node on every corner and linear
+        interpolation, which is exact up to rounding.
+
+        Tables are rebuilt on a background thread shared by every instance whenever the
+        settings change, and handed over to the audio thread through a lock-free triple
+        buffer, so processBlock never waits: until the first table is ready, or after the
+        settings changed, it keeps using the last table it got (or nothing at all, in which
+        case the caller runs the exact path). Only instances with building switched on are
+        served by that thread, and it only runs while there is one.
+    */
+    class TransferLut : private juce::TimeSliceClient
+    {
+    public:
+        struct Table
+        {
+            std::vector<float> values;  // One guard point on each side of the range
+            float xMin = 0.0f, invStep = 0.0f;
+            FoldType type = FoldType::foldToRange;
+            FoldParams params;
+            bool linear = false;        // Linear interpolation, nodes on the corners
+            float maxError = 0.0f;      // Against the exact double precision chain
+        };
+
+        /** Inputs outside of +/- this are evaluated exactly. */
+        static constexpr float inputRange = 2.0f;
+
+        /** Table size bounds, the actual size follows the fold period (drive / threshold). */
+        static constexpr int minTableSize = 1024;
+        static constexpr int maxTableSize = 1 << 18;
+        static constexpr int pointsPerPeriod = 64;
+
+        TransferLut() = default;
+        ~TransferLut() override;
+
+        /** Joins or leaves the shared builder thread, starting it for the first instance
+            and stopping it after the last one. Requests made while off are built once it's
+            switched back on. Not for the audio thread: this takes the builder's lock, and
+            waits for a build in progress when switching off. */
+        void setBuilding (bool shouldBuild);
+
+        /** Audio thread: asks for a table for these settings, cheap if nothing changed. */
+        void request (FoldType type, const FoldParams& params) noexcept;
+
+        /** Audio thread: picks up the latest finished table, if any. The returned table stays
+            valid until the next call. Returns nullptr if no table has been built yet. */
+        const Table* acquire() noexcept;
+
+        /** Audio thread: applies a table in place. Defined for float and double, the table
+            itself is single precision so double buffers get float accuracy in this mode. */
+        template <typename SampleType>
+        static void process (const Table& table, SampleType* data, int numSamples) noexcept;
+
+        /** Max error of the most recently built table, for the UI and benchmarks. */
+        float getMaxError() const noexcept { return lastMaxError.load (std::memory_order_relaxed); }
+
+        /** Number of tables built so far, lets offline tools wait for the first one. */
+        int getNumBuilds() const noexcept { return numBuilds.load (std::memory_order_acquire); }
+
+        /** Builds a table synchronously, exposed for offline tools. */
+        static void build (Table& table, FoldType type, const FoldParams& params);
+
+    private:
+        int useTimeSlice() override;
+
+        //==============================================================================
+        // Triple buffer: the audio thread owns `front`, the builder owns `back`, and
+        // `middle` is exchanged between them with a flag saying it holds a fresh table
+        static constexpr int freshFlag = 4;
+
+        std::array<Table, 3> tables;
+        int front = 0, back = 1;
+        std::atomic<int> middle { 2 };
+        bool hasTable = false;
+
+        // Settings requested by the audio thread, read by the builder
+        std::atomic<int> requestedType { 0 };
+        std::atomic<float> requestedDrive { 1.0f }, requestedOutGain { 1.0f }, requestedBiasPre { 0.0f },
+            requestedBiasPost { 0.0f }, requestedThreshold { 0.7f }, requestedMix { 1.0f };
+        std::atomic<bool> dirty { false };
+
+        FoldType lastType = FoldType::foldToRange;
+        FoldParams lastParams;
+        bool hasRequested = false;
+
+        std::atomic<float> lastMaxError { 0.0f };
+        std::atomic<int> numBuilds { 0 };
+
+        struct BuilderThread;
+        std::unique_ptr<juce::SharedResourcePointer<BuilderThread>> builder;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransferLut)
+    };
+}
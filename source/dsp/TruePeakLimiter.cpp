@@ -0,0 +1,217 @@
+#include "TruePeakLimiter.h"
+
+namespace FoldDSP
+{
+    void TruePeakLimiter::prepare (int newNumChannels, double newSampleRate, bool doublePrecision)
+    {
+        numChannels = juce::jmax (1, newNumChannels);
+        sampleRate = newSampleRate;
+
+        // The interpolator reads its whole window from the delay line
+        lookahead = juce::jmax (tapsPerPhase, juce::roundToInt (lookaheadSeconds * sampleRate));
+        delay = lookahead - 1 + interpolatorDelay;
+        windowLength = delay + samplesPerChunk;
+
+        // Hann windowed sinc, each phase normalised to unity gain at DC
+        for (int p = 0; p < oversampling - 1; ++p)
+        {
+            auto& phase = phases[(size_t) p];
+            double sum = 0.0;
+
+            for (int k = 0; k < tapsPerPhase; ++k)
+            {
+                const double x = interpolatorCentre + (p + 1) / (double) oversampling - k;
+                const double sinc = juce::MathConstants<double>::pi * x;
+                const double window = 0.5 * (1.0 + std::cos (juce::MathConstants<double>::twoPi * x / tapsPerPhase));
+
+                phase[(size_t) k] = std::sin (sinc) / sinc * window;
+                sum += phase[(size_t) k];
+            }
+
+            for (auto& tap : phase)
+                tap /= sum;
+        }
+
+        const auto numWindowSamples = (size_t) (numChannels * windowLength);
+
+        if (doublePrecision)
+        {
+            doubleWindows.assign (numWindowSamples, 0.0);
+            floatWindows = {};
+        }
+        else
+        {
+            floatWindows.assign (numWindowSamples, 0.0f);
+            doubleWindows = {};
+        }
+
+        peaks.assign ((size_t) samplesPerChunk, 0.0f);
+        gains.assign ((size_t) samplesPerChunk, 1.0f);
+        holdValues.assign ((size_t) lookahead + 1, 1.0f);
+        holdPositions.assign ((size_t) lookahead + 1, 0);
+        averageHistory.assign ((size_t) lookahead, 1.0f);
+
+        // The release coefficient is for the old rate
+        const float release = releaseMs;
+        releaseMs = -1.0f;
+        setRelease (juce::jmax (0.0f, release));
+        reset();
+    }
+
+    void TruePeakLimiter::reset() noexcept
+    {
+        std::fill (floatWindows.begin(), floatWindows.end(), 0.0f);
+        std::fill (doubleWindows.begin(), doubleWindows.end(), 0.0);
+
+        holdFront = holdSize = 0;
+        position = 0;
+        envelope = 1.0f;
+
+        std::fill (averageHistory.begin(), averageHistory.end(), 1.0f);
+        averageIndex = 0;
+        averageSum = (double) averageHistory.size();
+    }
+
+    bool TruePeakLimiter::setCeiling (float ceilingDb) noexcept
+    {
+        const float newCeiling = juce::Decibels::decibelsToGain (ceilingDb);
+
+        if (newCeiling == ceiling)
+            return false;
+
+        ceiling = newCeiling;
+        return true;
+    }
+
+    bool TruePeakLimiter::setRelease (float newReleaseMs) noexcept
+    {
+        if (newReleaseMs == releaseMs)
+            return false;
+
+        // One pole reaching 1 - 1/e of the way after releaseMs
+        releaseMs = newReleaseMs;
+        releaseCoeff = (float) std::exp (-1.0 / juce::jmax (1.0, (double) releaseMs * 0.001 * sampleRate));
+        return true;
+    }
+
+    double TruePeakLimiter::getSettleSeconds() const noexcept
+    {
+        return std::log (1.0e6) * juce::jmax (0.0f, releaseMs) * 0.001 + delay / sampleRate;
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    void TruePeakLimiter::process (juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        auto& windows = getWindows<SampleType>();
+
+        if (windows.empty())
+            return;
+
+        const int numBlockChannels = juce::jmin ((int) block.getNumChannels(), numChannels);
+        const auto numSamples = (int) block.getNumSamples();
+
+        for (int start = 0; start < numSamples; start += samplesPerChunk)
+        {
+            const int length = juce::jmin (samplesPerChunk, numSamples - start);
+
+            // New input behind the delay line, and the peaks of every channel
+            std::fill (peaks.begin(), peaks.begin() + length, 0.0f);
+
+            for (int ch = 0; ch < numBlockChannels; ++ch)
+            {
+                auto* window = windows.data() + ch * windowLength;
+                std::copy_n (block.getChannelPointer ((size_t) ch) + start, length, window + delay);
+                detectPeaks (window, length);
+            }
+
+            computeGains (length);
+
+            // Delayed input times the gain, then the delay line moves along by the chunk
+            for (int ch = 0; ch < numBlockChannels; ++ch)
+            {
+                auto* window = windows.data() + ch * windowLength;
+                auto* data = block.getChannelPointer ((size_t) ch) + start;
+
+                for (int i = 0; i < length; ++i)
+                    data[i] = window[i] * (SampleType) gains[(size_t) i];
+
+                std::copy (window + length, window + length + delay, window);
+            }
+        }
+    }
+
+    template <typename SampleType>
+    void TruePeakLimiter::detectPeaks (const SampleType* window, int numSamples) noexcept
+    {
+        // Filter input, the newest sample of each window is the chunk's own
+        const auto* input = window + delay - (tapsPerPhase - 1);
+        std::array<SampleType, samplesPerChunk> interpolated;
+
+        for (int i = 0; i < numSamples; ++i)
+            peaks[(size_t) i] = juce::jmax (peaks[(size_t) i], (float) std::abs (input[i + interpolatorCentre]));
+
+        for (const auto& phase : phases)
+        {
+            std::fill (interpolated.begin(), interpolated.begin() + numSamples, SampleType());
+
+            for (int k = 0; k < tapsPerPhase; ++k)
+            {
+                const auto tap = (SampleType) phase[(size_t) k];
+
+                for (int i = 0; i < numSamples; ++i)
+                    interpolated[(size_t) i] += tap * input[i + k];
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+                peaks[(size_t) i] = juce::jmax (peaks[(size_t) i], (float) std::abs (interpolated[(size_t) i]));
+        }
+    }
+
+    void TruePeakLimiter::computeGains (int numSamples) noexcept
+    {
+        const auto capacity = (int) holdValues.size();
+
+        for (int i = 0; i < numSamples; ++i, ++position)
+        {
+            const float peak = peaks[(size_t) i];
+            const float target = peak > ceiling ? ceiling / peak : 1.0f;
+
+            // Lowest target over the lookahead: drop the ones it replaces and the one too old
+            while (holdSize > 0 && holdValues[(size_t) ((holdFront + holdSize - 1) % capacity)] >= target)
+                --holdSize;
+
+            const int back = (holdFront + holdSize++) % capacity;
+            holdValues[(size_t) back] = target;
+            holdPositions[(size_t) back] = position;
+
+            if (holdPositions[(size_t) holdFront] <= position - lookahead)
+            {
+                holdFront = (holdFront + 1) % capacity;
+                --holdSize;
+            }
+
+            // Straight down to the held gain, released back up. The envelope never goes above
+            // the held gain, so its average over the lookahead is at or below the target of
+            // the sample leaving the delay line.
+            const float held = holdValues[(size_t) holdFront];
+            envelope = held < envelope ? held : held + releaseCoeff * (envelope - held);
+
+            averageSum += envelope - averageHistory[(size_t) averageIndex];
+            averageHistory[(size_t) averageIndex] = envelope;
+
+            // Summed again from scratch once per lap, so rounding can't build up
+            if (++averageIndex == lookahead)
+            {
+                averageIndex = 0;
+                averageSum = std::accumulate (averageHistory.begin(), averageHistory.end(), 0.0);
+            }
+
+            gains[(size_t) i] = (float) (averageSum / lookahead);
+        }
+    }
+
+    //==============================================================================
+    template void TruePeakLimiter::process (juce::dsp::AudioBlock<float>&) noexcept;
+    template void TruePeakLimiter::process (juce::dsp::AudioBlock<double>&) noexcept;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+namespace FoldDSP
+{
+    //==============================================================================
+    /** Lookahead limiter on the true (inter-sample) peak, with the gain linked across
+        channels.
+
+        Each channel is upsampled 4x by a polyphase windowed-sinc interpolator, as in ITU-R
+        BS.1770, and the largest of every sample and the three values after it is its peak.
+        The gain that keeps the loudest channel under the ceiling is held for the lookahead
+        time and averaged over it, so it ramps down smoothly and reaches the target just as
+        the peak comes out of the delay line, and is released with a one-pole afterwards.
+
+        A block is processed in chunks, one stage over the whole chunk at a time: the
+        interpolation, the peak detection and the gain itself are vectorised along time per
+        channel, only the hold & release run sample by sample, once for every channel. The delay lines are
+        allocated in prepare(), in the precision the host processes with; process() must be
+        called with that type.
+    */
+    class TruePeakLimiter
+    {
+    public:
+        static constexpr int oversampling = 4;
+        static constexpr int tapsPerPhase = 12;
+        static constexpr double lookaheadSeconds = 0.0015;
+
+        TruePeakLimiter() = default;
+
+        void prepare (int numChannels, double sampleRate, bool doublePrecision = false);
+        void reset() noexcept;
+
+        /** Both return true if the setting changed. */
+        bool setCeiling (float ceilingDb) noexcept;
+        bool setRelease (float releaseMs) noexcept;
+
+        /** The lookahead plus the delay of the interpolator, at the processing rate. */
+        int getLatencySamples() const noexcept { return delay; }
+
+        /** Time for the gain to come back within 120 dB of where it's going once the peaks
+            are gone, the lookahead included. */
+        double getSettleSeconds() const noexcept;
+
+        template <typename SampleType>
+        void process (juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    private:
+        template <typename SampleType>
+        std::vector<SampleType>& getWindows() noexcept
+        {
+            if constexpr (std::is_same_v<SampleType, double>)
+                return doubleWindows;
+            else
+                return floatWindows;
+        }
+
+        template <typename SampleType>
+        void detectPeaks (const SampleType* window, int numSamples) noexcept;
+        void computeGains (int numSamples) noexcept;
+
+        // Samples per chunk, small enough for the scratch buffers to live on the stack
+        static constexpr int samplesPerChunk = 256;
+
+        // Sample the interpolated values follow, in the filter's window: the peaks lag the
+        // input by the rest of the window
+        static constexpr int interpolatorCentre = tapsPerPhase / 2 - 1;
+        static constexpr int interpolatorDelay = tapsPerPhase - 1 - interpolatorCentre;
+
+        int numChannels = 0, lookahead = 1, delay = 0, windowLength = 0;
+        double sampleRate = 44100.0;
+        float ceiling = 1.0f, releaseMs = -1.0f, releaseCoeff = 0.0f;
+
+        // Phases 1/4, 2/4 & 3/4 of the interpolator, phase 0 is the sample itself
+        std::array<std::array<double, tapsPerPhase>, oversampling - 1> phases {};
+
+        // Per channel: the last `delay` input samples, then the current chunk. The output is
+        // read from the start, the interpolator from the end. Only the host's precision is
+        // allocated
+        std::vector<float> floatWindows;
+        std::vector<double> doubleWindows;
+
+        // Loudest peak over the channels, then the gain, for each sample of the chunk
+        std::vector<float> peaks, gains;
+
+        // Gain computer: minimum of the target gains over the lookahead (a monotonic queue
+        // of values & positions), the released envelope and its running average
+        std::vector<float> holdValues;
+        std::vector<juce::int64> holdPositions;
+        int holdFront = 0, holdSize = 0;
+        juce::int64 position = 0;
+        float envelope = 1.0f;
+        std::vector<float> averageHistory;
+        int averageIndex = 0;
+        double averageSum = 0.0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TruePeakLimiter)
+    };
+}
@@ -0,0 +1,97 @@
+#include "LoadMeterComponent.h"
+
+#if WAVEFOLDER_PERF_METER
+
+namespace Perf
+{
+    LoadMeterComponent::LoadMeterComponent (BlockTimer& timerToRead) : blockTimer (timerToRead)
+    {
+        startTimerHz (15);
+    }
+
+    LoadMeterComponent::~LoadMeterComponent()
+    {
+        stopTimer();
+    }
+
+    void LoadMeterComponent::timerCallback()
+    {
+        float sum = 0.0f, max = 0.0f;
+        int count = 0;
+
+        for (;;)
+        {
+            const int numRead = blockTimer.pop (pending.data(), (int) pending.size());
+
+            for (int i = 0; i < numRead; ++i)
+            {
+                const auto& block = pending[(size_t) i];
+                sum += block.load;
+                max = juce::jmax (max, block.load);
+                worstLoad = block.worstLoad;
+                lastBlockMs = block.durationSeconds * 1000.0;
+                lastBlockSize = block.numSamples;
+            }
+
+            count += numRead;
+
+            if (numRead < (int) pending.size())
+                break;
+        }
+
+        if (count == 0)
+            return;
+
+        currentLoad = sum / (float) count;
+        peakLoad = juce::jmax (max, peakLoad * 0.9f);
+        repaint();
+    }
+
+    void LoadMeterComponent::mouseUp (const juce::MouseEvent&)
+    {
+        blockTimer.resetWorstCase();
+        worstLoad = peakLoad = 0.0f;
+        repaint();
+    }
+
+    void LoadMeterComponent::paint (juce::Graphics& g)
+    {
+        auto area = getLocalBounds().toFloat().reduced (2.0f);
+
+        const auto colourFor = [] (float load)
+        {
+            if (load >= riskLoad)
+                return juce::Colours::red;
+
+            if (load >= warningLoad)
+                return juce::Colours::orange;
+
+            return juce::Colours::limegreen;
+        };
+
+        // Xrun risk indicator, driven by the worst block
+        const auto indicator = area.removeFromLeft (area.getHeight()).reduced (3.0f);
+        g.setColour (colourFor (worstLoad));
+        g.fillEllipse (indicator);
+
+        // Load bar with a peak marker
+        auto bar = area.removeFromLeft (area.getWidth() * 0.3f).reduced (4.0f, 5.0f);
+        g.setColour (juce::Colours::white.withAlpha (0.15f));
+        g.fillRect (bar);
+        g.setColour (colourFor (currentLoad));
+        g.fillRect (bar.withWidth (bar.getWidth() * juce::jlimit (0.0f, 1.0f, currentLoad)));
+        g.setColour (juce::Colours::white);
+        g.fillRect (bar.getX() + bar.getWidth() * juce::jlimit (0.0f, 1.0f, peakLoad) - 1.0f, bar.getY(), 2.0f, bar.getHeight());
+
+        const auto percent = [] (float load) { return juce::String (load * 100.0f, 1) + "%"; };
+        const auto text = "CPU " + percent (currentLoad) + "  peak " + percent (peakLoad) + "  worst " + percent (worstLoad)
+                        + "  (" + juce::String (lastBlockMs, 3) + " ms / " + juce::String (lastBlockSize) + " smp)"
+                        + "  idle " + juce::String (blockTimer.getNumSkipped());
+
+        g.setColour (juce::Colours::white.withAlpha (0.8f));
+        g.setFont (12.0f);
+        g.drawFittedText (text, area.toNearestInt().withTrimmedLeft (4), juce::Justification::centredLeft, 1);
+    }
+}
+
+#endif
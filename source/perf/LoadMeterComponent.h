@@ -0,0 +1,44 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "PerfMeter.h"
+
+#if WAVEFOLDER_PERF_METER
+
+namespace Perf
+{
+    //==============================================================================
+    /** Editor strip showing the current and peak callback load, and how close the
+        worst block came to the buffer deadline. Click it to reset the worst case.
+    */
+    class LoadMeterComponent : public juce::Component,
+                               private juce::Timer
+    {
+    public:
+        explicit LoadMeterComponent (BlockTimer& timerToRead);
+        ~LoadMeterComponent() override;
+
+        void paint (juce::Graphics&) override;
+        void mouseUp (const juce::MouseEvent&) override;
+
+        /** Loads at which a block is flagged as getting close to the deadline. */
+        static constexpr float warningLoad = 0.5f;
+        static constexpr float riskLoad = 0.8f;
+
+    private:
+        void timerCallback() override;
+
+        BlockTimer& blockTimer;
+        std::array<BlockStats, 256> pending;
+
+        float currentLoad = 0.0f;   // Average over the last timer period
+        float peakLoad = 0.0f;      // Max over the last timer period, with a slow release
+        float worstLoad = 0.0f;     // Since the last reset, from the audio thread
+        double lastBlockMs = 0.0;
+        int lastBlockSize = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadMeterComponent)
+    };
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "PerfMeter.h"
+
+#if WAVEFOLDER_PERF_METER
+
+namespace Perf
+{
+    double getCycleCounterFrequency()
+    {
+        static const double frequency = []
+        {
+           #if JUCE_INTEL
+            // The TSC runs at a constant rate on anything recent, but that rate isn't
+            // exposed anywhere portable: measure it against steady_clock
+            using Clock = std::chrono::steady_clock;
+
+            const auto clockStart = Clock::now();
+            const auto ticksStart = readCycleCounter();
+
+            while (Clock::now() - clockStart < std::chrono::milliseconds (5))
+            {
+            }
+
+            const auto ticks = readCycleCounter() - ticksStart;
+            const auto seconds = std::chrono::duration<double> (Clock::now() - clockStart).count();
+            return (double) ticks / seconds;
+           #elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+            uint64_t counterFrequency;
+            asm volatile ("mrs %0, cntfrq_el0" : "=r" (counterFrequency));
+            return (double) counterFrequency;
+           #else
+            using Period = std::chrono::steady_clock::period;
+            return (double) Period::den / (double) Period::num;
+           #endif
+        }();
+
+        return frequency;
+    }
+
+    //==============================================================================
+    void BlockTimer::prepare (double newSampleRate)
+    {
+        secondsPerTick = 1.0 / getCycleCounterFrequency();
+        sampleRate = newSampleRate;
+        worstLoad = 0.0f;
+        numSkipped.store (0, std::memory_order_relaxed);
+    }
+
+    void BlockTimer::push (uint64_t durationTicks, int numSamples, bool skipped) noexcept
+    {
+        if (numSamples <= 0 || secondsPerTick == 0.0)
+            return;
+
+        if (skipped)
+            numSkipped.fetch_add (1, std::memory_order_relaxed);
+
+        if (resetRequested.exchange (false, std::memory_order_relaxed))
+            worstLoad = 0.0f;
+
+        BlockStats block;
+        block.durationSeconds = (double) durationTicks * secondsPerTick;
+        block.numSamples = numSamples;
+        block.skipped = skipped;
+        block.load = (float) (block.durationSeconds * sampleRate / numSamples);
+
+        worstLoad = juce::jmax (worstLoad, block.load);
+        block.worstLoad = worstLoad;
+
+        const auto scope = fifo.write (1);
+
+        if (scope.blockSize1 > 0)
+            stats[(size_t) scope.startIndex1] = block;
+        else
+            numDropped.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    int BlockTimer::pop (BlockStats* dest, int maxStats) noexcept
+    {
+        const auto scope = fifo.read (juce::jmin (maxStats, fifo.getNumReady()));
+        int numRead = 0;
+
+        scope.forEach ([&] (int index) { dest[numRead++] = stats[(size_t) index]; });
+        return numRead;
+    }
+}
+
+#endif
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/*  Audio callback instrumentation. Compiled into debug builds by default, and into
+    release builds only when WAVEFOLDER_PERF_METER=1 is defined (CMake option of the
+    same name), so shipping builds carry none of it.
+*/
+#if ! defined (WAVEFOLDER_PERF_METER)
+ #if JUCE_DEBUG
+  #define WAVEFOLDER_PERF_METER 1
+ #else
+  #define WAVEFOLDER_PERF_METER 0
+ #endif
+#endif
+
+#if WAVEFOLDER_PERF_METER
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace Perf
+{
+    //==============================================================================
+    /** A cheap monotonic tick counter: the TSC on x86, the virtual counter on 64-bit
+        ARM and steady_clock anywhere else. */
+    inline uint64_t readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return (uint64_t) __rdtsc();
+       #elif JUCE_ARM && JUCE_64BIT && ! JUCE_MSVC
+        uint64_t ticks;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (ticks));
+        return ticks;
+       #else
+        return (uint64_t) std::chrono::steady_clock::now().time_since_epoch().count();
+       #endif
+    }
+
+    /** Ticks per second of readCycleCounter(), measured once (takes a few ms the first time). */
+    double getCycleCounterFrequency();
+
+    //==============================================================================
+    /** Timing of one audio callback. */
+    struct BlockStats
+    {
+        double durationSeconds = 0.0;
+        int numSamples = 0;
+        float load = 0.0f;       // Duration / block budget, 1.0 = the whole callback
+        float worstLoad = 0.0f;  // Highest load since the last reset
+        bool skipped = false;    // Bypassed on silence
+    };
+
+    //==============================================================================
+    /** Times the audio callbacks and hands the results to the UI through a lock-free
+        single producer / single consumer FIFO: the audio thread pushes, one reader
+        (the editor) pops. When the reader falls behind blocks are dropped, but the
+        worst case is tracked on the audio side so it never gets lost.
+    */
+    class BlockTimer
+    {
+    public:
+        BlockTimer() = default;
+
+        /** Not real-time safe, measures the counter frequency on first use. */
+        void prepare (double sampleRate);
+
+        /** Audio thread. */
+        void push (uint64_t durationTicks, int numSamples, bool skipped) noexcept;
+
+        /** Reader thread: copies up to maxStats pending blocks, returns how many. */
+        int pop (BlockStats* dest, int maxStats) noexcept;
+
+        /** Reader thread: restarts the worst case tracking from the next block. */
+        void resetWorstCase() noexcept { resetRequested.store (true, std::memory_order_relaxed); }
+
+        int getNumDropped() const noexcept { return numDropped.load (std::memory_order_relaxed); }
+
+        /** Blocks bypassed on silence since prepare(). */
+        int64_t getNumSkipped() const noexcept { return numSkipped.load (std::memory_order_relaxed); }
+
+    private:
+        static constexpr int capacity = 1024;
+
+        juce::AbstractFifo fifo { capacity };
+        std::array<BlockStats, (size_t) capacity> stats;
+
+        double secondsPerTick = 0.0;
+        double sampleRate = 44100.0;
+        float worstLoad = 0.0f;
+
+        std::atomic<bool> resetRequested { false };
+        std::atomic<int> numDropped { 0 };
+        std::atomic<int64_t> numSkipped { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockTimer)
+    };
+
+    /** Times the enclosing scope as one audio callback of numSamples samples. */
+    class ScopedBlockTimer
+    {
+    public:
+        ScopedBlockTimer (BlockTimer& t, int numSamplesInBlock) noexcept
+            : timer (t), numSamples (numSamplesInBlock), start (readCycleCounter())
+        {
+        }
+
+        ~ScopedBlockTimer() noexcept { timer.push (readCycleCounter() - start, numSamples, skipped); }
+
+        void markSkipped() noexcept { skipped = true; }
+
+    private:
+        BlockTimer& timer;
+        const int numSamples;
+        const uint64_t start;
+        bool skipped = false;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlockTimer)
+    };
+}
+
+#endif
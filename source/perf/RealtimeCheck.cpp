@@ -0,0 +1,65 @@
+#include "RealtimeCheck.h"
+
+#if WAVEFOLDER_RT_CHECK
+
+namespace Perf
+{
+    namespace
+    {
+        // Plain ints, constant-initialised, so the hooks can read them from any thread at
+        // any time, even before static initialisation has run
+        thread_local int sectionDepth = 0;
+        thread_local int exemptionDepth = 0;
+
+        std::atomic<int> numViolations { 0 };
+
+        // Every violation is counted, the first ones are logged with their stack trace
+        constexpr int maxLoggedViolations = 20;
+    }
+
+    bool isInRealtimeSection() noexcept
+    {
+        return sectionDepth > 0 && exemptionDepth == 0;
+    }
+
+    void reportRealtimeViolation (const char* call) noexcept
+    {
+        const ScopedRealtimeExemption reporting ("Reporting a violation");
+        const int count = ++numViolations;
+
+        if (count <= maxLoggedViolations)
+        {
+            juce::Logger::writeToLog (juce::String ("Real-time violation #") + juce::String (count) + ": " + call
+                                      + " on the audio thread\n" + juce::SystemStats::getStackBacktrace());
+
+            if (count == maxLoggedViolations)
+                juce::Logger::writeToLog ("Further real-time violations are counted but not logged");
+        }
+
+        jassertfalse;
+    }
+
+    int getNumRealtimeViolations() noexcept
+    {
+        return numViolations.load();
+    }
+
+    void resetRealtimeViolations() noexcept
+    {
+        numViolations = 0;
+    }
+
+    //==============================================================================
+    ScopedRealtimeSection::ScopedRealtimeSection() noexcept { ++sectionDepth; }
+    ScopedRealtimeSection::~ScopedRealtimeSection() noexcept { --sectionDepth; }
+
+    ScopedRealtimeExemption::ScopedRealtimeExemption (const char* reason) noexcept
+    {
+        juce::ignoreUnused (reason);
+        ++exemptionDepth;
+    }
+
+    ScopedRealtimeExemption::~ScopedRealtimeExemption() noexcept { --exemptionDepth; }
+}
+
+#endif
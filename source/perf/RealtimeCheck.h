@@ -0,0 +1,64 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/*  Real-time safety checking of the audio callback. Compiled in only when
+    WAVEFOLDER_RT_CHECK=1 is defined, which the WavefolderRtCheck tool does for its own
+    build (see rtcheck/Main.cpp), so the plugin never carries it.
+
+    The processor marks its callback as a real-time section. The tool replaces the global
+    operator new/delete and, on Linux, malloc & co. and pthread_mutex_lock, and every one
+    of those calls made inside a section is reported: counted, logged with a stack trace
+    and asserted on.
+*/
+#if ! defined (WAVEFOLDER_RT_CHECK)
+ #define WAVEFOLDER_RT_CHECK 0
+#endif
+
+#if WAVEFOLDER_RT_CHECK
+
+namespace Perf
+{
+    //==============================================================================
+    /** True if the calling thread is inside a real-time section and not exempt. */
+    bool isInRealtimeSection() noexcept;
+
+    /** Counts the violation, logs it with a stack trace and asserts. The logging itself
+        allocates, the calling thread is exempt until it returns. */
+    void reportRealtimeViolation (const char* call) noexcept;
+
+    /** Called by the hooks before doing the real work. */
+    inline void checkRealtimeCall (const char* call) noexcept
+    {
+        if (isInRealtimeSection())
+            reportRealtimeViolation (call);
+    }
+
+    /** Violations on every thread since the last reset. */
+    int getNumRealtimeViolations() noexcept;
+    void resetRealtimeViolations() noexcept;
+
+    //==============================================================================
+    /** Marks the enclosing scope as real-time on the calling thread. Sections nest. */
+    class ScopedRealtimeSection
+    {
+    public:
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeSection)
+    };
+
+    /** Lets the enclosing scope allocate and lock inside a real-time section. Only for
+        calls made on purpose, the reason is there to be read next to the call. */
+    class ScopedRealtimeExemption
+    {
+    public:
+        explicit ScopedRealtimeExemption (const char* reason) noexcept;
+        ~ScopedRealtimeExemption() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeExemption)
+    };
+}
+
+#endif
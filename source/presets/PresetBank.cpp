@@ -0,0 +1,324 @@
+#include "PresetBank.h"
+
+namespace Presets
+{
+    //==============================================================================
+    /** Bank files as last read, by path, shared by every PresetBank of the process. A file
+        is parsed again only when its size or modification time changed, or after a bank
+        wrote it. Any thread, but never the audio thread: reading holds a lock. */
+    class PresetBank::UserBankCache
+    {
+    public:
+        struct Entry
+        {
+            juce::String name;
+            std::vector<std::pair<juce::String, float>> values;    // (parameter ID, normalised value)
+        };
+
+        struct Bank
+        {
+            juce::Time modified;
+            juce::int64 size = -1;
+            juce::Result result = juce::Result::ok();
+            std::vector<Entry> presets;
+        };
+
+        std::shared_ptr<const Bank> read (const juce::File& file)
+        {
+            const juce::ScopedLock sl (lock);
+            const auto modified = file.getLastModificationTime();
+            const auto size = file.existsAsFile() ? file.getSize() : -1;
+
+            auto& cached = banks[file.getFullPathName()];
+
+            if (cached == nullptr || cached->modified != modified || cached->size != size)
+                cached = parse (file, modified, size);
+
+            return cached;
+        }
+
+        void forget (const juce::File& file)
+        {
+            const juce::ScopedLock sl (lock);
+            banks.erase (file.getFullPathName());
+        }
+
+    private:
+        static std::shared_ptr<const Bank> parse (const juce::File& file, juce::Time modified, juce::int64 size)
+        {
+            auto bank = std::make_shared<Bank>();
+            bank->modified = modified;
+            bank->size = size;
+
+            if (size < 0)
+                return bank;
+
+            juce::FileInputStream input (file);
+
+            if (! input.openedOk())
+            {
+                bank->result = juce::Result::fail ("Can't open " + file.getFullPathName());
+                return bank;
+            }
+
+            if (input.readInt() != bankMagic || input.readInt() != bankVersion)
+            {
+                bank->result = juce::Result::fail (file.getFileName() + " is not a preset bank");
+                return bank;
+            }
+
+            const int numUserPresets = input.readInt();
+
+            for (int i = 0; i < numUserPresets && ! input.isExhausted(); ++i)
+            {
+                auto& preset = bank->presets.emplace_back();
+                preset.name = input.readString();
+
+                const int numValues = input.readInt();
+
+                for (int v = 0; v < numValues && ! input.isExhausted(); ++v)
+                {
+                    auto parameterId = input.readString();
+                    preset.values.emplace_back (std::move (parameterId), input.readFloat());
+                }
+            }
+
+            return bank;
+        }
+
+        juce::CriticalSection lock;
+        std::map<juce::String, std::shared_ptr<const Bank>> banks;
+    };
+
+    //==============================================================================
+    PresetBank::PresetBank (juce::AudioProcessor& processorToControl)
+        : parameters (processorToControl.getParameters()), numParameters (parameters.size())
+    {
+        names.resize ((size_t) maxPresets);
+        values.resize ((size_t) maxPresets * (size_t) numParameters);
+
+        for (auto* param : parameters)
+            rangedParameters.push_back (dynamic_cast<juce::RangedAudioParameter*> (param));
+    }
+
+    PresetBank::~PresetBank() = default;
+
+    //==============================================================================
+    void PresetBank::addFactoryPreset (const juce::String& name, std::initializer_list<std::pair<const char*, float>> plainValues)
+    {
+        jassert (numFactoryPresets == getNumPresets()); // Factory presets go before the user ones
+
+        const int index = append (name);
+
+        if (index < 0)
+            return;
+
+        auto* slot = getSlot (index);
+
+        for (const auto& [parameterId, plainValue] : plainValues)
+        {
+            const int p = getParameterIndex (parameterId);
+            jassert (p >= 0); // Unknown parameter ID
+
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameters[p]))
+                slot[p] = ranged->convertTo0to1 (plainValue);
+        }
+
+        numPresets.store (index + 1, std::memory_order_release);
+        numFactoryPresets = index + 1;
+    }
+
+    int PresetBank::addUserPreset (const juce::String& name)
+    {
+        const int index = append (name);
+
+        if (index < 0)
+            return -1;
+
+        auto* slot = getSlot (index);
+
+        for (int p = 0; p < numParameters; ++p)
+            slot[p] = parameters[p]->getValue();
+
+        numPresets.store (index + 1, std::memory_order_release);
+        return index;
+    }
+
+    int PresetBank::append (const juce::String& name) noexcept
+    {
+        const int index = getNumPresets();
+
+        if (index >= maxPresets)
+            return -1;
+
+        // The slot isn't published yet, the audio thread can't be reading it
+        names[(size_t) index] = name;
+        auto* slot = getSlot (index);
+
+        for (int p = 0; p < numParameters; ++p)
+            slot[p] = parameters[p]->getDefaultValue();
+
+        return index;
+    }
+
+    //==============================================================================
+    juce::String PresetBank::getName (int index) const
+    {
+        if (! juce::isPositiveAndBelow (index, getNumPresets()))
+            return {};
+
+        return names[(size_t) index];
+    }
+
+    void PresetBank::setName (int index, const juce::String& newName)
+    {
+        if (isUserPreset (index))
+            names[(size_t) index] = newName;
+    }
+
+    const float* PresetBank::getValues (int index) const noexcept
+    {
+        if (! juce::isPositiveAndBelow (index, getNumPresets()))
+            return nullptr;
+
+        return values.data() + (size_t) index * (size_t) numParameters;
+    }
+
+    void PresetBank::recall (int index, std::atomic<float>* const* rawValues) const noexcept
+    {
+        const auto* presetValues = getValues (index);
+
+        if (presetValues == nullptr)
+            return;
+
+        for (int p = 0; p < numParameters; ++p)
+            if (auto* ranged = rangedParameters[(size_t) p]; ranged != nullptr && rawValues[p] != nullptr)
+                rawValues[p]->store (ranged->convertFrom0to1 (presetValues[p]));
+    }
+
+    void PresetBank::apply (int index) const
+    {
+        const auto* presetValues = getValues (index);
+
+        if (presetValues == nullptr)
+            return;
+
+        for (int p = 0; p < numParameters; ++p)
+        {
+            auto* param = parameters[p];
+            const float value = presetValues[p];
+
+            if (param->getValue() == value)
+                continue;
+
+            param->setValue (value);
+            param->sendValueChangedMessageToListeners (value);
+        }
+    }
+
+    //==============================================================================
+    juce::Result PresetBank::loadUserBank (const juce::File& file)
+    {
+        // Drop the current user presets. Their slots stay allocated, and the audio thread
+        // only ever reads below the published count.
+        numPresets.store (numFactoryPresets, std::memory_order_release);
+
+        const auto bank = userBankCache->read (file);
+
+        for (const auto& preset : bank->presets)
+        {
+            const int index = append (preset.name);
+
+            if (index < 0)
+                return juce::Result::fail ("Too many presets in " + file.getFileName());
+
+            auto* slot = getSlot (index);
+
+            // Parameters that no longer exist are skipped, new ones keep their defaults
+            for (int v = 0; v < (int) preset.values.size(); ++v)
+            {
+                const auto& [parameterId, value] = preset.values[(size_t) v];
+
+                if (const int p = getParameterIndex (parameterId, v); p >= 0)
+                    slot[p] = juce::jlimit (0.0f, 1.0f, value);
+            }
+
+            numPresets.store (index + 1, std::memory_order_release);
+        }
+
+        return bank->result;
+    }
+
+    juce::Result PresetBank::saveUserBank (const juce::File& file) const
+    {
+        if (auto result = file.getParentDirectory().createDirectory(); result.failed())
+            return result;
+
+        // Written next to the bank and swapped in, so a failed save can't lose the old one
+        juce::TemporaryFile temp (file);
+        {
+            juce::FileOutputStream output (temp.getFile());
+
+            if (! output.openedOk())
+                return juce::Result::fail ("Can't write " + file.getFullPathName());
+
+            const int count = getNumPresets();
+
+            output.writeInt (bankMagic);
+            output.writeInt (bankVersion);
+            output.writeInt (count - numFactoryPresets);
+
+            for (int i = numFactoryPresets; i < count; ++i)
+            {
+                const auto* presetValues = getValues (i);
+
+                output.writeString (names[(size_t) i]);
+                output.writeInt (numParameters);
+
+                for (int p = 0; p < numParameters; ++p)
+                {
+                    auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameters[p]);
+                    output.writeString (withId != nullptr ? withId->paramID : juce::String (p));
+                    output.writeFloat (presetValues[p]);
+                }
+            }
+
+            output.flush();
+
+            if (output.getStatus().failed())
+                return output.getStatus();
+        }
+
+        if (! temp.overwriteTargetFileWithTemporary())
+            return juce::Result::fail ("Can't replace " + file.getFullPathName());
+
+        // Read again by the next bank that loads it, whatever the file system's time resolution
+        userBankCache->forget (file);
+
+        return juce::Result::ok();
+    }
+
+    juce::File PresetBank::getDefaultUserBankFile()
+    {
+        return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                   .getChildFile ("punkarra4")
+                   .getChildFile ("Wavefolder")
+                   .getChildFile ("UserPresets.wfbank");
+    }
+
+    //==============================================================================
+    int PresetBank::getParameterIndex (const juce::String& parameterId, int hint) const noexcept
+    {
+        if (juce::isPositiveAndBelow (hint, numParameters))
+            if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameters[hint]))
+                if (withId->paramID == parameterId)
+                    return hint;
+
+        for (int p = 0; p < numParameters; ++p)
+            if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameters[p]))
+                if (withId->paramID == parameterId)
+                    return p;
+
+        return -1;
+    }
+}
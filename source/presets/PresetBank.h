@@ -0,0 +1,102 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+namespace Presets
+{
+    //==============================================================================
+    /** Factory and user presets of a processor, exposed to the host as its programs.
+
+        Every preset is parsed once, when it is added or loaded, into one normalised value
+        per parameter in getParameters() order, so recalling one is a plain copy with no
+        parsing or allocation. Parameters a preset doesn't mention take their defaults.
+
+        All slots are allocated up front, in one block, and presets are only ever appended,
+        publishing the new count last: the audio thread can read the values of any preset
+        below getNumPresets() while the message thread adds more. Everything else is message
+        thread only.
+
+        User presets are kept in a binary bank file: a header, then per preset its name and
+        (parameter ID, normalised value) pairs, so presets survive parameters being added
+        or reordered. The file is read and parsed once per process and shared by every bank,
+        so a session with hundreds of instances doesn't read it hundreds of times.
+    */
+    class PresetBank
+    {
+    public:
+        static constexpr int maxPresets = 128;
+
+        explicit PresetBank (juce::AudioProcessor& processorToControl);
+        ~PresetBank();
+
+        //==============================================================================
+        /** Adds a factory preset from plain (not normalised) values by parameter ID, e.g.
+            the dB value of a gain or the index of a choice. Call these before loading the
+            user bank, factory presets always come first. */
+        void addFactoryPreset (const juce::String& name, std::initializer_list<std::pair<const char*, float>> plainValues);
+
+        /** Captures the current parameter values as a new user preset. Returns its index,
+            or -1 if the bank is full. */
+        int addUserPreset (const juce::String& name);
+
+        //==============================================================================
+        int getNumPresets() const noexcept { return numPresets.load (std::memory_order_acquire); }
+        int getNumFactoryPresets() const noexcept { return numFactoryPresets; }
+        bool isUserPreset (int index) const noexcept { return index >= numFactoryPresets && index < getNumPresets(); }
+
+        juce::String getName (int index) const;
+
+        /** Renames a user preset, factory presets keep their names. */
+        void setName (int index, const juce::String& newName);
+
+        /** Audio thread safe: the preset's normalised values, one per parameter, or nullptr
+            if there is no such preset. */
+        const float* getValues (int index) const noexcept;
+
+        /** Audio thread safe: writes the preset's plain values straight into the given raw
+            values, one per parameter in getParameters() order (e.g. the atomics returned by
+            AudioProcessorValueTreeState::getRawParameterValue). The parameters themselves
+            aren't touched, follow up with apply() on the message thread. */
+        void recall (int index, std::atomic<float>* const* rawValues) const noexcept;
+
+        /** Sets every parameter to the preset's values, notifying the host and listeners the
+            same way automation does. Message thread only: JUCE notifies under its listener
+            locks. Parameters already at the preset's values are left alone. */
+        void apply (int index) const;
+
+        //==============================================================================
+        /** Replaces the user presets with the ones in the file, a missing file being an empty
+            bank. The file is only read again if it changed since any bank of this process
+            last read or wrote it. Their slots are reused, so don't call this while the audio
+            thread may be recalling a user preset: load the bank before playback starts. */
+        juce::Result loadUserBank (const juce::File& file);
+        juce::Result saveUserBank (const juce::File& file) const;
+
+        /** Where the plugin keeps its user presets. */
+        static juce::File getDefaultUserBankFile();
+
+    private:
+        class UserBankCache;
+
+        int append (const juce::String& name) noexcept;
+        float* getSlot (int index) noexcept { return values.data() + (size_t) index * (size_t) numParameters; }
+
+        /** Tries the parameter at hint first: banks are written in parameter order. */
+        int getParameterIndex (const juce::String& parameterId, int hint = -1) const noexcept;
+
+        const juce::Array<juce::AudioProcessorParameter*>& parameters;
+        const int numParameters;
+        std::vector<juce::RangedAudioParameter*> rangedParameters;     // nullptr if not ranged
+        std::vector<juce::String> names;    // maxPresets slots
+        std::vector<float> values;          // maxPresets slots of numParameters values
+        std::atomic<int> numPresets { 0 };
+        int numFactoryPresets = 0;
+
+        juce::SharedResourcePointer<UserBankCache> userBankCache;
+
+        static constexpr int bankMagic = 0x42504657; // "WFPB"
+        static constexpr int bankVersion = 1;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+    };
+}
@@ -0,0 +1,757 @@
+/*  Headless tests of the fold kernels against the scalar reference, and of the processor
+    around them, registered with CTest:
+
+        WavefolderTests
+
+    The reference is punk_dsp::Wavefolder, the implementation the plugin started from and
+    whose FoldToRange / SinFold / ComboFold the kernels are a port of. It only folds floats,
+    so the double precision kernels are checked against the same chain on FoldDSP::Shapes,
+    which are in turn checked against punk_dsp ("shapes" below).
+
+    The shapes are checked first:
+      - "shapes":   FoldDSP::Shapes against punk_dsp, over a sweep of u and thresholds
+      - "adaa":     the ADAA antiderivatives, differentiated numerically, against
+                    punk_dsp's shapes (AD1) and against AD1 (AD2)
+
+    then every kernel table compiled into this binary and supported by the CPU, the scalar
+    one included, in both precisions:
+      - "static":   every fold type, bias and mix specialisation over a sweep of drive,
+                    bias, threshold and mix settings, with ragged block tails
+      - "ramped":   the kernels used while smoothing, every parameter ramping at once
+      - "blended":  the morph / crossfade kernels, static and ramped
+      - "streams":  the multi-stream kernels, static and ramped, with mixed fold types
+
+    The ramps are reproduced in the order the kernels step them, so the reference sees the
+    exact settings the kernel did and the same bound holds at the end of a ramp as at its
+    start.
+
+    Then the processor, in float:
+      - "lut ramp": drive automated with LUT mode on, against the same automation with it
+                    off. The table of the new drive is ready long before the ramp is over,
+                    the output has to follow the ramp instead of stepping to the table.
+
+    An error is measured in ULPs of what the sample can be trusted to: the rounding of
+    u = drive * (x + biasPre) + biasPost through the steepest slope of the shapes (pi / 2,
+    SinFold at its zero crossings), plus the output full scale. Anything above
+    toleranceUlps fails. The tests are built and run in every build type, and exit with 1
+    on any failure so CI stops there.
+*/
+
+#include "PluginProcessor.h"
+#include "dsp/FoldKernels.h"
+
+#include "punk_dsp/punk_dsp.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    using namespace FoldDSP;
+    using namespace FoldDSP::Kernels;
+
+    constexpr float toleranceUlps = 8.0f;
+
+    constexpr FoldType allFoldTypes[] = { FoldType::foldToRange, FoldType::sinFold, FoldType::comboFold };
+
+    //==============================================================================
+    template <typename SampleType>
+    SampleType ulp (SampleType x) noexcept
+    {
+        x = std::abs (x);
+        return std::nextafter (x, std::numeric_limits<SampleType>::max()) - x;
+    }
+
+    // Deterministic noise so a failing sweep can be reproduced
+    struct Lcg
+    {
+        uint32_t state = 0x12345678u;
+
+        float next() noexcept
+        {
+            state = state * 1664525u + 1013904223u;
+            return (float) (state >> 8) / 8388608.0f - 1.0f;
+        }
+    };
+
+    /** Largest error of one check, and whether anything else went wrong in it. */
+    struct CheckResult
+    {
+        float maxUlpError = 0.0f;
+        bool passed = true;
+
+        void add (double error, double unit) noexcept
+        {
+            maxUlpError = std::max (maxUlpError, (float) (error / unit));
+        }
+    };
+
+    /** Settings of one sample, in the precision the kernels compute them in. */
+    template <typename SampleType>
+    struct ChainSettings
+    {
+        SampleType drive, outGain, biasPre, biasPost, threshold, mix;
+
+        ChainSettings (const FoldParams& p = {}) noexcept
+            : drive (p.drive), outGain (p.outGain), biasPre (p.biasPre), biasPost (p.biasPost), threshold (p.threshold), mix (p.mix)
+        {
+        }
+    };
+
+    /** Tolerance of one output sample, see the comment at the top. */
+    template <typename SampleType>
+    SampleType getUnit (SampleType x, const ChainSettings<SampleType>& s, SampleType expected)
+    {
+        // Largest intermediate of u, which bounds its rounding whatever the order of the terms
+        const SampleType uMagnitude = std::abs (s.drive * (std::abs (x) + std::abs (s.biasPre))) + std::abs (s.biasPost);
+
+        return ulp (uMagnitude) * (SampleType) Shapes::maxSlope * std::abs (s.outGain * s.mix)
+               + ulp (std::max (std::abs (expected), std::abs (s.outGain * s.threshold)));
+    }
+
+    //==============================================================================
+    /** The scalar reference, one sample at a time. */
+    class Reference
+    {
+    public:
+        /** Full chain with the settings of one sample. */
+        template <typename SampleType>
+        SampleType process (FoldType type, const ChainSettings<SampleType>& s, SampleType x)
+        {
+            if constexpr (std::is_same_v<SampleType, float>)
+            {
+                setSettings (s);
+
+                switch (type)
+                {
+                    case FoldType::sinFold:   return wavefolder.foldSinSample (x);
+                    case FoldType::comboFold: return wavefolder.comboFoldSample (x);
+                    default:                  return wavefolder.foldToRangeSample (x);
+                }
+            }
+            else
+            {
+                const double u = s.drive * (x + s.biasPre) + s.biasPost;
+                return s.outGain * s.mix * getShape (type, u, s.threshold) + s.outGain * (1 - s.mix) * x;
+            }
+        }
+
+        /** Full chain with a blend of the triangle and sine folds, which punk_dsp has no
+            function for: its two wet signals are weighted, then mixed as in the kernels. */
+        template <typename SampleType>
+        SampleType process (SampleType triangleWeight, SampleType sineWeight, const ChainSettings<SampleType>& s, SampleType x)
+        {
+            if (triangleWeight == sineWeight && triangleWeight == (SampleType) 0.5)
+                return process (FoldType::comboFold, s, x);
+
+            ChainSettings<SampleType> wetOnly = s;
+            wetOnly.outGain = 1;
+            wetOnly.mix = 1;
+
+            const SampleType wet = triangleWeight * process (FoldType::foldToRange, wetOnly, x)
+                                   + sineWeight * process (FoldType::sinFold, wetOnly, x);
+
+            return s.outGain * s.mix * wet + s.outGain * (1 - s.mix) * x;
+        }
+
+        /** The fold shape alone, as punk_dsp computes it. */
+        float foldShape (FoldType type, float u, float threshold)
+        {
+            const FoldParams shapeOnly { 1.0f, 1.0f, 0.0f, 0.0f, threshold, 1.0f };
+            return process (type, ChainSettings<float> (shapeOnly), u);
+        }
+
+        static double getShape (FoldType type, double u, double threshold) noexcept
+        {
+            switch (type)
+            {
+                case FoldType::sinFold:   return Shapes::sinFold (u, threshold);
+                case FoldType::comboFold: return Shapes::comboFold (u, threshold);
+                default:                  return Shapes::foldToRange (u, threshold);
+            }
+        }
+
+    private:
+        void setSettings (const ChainSettings<float>& s)
+        {
+            wavefolder.setDrive (s.drive);
+            wavefolder.setOutGain (s.outGain);
+            wavefolder.setBiasPre (s.biasPre);
+            wavefolder.setBiasPost (s.biasPost);
+            wavefolder.setThreshold (s.threshold);
+            wavefolder.setMix (s.mix);
+        }
+
+        punk_dsp::Wavefolder wavefolder;
+    };
+
+    //==============================================================================
+    /** value + j * delta, as the kernels set up lane j of a linear ramp. */
+    template <typename SampleType>
+    SampleType getLinearLane (SampleType value, SampleType delta, int j) noexcept
+    {
+        return value + (SampleType) j * delta;
+    }
+
+    /** The settings of every sample along a ramp, stepped in the same order as the kernels
+        of the given vector width step them (see FoldKernelBody::RampLanes): lane j starts
+        j steps along the ramp, and every vector moves all lanes on by `width` steps, the
+        gains by a ratio that is the product of `width` ratios. The reference then sees the
+        same settings as the kernel, so its error doesn't grow along the ramp. */
+    template <typename SampleType>
+    std::vector<ChainSettings<SampleType>> getRampSettings (const FoldParams& start, const FoldRamp& ramp, int width, int numSamples)
+    {
+        std::vector<ChainSettings<SampleType>> lanes ((size_t) width);
+        SampleType driveValue = start.drive, outGainValue = start.outGain;
+        SampleType driveStep = 1, outGainStep = 1;
+
+        for (int j = 0; j < width; ++j)
+        {
+            auto& lane = lanes[(size_t) j];
+            lane.drive = driveValue;
+            lane.outGain = outGainValue;
+            lane.biasPre = getLinearLane<SampleType> (start.biasPre, ramp.biasPreDelta, j);
+            lane.biasPost = getLinearLane<SampleType> (start.biasPost, ramp.biasPostDelta, j);
+            lane.threshold = getLinearLane<SampleType> (start.threshold, ramp.thresholdDelta, j);
+            lane.mix = getLinearLane<SampleType> (start.mix, ramp.mixDelta, j);
+
+            driveValue *= ramp.driveRatio;
+            outGainValue *= ramp.outGainRatio;
+            driveStep *= ramp.driveRatio;
+            outGainStep *= ramp.outGainRatio;
+        }
+
+        std::vector<ChainSettings<SampleType>> settings ((size_t) numSamples);
+
+        for (int i = 0; i < numSamples; i += width)
+        {
+            for (int j = 0; j < width; ++j)
+            {
+                auto& lane = lanes[(size_t) j];
+
+                if (i + j < numSamples)
+                    settings[(size_t) (i + j)] = lane;
+
+                lane.drive *= driveStep;
+                lane.outGain *= outGainStep;
+                lane.biasPre += (SampleType) width * ramp.biasPreDelta;
+                lane.biasPost += (SampleType) width * ramp.biasPostDelta;
+                lane.threshold += (SampleType) width * ramp.thresholdDelta;
+                lane.mix += (SampleType) width * ramp.mixDelta;
+            }
+        }
+
+        return settings;
+    }
+
+    //==============================================================================
+    CheckResult checkShapes()
+    {
+        Reference reference;
+        CheckResult result;
+
+        for (float threshold : { 0.05f, 0.3f, 0.7f, 1.0f })
+        {
+            for (int i = -4000; i <= 4000; ++i)
+            {
+                const float u = (float) i * 0.002f + 0.000123f;
+
+                for (auto type : allFoldTypes)
+                {
+                    const float expected = reference.foldShape (type, u, threshold);
+                    const double actual = Reference::getShape (type, u, threshold);
+                    const double unit = (double) ulp (u) * Shapes::maxSlope + (double) ulp (threshold);
+
+                    result.add (std::abs (actual - (double) expected), unit);
+                }
+            }
+        }
+
+        result.passed = result.maxUlpError <= toleranceUlps;
+        return result;
+    }
+
+    CheckResult checkAntiderivatives()
+    {
+        Reference reference;
+        CheckResult result;
+
+        // Central differences: with this step their own error stays far below a float ulp
+        constexpr double h = 1.0e-5;
+
+        const auto derivative = [h] (auto&& antiderivative, double u) { return (antiderivative (u + h) - antiderivative (u - h)) / (2.0 * h); };
+
+        for (float threshold : { 0.05f, 0.3f, 0.7f, 1.0f })
+        {
+            for (int i = -4000; i <= 4000; ++i)
+            {
+                const float u = (float) i * 0.002f + 0.000123f;
+
+                // The triangle's corners sit on odd multiples of t, where f has no derivative
+                const double corner = (double) threshold * (2.0 * std::floor (u / (2.0 * threshold)) + 1.0);
+                if (std::abs (u - corner) < 2.0 * h || std::abs (u - corner + 2.0 * threshold) < 2.0 * h)
+                    continue;
+
+                const double unit = (double) ulp (u) * Shapes::maxSlope + (double) ulp (threshold);
+
+                for (auto type : allFoldTypes)
+                {
+                    const auto blend = getShapeBlend (type);
+                    const BlendedShape shape { blend.triangle, blend.sine };
+
+                    const double ad1Slope = derivative ([&] (double v) { return shape.ad1 (v, threshold); }, u);
+                    const double ad2Slope = derivative ([&] (double v) { return shape.ad2 (v, threshold); }, u);
+
+                    result.add (std::abs (ad1Slope - (double) reference.foldShape (type, u, threshold)), unit);
+                    result.add (std::abs (ad2Slope - shape.ad1 (u, threshold)), unit);
+                }
+            }
+
+            // Anchored at F(0) = 0, which the ADAA kernels rely on
+            if (Shapes::foldToRangeAD1 (0.0, threshold) != 0.0 || Shapes::sinFoldAD1 (0.0, threshold) != 0.0
+                || std::abs (Shapes::foldToRangeAD2 (0.0, threshold)) > 1.0e-15 || Shapes::sinFoldAD2 (0.0, threshold) != 0.0)
+                result.passed = false;
+        }
+
+        result.passed = result.passed && result.maxUlpError <= toleranceUlps;
+        return result;
+    }
+
+    template <typename SampleType>
+    CheckResult checkStaticKernels (const KernelTable& table)
+    {
+        Reference reference;
+        CheckResult result;
+
+        // Odd length, so every path also goes through its ragged tail
+        constexpr int numSamples = 203;
+        std::vector<SampleType> input ((size_t) numSamples), actual ((size_t) numSamples);
+
+        Lcg noise;
+        for (auto& x : input)
+            x = (SampleType) 1.5 * noise.next();
+
+        for (float driveDb : { -30.0f, 0.0f, 12.0f, 24.0f, 48.0f, 60.0f })
+            for (float bias : { -1.0f, 0.0f, 0.37f })
+                for (float threshold : { 0.05f, 0.3f, 0.7f, 1.0f })
+                    for (float mix : { 0.0f, 0.5f, 1.0f })
+                        for (auto type : allFoldTypes)
+                        {
+                            FoldParams p;
+                            p.drive = std::pow (10.0f, driveDb / 20.0f);
+                            p.outGain = 0.5f;
+                            p.biasPre = bias;
+                            p.biasPost = -0.5f * bias;
+                            p.threshold = threshold;
+                            p.mix = mix;
+
+                            actual = input;
+                            table.select<SampleType> (type, p) (actual.data(), numSamples, p);
+
+                            for (size_t i = 0; i < (size_t) numSamples; ++i)
+                            {
+                                const ChainSettings<SampleType> settings (p);
+                                const SampleType expected = reference.process (type, settings, input[i]);
+                                result.add (std::abs (actual[i] - expected), getUnit (input[i], settings, expected));
+                            }
+                        }
+
+        result.passed = result.maxUlpError <= toleranceUlps;
+        return result;
+    }
+
+    //==============================================================================
+    /** Every parameter smoothed at once towards the other end of its range. */
+    FoldRamp getTestRamp() noexcept
+    {
+        FoldRamp ramp;
+        ramp.driveRatio = 1.002f;
+        ramp.outGainRatio = 0.999f;
+        ramp.biasPreDelta = 0.002f;
+        ramp.biasPostDelta = -0.001f;
+        ramp.thresholdDelta = 0.002f;
+        ramp.mixDelta = 0.001f;
+        return ramp;
+    }
+
+    FoldParams getRampStart (float drive) noexcept
+    {
+        FoldParams start;
+        start.drive = drive;
+        start.outGain = 0.5f;
+        start.biasPre = -0.2f;
+        start.biasPost = 0.1f;
+        start.threshold = 0.3f;
+        start.mix = 0.8f;
+        return start;
+    }
+
+    template <typename SampleType>
+    std::vector<SampleType> getTestInput (int numSamples)
+    {
+        std::vector<SampleType> input ((size_t) numSamples);
+
+        Lcg noise;
+        for (auto& x : input)
+            x = (SampleType) 1.5 * noise.next();
+
+        return input;
+    }
+
+    template <typename SampleType>
+    CheckResult checkRampedKernels (const KernelTable& table)
+    {
+        Reference reference;
+        CheckResult result;
+
+        constexpr int numSamples = 203;
+        const auto input = getTestInput<SampleType> (numSamples);
+        std::vector<SampleType> actual;
+
+        for (auto type : allFoldTypes)
+        {
+            for (float driveDb : { 0.0f, 24.0f, 48.0f })
+            {
+                const auto start = getRampStart (std::pow (10.0f, driveDb / 20.0f));
+                const auto ramp = getTestRamp();
+                const auto settings = getRampSettings<SampleType> (start, ramp, table.getWidth<SampleType>(), numSamples);
+
+                actual = input;
+                table.getRamped<SampleType> (type) (actual.data(), numSamples, start, ramp);
+
+                for (size_t i = 0; i < (size_t) numSamples; ++i)
+                {
+                    const SampleType expected = reference.process (type, settings[i], input[i]);
+                    result.add (std::abs (actual[i] - expected), getUnit (input[i], settings[i], expected));
+                }
+            }
+        }
+
+        result.passed = result.maxUlpError <= toleranceUlps;
+        return result;
+    }
+
+    /** Blends crossfading between two types, and a ComboFold blend, which must match
+        punk_dsp's ComboFold, with the parameters static and ramped. */
+    template <typename SampleType>
+    CheckResult checkBlendedKernels (const KernelTable& table)
+    {
+        Reference reference;
+        CheckResult result;
+
+        constexpr int numSamples = 203;
+        const auto input = getTestInput<SampleType> (numSamples);
+        const int width = table.getWidth<SampleType>();
+        std::vector<SampleType> actual;
+
+        for (bool paramsRamping : { false, true })
+        {
+            const auto start = getRampStart (4.0f);
+            const auto ramp = paramsRamping ? getTestRamp() : FoldRamp();
+            const auto settings = getRampSettings<SampleType> (start, ramp, width, numSamples);
+
+            const ShapeBlend crossfade { 1.0f, 0.0f, -1.0f / (float) numSamples, 0.5f / (float) numSamples };
+
+            for (const auto& blend : { crossfade, getShapeBlend (FoldType::comboFold) })
+            {
+                actual = input;
+                table.getBlended<SampleType> (paramsRamping) (actual.data(), numSamples, start, ramp, blend);
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    // The weights are stepped like the linear parameters
+                    const int lane = i % width;
+                    const int numSteps = i / width;
+
+                    SampleType triangleWeight = getLinearLane<SampleType> (blend.triangle, blend.triangleDelta, lane);
+                    SampleType sineWeight = getLinearLane<SampleType> (blend.sine, blend.sineDelta, lane);
+
+                    for (int step = 0; step < numSteps; ++step)
+                    {
+                        triangleWeight += (SampleType) width * blend.triangleDelta;
+                        sineWeight += (SampleType) width * blend.sineDelta;
+                    }
+
+                    const auto& s = settings[(size_t) i];
+                    const SampleType expected = reference.process (triangleWeight, sineWeight, s, input[(size_t) i]);
+                    result.add (std::abs (actual[(size_t) i] - expected), getUnit (input[(size_t) i], s, expected));
+                }
+            }
+        }
+
+        result.passed = result.maxUlpError <= toleranceUlps;
+        return result;
+    }
+
+    /** Two vectors of streams with settings that differ per lane, in frames with some unused
+        padding, static and ramped, for every fold type and for mixed types. Each stream steps
+        its own settings once per frame, as the reference below does. */
+    template <typename SampleType>
+    CheckResult checkStreamKernels (const KernelTable& table)
+    {
+        Reference reference;
+        CheckResult result;
+
+        constexpr int numSamples = 203;
+        const auto input = getTestInput<SampleType> (numSamples);
+
+        const int width = table.getWidth<SampleType>();
+        const int numStreams = 2 * width;
+        const int frameStride = numStreams + 3;
+
+        std::vector<FoldParams> params ((size_t) numStreams);
+        std::vector<FoldRamp> ramps ((size_t) numStreams);
+        std::vector<FoldType> types ((size_t) numStreams);
+
+        std::vector<SampleType> fields[8], stepFields[6];
+        for (auto& field : fields)
+            field.resize ((size_t) frameStride);
+        for (auto& field : stepFields)
+            field.resize ((size_t) frameStride);
+
+        std::vector<SampleType> frames ((size_t) (numSamples * frameStride));
+
+        Lcg noise;
+
+        for (int typeIndex = 0; typeIndex <= mixedFoldTypes; ++typeIndex)
+        {
+            for (bool ramped : { false, true })
+            {
+                for (int s = 0; s < numStreams; ++s)
+                {
+                    auto& p = params[(size_t) s];
+                    p.drive = std::pow (10.0f, (float) (s % 7) * 10.0f / 20.0f);
+                    p.outGain = 0.5f + 0.1f * (float) (s % 3);
+                    p.biasPre = 0.37f * noise.next();
+                    p.biasPost = 0.5f * noise.next();
+                    p.threshold = 0.05f + 0.95f * (float) (s % 5) / 4.0f;
+                    p.mix = (float) (s % 3) / 2.0f;
+
+                    auto& r = ramps[(size_t) s];
+                    r = {};
+
+                    if (ramped && s % 2 == 0)
+                    {
+                        r = getTestRamp();
+                        r.mixDelta = p.mix > 0.5f ? -0.001f : 0.001f;
+                    }
+
+                    types[(size_t) s] = typeIndex == mixedFoldTypes ? (FoldType) (s % 3) : (FoldType) typeIndex;
+
+                    const auto blend = getShapeBlend (types[(size_t) s]);
+
+                    const SampleType values[] = { p.drive, p.outGain, p.biasPre, p.biasPost, p.threshold, p.mix, blend.triangle, blend.sine };
+                    for (size_t f = 0; f < 8; ++f)
+                        fields[f][(size_t) s] = values[f];
+
+                    const SampleType steps[] = { r.driveRatio, r.outGainRatio, r.biasPreDelta, r.biasPostDelta, r.thresholdDelta, r.mixDelta };
+                    for (size_t f = 0; f < 6; ++f)
+                        stepFields[f][(size_t) s] = steps[f];
+                }
+
+                const auto getInput = [&input] (int i, int s) { return input[(size_t) ((i + 7 * s) % numSamples)]; };
+
+                for (int i = 0; i < numSamples; ++i)
+                    for (int s = 0; s < frameStride; ++s)
+                        frames[(size_t) (i * frameStride + s)] = getInput (i, s);
+
+                const StreamParams<SampleType> streamParams { fields[0].data(), fields[1].data(), fields[2].data(), fields[3].data(),
+                                                              fields[4].data(), fields[5].data(), fields[6].data(), fields[7].data() };
+                const StreamSteps<SampleType> streamSteps { stepFields[0].data(), stepFields[1].data(), stepFields[2].data(),
+                                                            stepFields[3].data(), stepFields[4].data(), stepFields[5].data() };
+
+                for (int first = 0; first < numStreams; first += width)
+                {
+                    if (ramped)
+                        table.getRampedStreams<SampleType> (typeIndex) (frames.data(), numSamples, frameStride, first, streamParams, streamSteps);
+                    else
+                        table.getStreams<SampleType> (typeIndex) (frames.data(), numSamples, frameStride, first, streamParams);
+                }
+
+                for (int s = 0; s < numStreams; ++s)
+                {
+                    ChainSettings<SampleType> settings (params[(size_t) s]);
+                    const auto& r = ramps[(size_t) s];
+
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        const SampleType x = getInput (i, s);
+                        const SampleType expected = reference.process (types[(size_t) s], settings, x);
+                        const SampleType actual = frames[(size_t) (i * frameStride + s)];
+                        result.add (std::abs (actual - expected), getUnit (x, settings, expected));
+
+                        if (ramped)
+                        {
+                            settings.drive *= (SampleType) r.driveRatio;
+                            settings.outGain *= (SampleType) r.outGainRatio;
+                            settings.biasPre += (SampleType) r.biasPreDelta;
+                            settings.biasPost += (SampleType) r.biasPostDelta;
+                            settings.threshold += (SampleType) r.thresholdDelta;
+                            settings.mix += (SampleType) r.mixDelta;
+                        }
+                    }
+
+                    // The ramped kernels write back where every stream's settings ended up
+                    if (ramped && (fields[0][(size_t) s] != settings.drive || fields[1][(size_t) s] != settings.outGain
+                                   || fields[2][(size_t) s] != settings.biasPre || fields[3][(size_t) s] != settings.biasPost
+                                   || fields[4][(size_t) s] != settings.threshold || fields[5][(size_t) s] != settings.mix))
+                        result.passed = false;
+                }
+
+                // The padding past the last vector must be left alone
+                for (int i = 0; i < numSamples; ++i)
+                    for (int s = numStreams; s < frameStride; ++s)
+                        if (frames[(size_t) (i * frameStride + s)] != getInput (i, s))
+                            result.passed = false;
+            }
+        }
+
+        result.passed = result.passed && result.maxUlpError <= toleranceUlps;
+        return result;
+    }
+
+    //==============================================================================
+    /** Folds a 110 Hz sine through a stereo processor at 48 kHz, then automates drive from
+        0 to +12 dB and gives the table builder plenty of time before going on. Returns the
+        first channel, and the largest error of the tables the processor baked. */
+    std::vector<float> renderDriveChange (int type, bool useLut, float& lutError)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 32;
+
+        WavefolderProcessor processor;
+
+        const auto setParameter = [&processor] (const char* id, float value)
+        {
+            auto* param = processor.apvts.getParameter (id);
+            param->setValueNotifyingHost (param->convertTo0to1 (value));
+        };
+
+        setParameter (Parameters::wfTypeId, (float) type);
+        setParameter (Parameters::lutId, useLut ? 1.0f : 0.0f);
+
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (processor.getTotalNumOutputChannels(), blockSize);
+        juce::MidiBuffer midi;
+        std::vector<float> output;
+        double phase = 0.0;
+
+        const auto process = [&] (int numBlocks)
+        {
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                for (int i = 0; i < blockSize; ++i, phase += 110.0 / sampleRate)
+                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                        buffer.setSample (ch, i, 0.5f * (float) std::sin (juce::MathConstants<double>::twoPi * phase));
+
+                processor.processBlock (buffer, midi);
+                output.insert (output.end(), buffer.getReadPointer (0), buffer.getReadPointer (0) + blockSize);
+            }
+        };
+
+        // Start from a table of the initial settings, as a session that has been running would
+        process (1);
+        const auto timeout = juce::Time::getMillisecondCounter() + 10000;
+
+        while (useLut && ! processor.isLutReady() && juce::Time::getMillisecondCounter() < timeout)
+            juce::Thread::sleep (1);
+
+        process (10);
+        lutError = processor.getLutMaxError();
+
+        // The ramp is 20 ms, 30 blocks: one block in, the table of the target is long done
+        setParameter (Parameters::driveId, 12.0f);
+        process (1);
+        juce::Thread::sleep (500);
+        process (60);
+        lutError = std::max (lutError, processor.getLutMaxError());
+
+        processor.releaseResources();
+        return output;
+    }
+
+    CheckResult checkLutRamp()
+    {
+        CheckResult result;
+        const float unit = ulp (1.0f);
+
+        for (int type = 0; type < (int) std::size (allFoldTypes); ++type)
+        {
+            float lutError = 0.0f;
+            const auto exact = renderDriveChange (type, false, lutError);
+            const auto baked = renderDriveChange (type, true, lutError);
+
+            // Within what the table can be trusted to, on top of the kernels' own error
+            const float allowed = 2.0f * lutError + toleranceUlps * unit;
+
+            for (size_t i = 0; i < exact.size(); ++i)
+            {
+                const float error = std::abs (baked[i] - exact[i]);
+                result.add (error, unit);
+
+                if (! (error <= allowed))
+                    result.passed = false;
+            }
+        }
+
+        return result;
+    }
+
+    //==============================================================================
+    /** Prints one line per check, returns false if it failed. */
+    bool report (const char* isa, const char* precision, const char* check, const CheckResult& result)
+    {
+        std::cout << std::left << std::setw (8) << isa << std::setw (8) << precision << std::setw (10) << check
+                  << "max " << std::setw (8) << std::setprecision (3) << result.maxUlpError << " ulp  "
+                  << (result.passed ? "ok" : "FAILED") << std::endl;
+
+        return result.passed;
+    }
+
+    template <typename SampleType>
+    bool checkTable (const KernelTable& table)
+    {
+        const char* precision = std::is_same_v<SampleType, double> ? "double" : "float";
+
+        bool passed = report (table.name, precision, "static", checkStaticKernels<SampleType> (table));
+        passed = report (table.name, precision, "ramped", checkRampedKernels<SampleType> (table)) && passed;
+        passed = report (table.name, precision, "blended", checkBlendedKernels<SampleType> (table)) && passed;
+        passed = report (table.name, precision, "streams", checkStreamKernels<SampleType> (table)) && passed;
+        return passed;
+    }
+}
+
+//==============================================================================
+int main()
+{
+    // The processor needs a message manager, nothing pumps it
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    bool passed = report ("-", "double", "shapes", checkShapes());
+    passed = report ("-", "double", "adaa", checkAntiderivatives()) && passed;
+
+    for (auto isa : { Isa::scalar, Isa::sse2, Isa::avx2, Isa::avx512, Isa::neon })
+    {
+        if (const auto* table = getTable (isa))
+        {
+            passed = checkTable<float> (*table) && passed;
+            passed = checkTable<double> (*table) && passed;
+        }
+    }
+
+    passed = report ("-", "float", "lut ramp", checkLutRamp()) && passed;
+
+    if (! passed)
+    {
+        std::cerr << "Kernels differ from the reference by more than " << toleranceUlps << " ulp, or LUT mode steps" << std::endl;
+        return 1;
+    }
+
+    std::cout << "All kernels match the reference within " << toleranceUlps << " ulp, LUT mode follows the ramps" << std::endl;
+    return 0;
+}